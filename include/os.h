@@ -2,6 +2,7 @@
 
 #include "../os/OS_os.h"
 #include "../os/OS_Task.h"
+#include "../os/OS_Event.h"
 #include "../os/OS_Mutex.h"
 #include "../os/OS_Queue.h"
 #include "../os/OS_Reader.h"
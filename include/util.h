@@ -32,26 +32,35 @@
 #include "../util/Endian.h"
 #include "../util/Base64Decoder.h"
 #include "../util/Base64Encoder.h"
+#include "../util/Base64Stream.h"
 #include "../util/BinHex.h"
 #include "../util/uuid.h"
 
 #include "../util/MovingAverage.h"
+#include "../util/SlidingWindow.h"
 #include "../util/FIR.h"
+#include "../util/Biquad.h"
 #include "../util/Interpolator.h"
 #include "../util/Math.h"
 #include "../util/Sqrt.h"
 #include "../util/Variance.h"
 #include "../util/Fourier.h"
+#include "../util/Goertzel.h"
+#include "../util/SlidingDFT.h"
 
 #include "../util/LinearAlgebra.h"
 #include "../util/LeastSquaresEstimator.h"
 #include "../util/Kalman.h"
+#include "../util/SequentialKalman.h"
 
 #include "../util/LFSR.h"
 #include "../util/SHA1.h"
 #include "../util/CRC32.h"
 #include "../util/AES.h"
 #include "../util/AES256_wrapper.h"
+#include "../util/CTR.h"
+#include "../util/GCM.h"
+#include "../util/CipherStream.h"
 #include "../util/TEA.h"
 #include "../util/HMAC.h"
 
@@ -0,0 +1,9 @@
+/*
+ *  OS_Event.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "OS_Event.h"
@@ -0,0 +1,96 @@
+/*
+ *  OS_Event.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "base.h"
+#include "OS_os.h"
+
+namespace os {
+  /**
+   * An event that tasks wait for, signaled by tasks or interrupt handlers.
+   * A signal wakes up the first waiting task. Without any, it is remembered until the next wait().
+   * Interrupt handlers do not touch the OS lists: the event is queued, and signaled
+   * by the OS at the next scheduling point, or on leaving idle.
+   */
+  class Event: NoCopy {
+  public:
+    /**
+     * Creates a non signaled event
+     */
+    Event();
+    
+    /**
+     * Suspends the current task until the event is signaled.
+     * Returns at once if it was signaled since the last wait().
+     */
+    void wait();
+    
+    /**
+     * Signals the event, from a task
+     */
+    void signal();
+    
+    /**
+     * Signals the event from an interrupt handler, with interrupts disabled
+     */
+    void signal_from_interrupt();
+    
+    /**
+     * Driver callback calling signal_from_interrupt(), e.g. for hal::Serial
+     * @param event the Event to signal
+     */
+    static void interrupt_callback(void* event);
+    
+  private:
+    friend class OS;
+    
+    bool m_signaled;
+    OS::task_queue_type m_waiters;
+    
+    volatile bool m_irq_signaled;  // queued in the OS
+    Event* m_irq_succ;
+  };
+  
+  inline
+  Event::Event() : m_signaled(false), m_irq_signaled(false), m_irq_succ(0) {
+  }
+  
+  inline
+  void Event::wait() {
+    if (!m_signaled) {
+      // The signal is consumed by the one waking us up
+      OS::suspend(m_waiters);
+      return;
+    }
+    m_signaled = false;
+  }
+  
+  inline
+  void Event::signal() {
+    TaskBase* task = m_waiters.get_head();
+    if (task != 0)
+      OS::wakeup(task);
+    else
+      m_signaled = true;
+  }
+  
+  inline
+  void Event::signal_from_interrupt() {
+    if (m_irq_signaled)
+      return;
+    m_irq_signaled = true;
+    m_irq_succ = OS::m_irq_events;
+    OS::m_irq_events = this;
+  }
+  
+  inline
+  void Event::interrupt_callback(void* event) {
+    static_cast<Event*>(event)->signal_from_interrupt();
+  }
+}
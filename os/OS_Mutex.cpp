@@ -9,3 +9,77 @@
 
 #include "OS_Mutex.h"
 
+namespace os {
+  void Mutex::acquire() {
+    TaskBase* current = OS::get_current();
+    if (m_owner == current) {
+      ++m_nesting;
+      return;
+    }
+    if (m_owner == 0) {
+      take(current);
+      return;
+    }
+    
+    // Lend our priority down the chain of owners
+    const TaskBase::Priority priority = current->m_priority;
+    for (Mutex* mutex = this; mutex != 0; mutex = mutex->m_owner->m_waiting_for) {
+      if (mutex->m_owner->m_priority >= priority)
+        break;
+      OS::set_priority(mutex->m_owner, priority);
+    }
+    
+    // Wait to be handed over the mutex
+    current->m_waiting_for = this;
+    while (m_owner != current)
+      OS::suspend(m_waiters);
+  }
+  
+  bool Mutex::release() {
+    if (m_owner == 0) {
+      // Nothing to do
+      return false;
+    }
+    if (--m_nesting > 0) {
+      // Was recursively acquired
+      return false;
+    }
+    
+    TaskBase* owner = m_owner;
+    Mutex** link = &owner->m_mutexes;
+    while (*link != this)
+      link = &(*link)->m_held_succ;
+    *link = m_held_succ;
+    m_owner = 0;
+    
+    // Hand over to the first waiter, which wakeup() takes off the list
+    TaskBase* next = m_waiters.get_head();
+    if (next != 0) {
+      next->m_waiting_for = 0;
+      OS::wakeup(next);
+      take(next);
+    }
+    
+    // Give up what was inherited through this mutex
+    update_priority(owner);
+    return true;
+  }
+  
+  void Mutex::take(TaskBase* task) {
+    m_owner = task;
+    m_nesting = 1;
+    m_held_succ = task->m_mutexes;
+    task->m_mutexes = this;
+    update_priority(task);
+  }
+  
+  void Mutex::update_priority(TaskBase* task) {
+    TaskBase::Priority priority = task->m_base_priority;
+    for (const Mutex* mutex = task->m_mutexes; mutex != 0; mutex = mutex->m_held_succ) {
+      const TaskBase::Priority inherited = mutex->get_priority();
+      if (inherited > priority)
+        priority = inherited;
+    }
+    OS::set_priority(task, priority);
+  }
+}
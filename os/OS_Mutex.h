@@ -10,20 +10,27 @@
 #pragma once
 
 #include "base.h"
-#include "OS.h"
+#include "OS_os.h"
 
 namespace os {
   /**
    * Mutual exclusion object. Has two states, free or acquired.
    * Can be acquired once at a time only.
    * The owner task can recursively acquire it. Only the last release() will free the mutex
+   *
+   * Tasks wait for the mutex in priority order, and the last release() hands it over
+   * to the first of them. Meanwhile, the owner inherits the priority of that task,
+   * and the owners of the mutexes it waits for in turn, so that a lower priority owner
+   * cannot stall it behind tasks of middling priority.
+   * A priority ceiling can also be set: the owner then runs at least at that priority.
    */
   class Mutex: NoCopy {
   public:
     /**
      * Creates a free mutex
+     * @param ceiling the priority the owner is raised to, none by default
      */
-    Mutex();
+    explicit Mutex(TaskBase::Priority ceiling = TaskBase::PRIORITY_IDLE);
     
     /**
      * Destroys the mutex
@@ -48,15 +55,31 @@ namespace os {
     bool release();
     
   private:
+    /**
+     * Makes a task the owner
+     */
+    void take(TaskBase* task);
+    
+    /**
+     * @return the priority the owner inherits from this mutex
+     */
+    TaskBase::Priority get_priority() const;
+    
+    /**
+     * Sets the priority of a task from the one it was created with and the mutexes it holds
+     */
+    static void update_priority(TaskBase* task);
+    
     TaskBase *m_owner;
     uint32 m_nesting;
+    const TaskBase::Priority m_ceiling;
     
-    typedef util::List<TaskBase> task_queue_type;
-    static task_queue_type m_waiters;
+    OS::task_queue_type m_waiters;
+    Mutex *m_held_succ;  // next mutex held by the owner
   };
   
   inline
-  Mutex::Mutex() : m_owner(0), m_nesting(0) {
+  Mutex::Mutex(TaskBase::Priority ceiling) : m_owner(0), m_nesting(0), m_ceiling(ceiling), m_held_succ(0) {
   }
   
   inline
@@ -65,44 +88,24 @@ namespace os {
   
   inline
   bool Mutex::try_acquire() {
-    if (m_owner != 0 && m_owner != OS::get_current()) {
+    TaskBase* current = OS::get_current();
+    if (m_owner == current) {
+      ++m_nesting;
+      return true;
+    }
+    if (m_owner != 0) {
       // Not available
       return false;
-    }    
-    m_owner = OS::get_current();
-    ++m_nesting;
-  }
-  
-  inline
-  void Mutex::acquire() {
-    if (m_owner != 0 && m_owner != OS::get_current()) {
-      // Add the task to the list of waiters for this mutex and suspend
-      m_waiters.add_tail(OS::get_current());
-      OS::suspend();
     }
-    m_owner = OS::get_current();
-    ++m_nesting;
+    take(current);
+    return true;
   }
   
   inline
-  bool Mutex::release() {
-    if (m_owner == 0) {
-      // Nothing to do
-      return false;
-    }
-    if (--m_nesting > 0) {
-      // Was recursively acquired
-      return false;
-    }
-    
-    // Wakeup first waiter
-    m_owner = m_waiters.remove_head();
-    
-    if (m_owner != 0) {
-      // Wake him up!
-      OS::wakeup(m_owner);
-    }
-    
-    return true;
+  TaskBase::Priority Mutex::get_priority() const {
+    const TaskBase* waiter = m_waiters.get_head();
+    if (waiter != 0 && waiter->m_priority > m_ceiling)
+      return waiter->m_priority;
+    return m_ceiling;
   }
 }
@@ -10,9 +10,10 @@
 #pragma once
 
 #include "base.h"
+#include "OS_os.h"
 
 namespace os {
-  
+
   /**
    * A queue with typed objects.
    * A task trying to post to a queue that is full, or to receive from an empty
@@ -21,30 +22,192 @@ namespace os {
    * Objects stored by the queue are copied bytewise by value, so only small objects
    * may be stored. No deep-copy is performed, nor any copy constructor is called,
    * so objects with deep-copy semantics should not be used with this queue.
+   * Large objects are better written in place, between reserve() and commit().
+   *
+   * The N slots are allocated within the queue. Blocked tasks wait in one list for
+   * the producers, one for the consumers: each item posted wakes up the first consumer,
+   * each item received the first producer.
+   * Timeouts need the OS timer, see OS::set_timer(). The queue is for tasks only,
+   * not interrupt handlers.
    */
-  template <typename T, uint32 N> class Queue {
+  template <typename T, uint32 N> class Queue: NoCopy {
   public:
+    typedef T value_type;
+    typedef uint32 size_type;
+
+    static const uint32 capacity = N;
+
+    /**
+     * The wait time for blocking until the action is possible
+     */
+    static const uint32 WAIT_FOREVER = 0xFFFFFFFF;
+
     Queue();
-    
+
     /**
      * Posts an item to the queue, possibly blocking for at most
      * waitTimeMs until a slot becomes available
      * @return true if the item was posted
      */
-    bool put(const T& item, uint32 waitTimeMs);
-    
+    bool put(const T& item, uint32 waitTimeMs = WAIT_FOREVER);
+
     /**
      * Gets an item from the queue, possibly blocking for at most
      * waitTimeMs until available
      * return true if the item was received
      */
-    bool get(T& item, uint32 waitTimeMs);
-    
+    bool get(T& item, uint32 waitTimeMs = WAIT_FOREVER);
+
+    /**
+     * Reserves the slot of the next item, possibly blocking for at most
+     * waitTimeMs until one becomes available, for the item to be written in place.
+     * Other producers block until the item is posted by commit().
+     * @return the slot, 0 if none became available
+     */
+    T* reserve(uint32 waitTimeMs = WAIT_FOREVER);
+
+    /**
+     * Posts the item written in the reserved slot
+     */
+    void commit();
+
     /**
      * @return the number of item currently in the queue
      */
     uint32 size() const;
-    
+
   private:
+    bool has_room() const {
+      return !m_reserved && m_size < N;
+    }
+
+    /**
+     * Waits until has_room()
+     * @return false if timed out
+     */
+    bool wait_for_room(uint32 waitTimeMs);
+
+    /**
+     * Waits until there is an item
+     * @return false if timed out
+     */
+    bool wait_for_item(uint32 waitTimeMs);
+
+    /**
+     * Wakes up the first task of a wait list, if any
+     */
+    static void wakeup_first(OS::task_queue_type& waiters) {
+      TaskBase* task = waiters.get_head();
+      if (task != 0)
+        OS::wakeup(task);
+    }
+
+    /**
+     * @return the slot after the given one
+     */
+    static size_type next(size_type slot) {
+      return slot + 1 == N ? 0 : slot + 1;
+    }
+
+    T m_items[N];
+    size_type m_put, m_get;
+    size_type m_size;
+    bool m_reserved;
+
+    OS::task_queue_type m_producers;
+    OS::task_queue_type m_consumers;
   };
+
+  template <typename T, uint32 N>
+  inline
+  Queue<T, N>::Queue() : m_put(0), m_get(0), m_size(0), m_reserved(false) {
+  }
+
+  template <typename T, uint32 N>
+  bool Queue<T, N>::put(const T& item, uint32 waitTimeMs) {
+    if (!wait_for_room(waitTimeMs))
+      return false;
+
+    m_items[m_put] = item;
+    m_put = next(m_put);
+    ++m_size;
+    wakeup_first(m_consumers);
+    return true;
+  }
+
+  template <typename T, uint32 N>
+  bool Queue<T, N>::get(T& item, uint32 waitTimeMs) {
+    if (!wait_for_item(waitTimeMs))
+      return false;
+
+    item = m_items[m_get];
+    m_get = next(m_get);
+    --m_size;
+    wakeup_first(m_producers);
+    return true;
+  }
+
+  template <typename T, uint32 N>
+  T* Queue<T, N>::reserve(uint32 waitTimeMs) {
+    if (!wait_for_room(waitTimeMs))
+      return 0;
+
+    m_reserved = true;
+    return &m_items[m_put];
+  }
+
+  template <typename T, uint32 N>
+  void Queue<T, N>::commit() {
+    m_reserved = false;
+    m_put = next(m_put);
+    ++m_size;
+    wakeup_first(m_consumers);
+    // The producers were also held back by the reservation
+    if (m_size < N)
+      wakeup_first(m_producers);
+  }
+
+  template <typename T, uint32 N>
+  inline
+  uint32 Queue<T, N>::size() const {
+    return m_size;
+  }
+
+  template <typename T, uint32 N>
+  bool Queue<T, N>::wait_for_room(uint32 waitTimeMs) {
+    if (has_room())
+      return true;
+    if (waitTimeMs == 0)
+      return false;
+
+    // Another producer may have taken the slot it was woken up for
+    const bool forever = waitTimeMs == WAIT_FOREVER;
+    const uint32 date = forever ? 0 : OS::get_time() + OS::ms_to_ticks(waitTimeMs);
+    do {
+      if (forever)
+        OS::suspend(m_producers);
+      else if (!OS::suspend_until(m_producers, date))
+        return has_room();
+    } while (!has_room());
+    return true;
+  }
+
+  template <typename T, uint32 N>
+  bool Queue<T, N>::wait_for_item(uint32 waitTimeMs) {
+    if (m_size > 0)
+      return true;
+    if (waitTimeMs == 0)
+      return false;
+
+    // Another consumer may have taken the item it was woken up for
+    const bool forever = waitTimeMs == WAIT_FOREVER;
+    const uint32 date = forever ? 0 : OS::get_time() + OS::ms_to_ticks(waitTimeMs);
+    do {
+      if (forever)
+        OS::suspend(m_consumers);
+      else if (!OS::suspend_until(m_consumers, date))
+        return m_size > 0;
+    } while (m_size == 0);
+    return true;
+  }
 }
@@ -11,12 +11,15 @@
 
 #include "base.h"
 #include "OS_os.h"
+#include "OS_Event.h"
 namespace os {
   /**
    * This class implements a blocking reader.
    * The template must support this function
    * bool get(char& c)
-   * The read() function can be blocking or non blocking
+   * The read() function can be blocking or non blocking.
+   * A blocked reader waits for the event signaled by the IO when data comes in,
+   * e.g. by hal::Serial in interrupt mode, or else keeps yielding.
    */
   template <class IO>
   class Reader : NoCopy {
@@ -27,7 +30,7 @@ namespace os {
       NON_BLOCKING
     };
     
-    Reader(IO& io) : m_io(io), m_peek_char(0), m_blocking_mode(BLOCKING) {
+    Reader(IO& io, Event* event = 0) : m_io(io), m_peek_char(0), m_blocking_mode(BLOCKING), m_event(event) {
     }
     
     void set_mode(BlockingMode blocking_mode) {
@@ -44,7 +47,7 @@ namespace os {
         const uint32 bytes_read_this_turn = m_io.read(bytes + bytes_read, count - bytes_read);
         if (bytes_read_this_turn == 0) {
           if (m_blocking_mode == BLOCKING)
-            os::OS::yield();
+            wait();
           else
             break;
         }
@@ -64,7 +67,7 @@ namespace os {
       }
       // Get it from the device
       while ( !m_io.get(c) )
-        OS::yield();
+        wait();
       
       // Remember the character and mark it as peeked
       m_peek_char = c | PEEK_MASK;
@@ -80,7 +83,7 @@ namespace os {
         return;
       } 
       while ( !m_io.get(c) )
-        OS::yield();
+        wait();
     }
     
     /**
@@ -134,6 +137,17 @@ namespace os {
     }
     
   private:
+    /**
+     * Waits for data. Before OS::start() or within a critical section, the event
+     * cannot be waited for: the IO is polled again.
+     */
+    void wait() {
+      if (m_event != 0 && OS::can_block())
+        m_event->wait();
+      else
+        OS::yield();
+    }
+    
     IO& m_io;
     /**
      * We remember a single peeked character here. It is marked with PEEK_MASK when peeked.
@@ -142,5 +156,6 @@ namespace os {
     uint32 m_peek_char;
     
     BlockingMode m_blocking_mode;
+    Event* m_event;
   };  
 }
@@ -13,6 +13,7 @@
 #include "util.h"
 
 namespace os {
+  class Mutex;
   
   /**
    * Any task will have to inherit this class, and supply a run() member function.
@@ -22,12 +23,14 @@ namespace os {
     
   public:
     /**
-     * Priority 0 is the lowest priority, same as the idle task. Highest is 5
+     * Priority 0 is the lowest priority, same as the idle task. Highest is 5.
+     * The OS runs the ready task with the highest priority, in turn with those of the same priority.
      */
     typedef uint8 Priority;
     static const Priority PRIORITY_IDLE = 0;
     static const Priority PRIORITY_DEFAULT = 2;
     static const Priority PRIORITY_HIGHEST = 5;
+    static const uint32 NB_PRIORITIES = PRIORITY_HIGHEST + 1;
     
     static const uint32 STACKSIZE_DEFAULT = 256;
     
@@ -36,7 +39,8 @@ namespace os {
      */
     enum State {
       RUN = 'R',
-      SUSPENDED = 'S'
+      SUSPENDED = 'S',
+      DELAYED = 'D'
     };
     
     /**
@@ -49,15 +53,33 @@ namespace os {
     bool operator !=(const TaskBase& task) const {
       return this != &task;
     }
+    
+    /**
+     * @return this task's priority, raised while it holds a mutex that a higher
+     *         priority task waits for
+     */
+    Priority get_priority() const {
+      return m_priority;
+    }
+    
+    /**
+     * @return the priority this task was created with
+     */
+    Priority get_base_priority() const {
+      return m_base_priority;
+    }
 
   protected:
     /**
      * Constructor. Task is created in the RUN state.
      * @param stack_size the size of the stack in words (=4 bytes)
+     * @param priority from PRIORITY_IDLE to PRIORITY_HIGHEST
      */
-    TaskBase(const char* task_name, uint32 *stack, uint32 stack_size) 
-    : m_task_name(task_name), m_state(RUN), m_priority(PRIORITY_DEFAULT), 
-    m_stack(stack), m_stack_pointer(stack + stack_size - 1), m_stack_size(stack_size) {
+    TaskBase(const char* task_name, uint32 *stack, uint32 stack_size, Priority priority = PRIORITY_DEFAULT) 
+    : m_task_name(task_name), m_state(RUN), m_priority(priority > PRIORITY_HIGHEST ? PRIORITY_HIGHEST : priority), 
+    m_base_priority(m_priority), 
+    m_stack(stack), m_stack_pointer(stack + stack_size - 1), m_stack_size(stack_size),
+    m_deadline(0), m_delay_succ(0), m_queue(0), m_mutexes(0), m_waiting_for(0) {
       tag_stack();
     }
     
@@ -74,11 +96,13 @@ namespace os {
      * Give access to the OS
      */
     friend class OS;
+    friend class Mutex;
     
     /**
      * Special constructor for task 0
      */
-    TaskBase(): m_task_name("MAIN"), m_state(RUN), m_priority(PRIORITY_DEFAULT), m_stack(0), m_stack_pointer(0), m_stack_size(0) {
+    TaskBase(): m_task_name("MAIN"), m_state(RUN), m_priority(PRIORITY_DEFAULT), m_base_priority(PRIORITY_DEFAULT), m_stack(0), m_stack_pointer(0), m_stack_size(0),
+    m_deadline(0), m_delay_succ(0), m_queue(0), m_mutexes(0), m_waiting_for(0) {
     }
     
     /**
@@ -136,7 +160,8 @@ namespace os {
     const char* m_task_name;
     State m_state;
     
-    const Priority m_priority;
+    Priority m_priority;
+    const Priority m_base_priority;
     
     const uint32 *m_stack;
     const uint32 *m_stack_pointer;
@@ -152,6 +177,23 @@ namespace os {
     TaskBase *m_pred;
     TaskBase *m_succ;
     
+    /**
+     * A DELAYED task is also in the OS delay queue, sorted by deadline
+     */
+    uint32 m_deadline;
+    TaskBase *m_delay_succ;
+    
+    /**
+     * The list a task that is not ready waits in
+     */
+    util::List<TaskBase> *m_queue;
+    
+    /**
+     * The mutexes held, last acquired first, and the one waited for
+     */
+    Mutex *m_mutexes;
+    Mutex *m_waiting_for;
+    
   private:
 
     /**
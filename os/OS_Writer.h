@@ -12,6 +12,7 @@
 #include "base.h"
 #include "util.h" // For Q<N>
 #include "OS_os.h"
+#include "OS_Event.h"
 
 namespace os {
   /**
@@ -19,6 +20,8 @@ namespace os {
    * The template must support this function
    * bool put(char& c).
    * The write() function can be non blocking.
+   * A blocked writer waits for the event signaled by the IO when there is room,
+   * e.g. by hal::Serial in interrupt mode, or else keeps yielding.
    */
   template <class IO>
   class Writer : NoCopy {
@@ -30,7 +33,8 @@ namespace os {
       NON_BLOCKING
     };
     
-    Writer(IO& io, BlockingMode blocking_mode = BLOCKING) : m_io(io), m_blocking_mode(blocking_mode) {
+    Writer(IO& io, BlockingMode blocking_mode = BLOCKING, Event* event = 0)
+    : m_io(io), m_blocking_mode(blocking_mode), m_event(event) {
     }
     
     /**
@@ -44,7 +48,7 @@ namespace os {
         const uint32 bytes_sent_this_turn = m_io.write(bytes + bytes_sent, count - bytes_sent);
         if (bytes_sent_this_turn == 0) {
           if (m_blocking_mode == BLOCKING)
-            os::OS::yield();
+            wait();
           else 
             break;
         }
@@ -58,7 +62,7 @@ namespace os {
      */
     void put(char c) {
       while (m_io.write(reinterpret_cast<const uint8*> (&c), 1) != 1)
-        os::OS::yield();
+        wait();
     }
     
     /**
@@ -71,7 +75,7 @@ namespace os {
       while (bytes_sent < count) {
         const uint32 bytes_sent_this_turn = m_io.write(reinterpret_cast<const uint8*>(v) + bytes_sent, count - bytes_sent);
         if (bytes_sent_this_turn == 0)
-          OS::yield();
+          wait();
         bytes_sent += bytes_sent_this_turn;
       }
     }
@@ -177,7 +181,20 @@ namespace os {
     }
     
   private:    
+    /**
+     * Waits for room. The event is only waited for once the OS runs tasks:
+     * boot messages written before OS::start(), or a write within a critical
+     * section, keep polling the IO.
+     */
+    void wait() {
+      if (m_event != 0 && OS::can_block())
+        m_event->wait();
+      else
+        OS::yield();
+    }
+    
     IO& m_io;
     BlockingMode m_blocking_mode;
+    Event* m_event;
   };
 }
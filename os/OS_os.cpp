@@ -8,21 +8,30 @@
  */
 
 #include "OS_os.h"
+#include "OS_Event.h"
 #include "../platform/HAL_Processor.h"
 
 
 namespace os {
   uint32 OS::m_task_num = 1;
 
-  OS::task_queue_type OS::m_run_queue;
+  OS::task_queue_type OS::m_ready[TaskBase::NB_PRIORITIES];
+  uint32 OS::m_ready_bitmap = 0;
   OS::task_queue_type OS::m_sleep_queue;
-  OS::task_queue_type::iterator OS::m_current_task(0);
+  TaskBase* OS::m_current_task = 0;
+  TaskBase* OS::m_delay_queue = 0;
+  
+  hal::Timer* OS::m_timer = 0;
+  hal::Timer::MatchChannel OS::m_match_channel = hal::Timer::MATCH0;
+  volatile bool OS::m_timer_fired = false;
+  Event* volatile OS::m_irq_events = 0;
 
   TaskBase OS::m_task_main;
   
   bool OS::m_started = false;
   uint32 OS::m_critical = 0;
   
+#if defined(__arm__)
   static void switch_context(void* from, void* to) __attribute__((naked));
   static void switch_context(void* from, void* to) {
 #ifdef __GNUC__
@@ -65,19 +74,30 @@ namespace os {
 #  error Compiler not yet supported
 #endif
   }
+#else
+  /**
+   * Host builds, for the tests and benchmarks: the program supplies the switch,
+   * which starts a task by calling entry(task) the first time it switches to it
+   */
+  void host_switch_context(TaskBase* from, TaskBase* to, void (*entry)(TaskBase*));
+#endif
 
   void OS::init_tasks() {
     //out << "OS: init_tasks, " << m_task_num << " tasks\n";
-    m_run_queue.add_head(&m_task_main);
+    m_ready[m_task_main.m_priority].add_head(&m_task_main);
+    m_ready_bitmap |= 1 << m_task_main.m_priority;
     //out << "OS: done setup task 0\n";
-    for (task_queue_type::iterator t = m_run_queue.begin(); t != m_run_queue.end(); ++t) {
-      if ((*t) != m_task_main)
-        init_task(&(*t));
+    for (uint32 p = 0; p < TaskBase::NB_PRIORITIES; ++p) {
+      for (task_queue_type::iterator t = m_ready[p].begin(); t != m_ready[p].end(); ++t) {
+        if ((*t) != m_task_main)
+          init_task(&(*t));
+      }
     }
-    m_current_task = m_run_queue.begin();
+    m_current_task = &m_task_main;
   }
   
   void OS::init_task(TaskBase *task) {
+#if defined(__arm__)
     //out << "OS: init_task(" << task_num << ")\n";
     const uint32 cpsr = hal::Processor::get_cpsr();
     //out << "OS: cpsr is " << cpsr << "\n";
@@ -94,30 +114,43 @@ namespace os {
     regs.sp = const_cast<uint32*>(stack_end);
     // setup the cpsr
     regs.cpsr = cpsr;
+#endif
   }
   
-  void OS::suspend() {
-    TaskBase *task = &*m_current_task;
-    // Remember this task's registers
-    TaskBase::task_regs& current_task_regs = (*m_current_task).m_task_regs;
+  void OS::switch_to(TaskBase* next) {
+    TaskBase* current = m_current_task;
+    m_current_task = next;
+    // Perform the switch...
+#if defined(__arm__)
+    switch_context(&current->m_task_regs, &next->m_task_regs);
+#else
+    host_switch_context(current, next, &TaskBase::top);
+#endif
+  }
+  
+  void OS::block(TaskBase::State state, task_queue_type& wait_list) {
+    TaskBase *task = m_current_task;
 
     // Mark it as sleeping
-    (*m_current_task).set_state(TaskBase::SUSPENDED);
+    task->set_state(state);
     
-    // Choose the next task
-    ++m_current_task;
-    
-    if (!m_current_task)
-      m_current_task = m_run_queue.begin();
-
-
-    // Move the task from the RUN to the SLEEP queue
-    m_run_queue.remove(task);
-    m_sleep_queue.add_head(task);
+    // Move the task from the RUN queue to the wait list
+    make_unready(task);
+    add_by_priority(wait_list, task);
+    task->m_queue = &wait_list;
         
-    TaskBase::task_regs& next_task_regs = (*m_current_task).m_task_regs;
-    // Perform the switch...
-    switch_context(&current_task_regs, &next_task_regs);
+    // Choose the next task, which is this one again if it was woken up while idling
+    TaskBase* next = schedule();
+    if (next != task)
+      switch_to(next);
+  }
+  
+  void OS::suspend() {
+    block(TaskBase::SUSPENDED, m_sleep_queue);
+  }
+  
+  void OS::suspend(task_queue_type& wait_list) {
+    block(TaskBase::SUSPENDED, wait_list);
   }
   
   void OS::wakeup(TaskBase* task) {
@@ -126,12 +159,16 @@ namespace os {
       return;
     }
     
+    if (task->get_state() == TaskBase::DELAYED)
+      remove_delayed(task);
+    
     // Put it in the run state
     task->set_state(TaskBase::RUN);
     
-    // Remove from sleep queue and put at the tail of the run queue
-    m_sleep_queue.remove(task);
-    m_run_queue.add_tail(task);
+    // Remove from its wait list and put at the tail of its ready list
+    task->m_queue->remove(task);
+    task->m_queue = 0;
+    make_ready(task);
   }
   
   void OS::yield() {
@@ -140,19 +177,138 @@ namespace os {
     if (m_critical > 0)
       return;
     
-    //out << "OS: yield current task " << m_current_task_index << ", " << m_task_num << " tasks\n";
-    // Remember this task's registers
-    TaskBase::task_regs& current_task_regs = (*m_current_task).m_task_regs;
+    // Round-robin within the priority: the current task goes behind its peers
+    TaskBase* current = m_current_task;
+    task_queue_type& level = m_ready[current->m_priority];
+    level.remove(current);
+    level.add_tail(current);
     
     // Choose the next task
-    ++m_current_task;
+    TaskBase* next = schedule();
+    if (next != current)
+      switch_to(next);
+  }
+  
+  void OS::set_timer(hal::Timer& timer, hal::Timer::MatchChannel channel) {
+    m_timer = &timer;
+    m_match_channel = channel;
+  }
+  
+  void OS::sleep_until(uint32 date) {
+    if (!m_started) {
+      // No other task to run
+      while (is_before(get_time(), date))
+        ;
+      return;
+    }
+    suspend_until(m_sleep_queue, date);
+  }
+  
+  bool OS::suspend_until(task_queue_type& wait_list, uint32 date) {
+    if (!is_before(get_time(), date))
+      return false;
     
-    if (!m_current_task)
-      m_current_task = m_run_queue.begin();
+    m_current_task->m_deadline = date;
+    add_delayed(m_current_task);
+    block(TaskBase::DELAYED, wait_list);
+    return is_before(get_time(), date);
+  }
+  
+  void OS::signal_irq_events() {
+    for (;;) {
+      // Interrupt handlers push on the list
+      hal::Processor::disable_interrupts();
+      Event* event = m_irq_events;
+      if (event != 0) {
+        m_irq_events = event->m_irq_succ;
+        event->m_irq_signaled = false;
+      }
+      hal::Processor::enable_interrupts();
+      
+      if (event == 0)
+        return;
+      event->signal();
+    }
+  }
+  
+  TaskBase* OS::schedule() {
+    for (;;) {
+      if (m_irq_events != 0)
+        signal_irq_events();
+      if (m_delay_queue != 0) {
+        const uint32 now = get_time();
+        while (m_delay_queue != 0 && !is_before(now, m_delay_queue->m_deadline))
+          wakeup(m_delay_queue);
+      }
+      if (m_ready_bitmap != 0)
+        return get_next();
+      idle();
+    }
+  }
+  
+  void OS::idle() {
+    m_timer_fired = false;
+    // Masked from the match on: setting it is a read-modify-write of the timer match
+    // control, which would undo the changes of an interrupt handler in between.
+    // An interrupt pending while masked still ends the idle mode, to be serviced once unmasked
+    hal::Processor::disable_interrupts();
+    bool ahead = true;
+    if (m_delay_queue != 0) {
+      const uint32 deadline = m_delay_queue->m_deadline;
+      m_timer->match(m_match_channel, deadline, &on_timer_match);
+      // The deadline may have passed before the match was set
+      ahead = is_before(get_time(), deadline);
+    }
     
-    TaskBase::task_regs& next_task_regs = (*m_current_task).m_task_regs;
-
-    // Perform the switch...
-    switch_context(&current_task_regs, &next_task_regs);
-  }  
+    if (ahead && !m_timer_fired && m_irq_events == 0)
+      hal::Processor::idle();
+    hal::Processor::enable_interrupts();
+  }
+  
+  uint32 OS::on_timer_match(hal::Timer& timer, hal::Timer::MatchChannel channel,
+                            const hal::Timer::MatchInfo& info) {
+    // The next match is set when idling again
+    timer.stop_match(channel);
+    m_timer_fired = true;
+    return info.value;
+  }
+  
+  void OS::set_priority(TaskBase* task, TaskBase::Priority priority) {
+    if (task->m_priority == priority)
+      return;
+    
+    if (task->get_state() == TaskBase::RUN) {
+      make_unready(task);
+      task->m_priority = priority;
+      make_ready(task);
+    } else {
+      task_queue_type& wait_list = *task->m_queue;
+      wait_list.remove(task);
+      task->m_priority = priority;
+      add_by_priority(wait_list, task);
+    }
+  }
+  
+  void OS::add_by_priority(task_queue_type& wait_list, TaskBase* task) {
+    TaskBase* position = wait_list.get_head();
+    while (position != 0 && position->m_priority >= task->m_priority)
+      position = position->m_succ;
+    wait_list.insert_before(position, task);
+  }
+  
+  void OS::add_delayed(TaskBase* task) {
+    TaskBase** link = &m_delay_queue;
+    while (*link != 0 && !is_before(task->m_deadline, (*link)->m_deadline))
+      link = &(*link)->m_delay_succ;
+    task->m_delay_succ = *link;
+    *link = task;
+  }
+  
+  void OS::remove_delayed(TaskBase* task) {
+    TaskBase** link = &m_delay_queue;
+    while (*link != task)
+      link = &(*link)->m_delay_succ;
+    *link = task->m_delay_succ;
+    task->m_delay_succ = 0;
+  }
 }
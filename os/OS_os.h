@@ -12,16 +12,28 @@
 #include "base.h"
 #include "util.h"
 #include "OS_Task.h"
+#include "../platform/HAL_Timer.h"
 
 namespace  os {
+  class Event;
   
   /**
    * A non-preemptive, cooperative multitasking OS.
    * The code starting the OS is deemed task #0.
-   * 
+   * Ready tasks are kept in one list per priority, with a bitmap of the non-empty lists:
+   * the next task to run is the head of the highest priority list, found in constant time.
+   * Tasks of the same priority run round-robin; lower priorities only run when no
+   * higher priority task is ready.
+   * Time is kept by a hal::Timer: tasks sleeping till a date leave the ready lists
+   * for a queue sorted by deadline, and are made ready at the first scheduling point past it.
+   * When no task is ready, the CPU idles until an interrupt, the timer match
+   * set for the earliest deadline being one.
+   * Wait lists are kept in priority order, first come first served within a priority.
    */
   class OS: NoInstance {
   public:
+    typedef util::List<TaskBase> task_queue_type;
+    
     /**
      * Adds a task to the OS
      */
@@ -38,7 +50,7 @@ namespace  os {
     static TaskBase* get_current();
     
     /**
-     * Tries to give control to another task.
+     * Tries to give control to another task: the next one of the highest ready priority.
      */
     static void yield();
     
@@ -48,10 +60,34 @@ namespace  os {
     static void suspend();
     
     /**
-     * Wakes up a sleeping task
+     * Suspends the current task in a wait list, until woken up.
+     * The task is taken off the list when woken up.
+     * The list is ordered by priority, then by arrival.
+     */
+    static void suspend(task_queue_type& wait_list);
+    
+    /**
+     * Suspends the current task in a wait list, until woken up or the date.
+     * The task is taken off the list either way.
+     * @param date in ticks of the OS timer, less than 2^31 ticks away
+     * @return false if the date is past
+     */
+    static bool suspend_until(task_queue_type& wait_list, uint32 date);
+    
+    /**
+     * Wakes up a sleeping task. It runs at the next yield or suspend, ahead of
+     * the ready tasks of lower priority.
      */
     static void wakeup(TaskBase* task);
     
+    /**
+     * @return true if the current task may block: the OS is started and no critical section is open.
+     * Otherwise a blocking call would switch tasks, or find no task to switch from.
+     */
+    static bool can_block() {
+      return m_started && m_critical == 0;
+    }
+    
     /**
      * Critical section entry.
      * Entries can be nested
@@ -80,23 +116,35 @@ namespace  os {
     //static void leaveCriticalSection();
     
     /**
-     * @return the number of milliseconds since the scheduler started
+     * Sets the timer the OS keeps time with, and the match channel waking up sleeping tasks.
+     * The timer must have been configured, at a rate multiple of 1kHz, and started.
+     * Its other channels remain available.
+     */
+    static void set_timer(hal::Timer& timer, hal::Timer::MatchChannel channel);
+    
+    /**
+     * @return the current date, in ticks of the OS timer
+     */
+    static uint32 get_time();
+    
+    /**
+     * @return the number of OS timer ticks in a duration
      */
-    //static uint32 getElapsedTimeMs();
+    static uint32 ms_to_ticks(uint32 ms);
     
     /**
-     * Sleeps the calling task for N milliseconds.
-     * Note that the delay can be at most 2^32 - 1 milliseconds, that is,
-     * a bit more than 49 days.
+     * Sleeps the calling task until a date. Dates wrap around: the date must
+     * be less than 2^31 ticks away. For a periodic task:
+     *   date += OS::ms_to_ticks(period); OS::sleep_until(date);
+     * A wakeup() ends the sleep early.
+     * @param date in ticks of the OS timer
      */
-    //static void delayMs(uint32 delay);
+    static void sleep_until(uint32 date);
     
     /**
-     * Sleeps the calling task until a fixed date
-     * @param ref the time at which the duration starts
-     * @param delayMs the delay, starting at delayRef
+     * Sleeps the calling task for a duration
      */
-    //static void delayUntilMs(uint32 &ref, uint32 delay);
+    static void sleep_for(uint32 ms);
     
     /**
      * @return the number of tasks in the OS
@@ -106,13 +154,15 @@ namespace  os {
     template <class WRITER>
     static WRITER& dump(WRITER& os) {
       os << "TASKS: " << m_task_num << "\n";
-      for (task_queue_type::iterator t = m_run_queue.begin(); t != m_run_queue.end(); ++t) {
-        os << "R-" << (*t).get_name() <<  ": "
-        << "stack(" << (*t).get_stack_usage() 
-        << "/" << (*t).get_stack_size() << ")" << "\n";
+      for (uint32 p = TaskBase::NB_PRIORITIES; p-- > 0;) {
+        for (task_queue_type::iterator t = m_ready[p].begin(); t != m_ready[p].end(); ++t) {
+          os << "R" << p << "-" << (*t).get_name() <<  ": "
+          << "stack(" << (*t).get_stack_usage() 
+          << "/" << (*t).get_stack_size() << ")" << "\n";
+        }
       }
       for (task_queue_type::iterator t = m_sleep_queue.begin(); t != m_sleep_queue.end(); ++t) {
-        os << "S-" << (*t).get_name() <<  ": "
+        os << ((*t).get_state() == TaskBase::DELAYED ? "D-" : "S-") << (*t).get_name() <<  ": "
         << "stack(" << (*t).get_stack_usage() 
         << "/" << (*t).get_stack_size() << ")" << "\n";
       }
@@ -131,15 +181,99 @@ namespace  os {
 
     static void init_task(TaskBase* task);
 
+    /**
+     * Adds a task at the tail of its ready list
+     */
+    static void make_ready(TaskBase* task);
+
+    /**
+     * Removes a task from its ready list
+     */
+    static void make_unready(TaskBase* task);
+
+    /**
+     * @return the head of the highest priority ready list
+     */
+    static TaskBase* get_next();
+
+    /**
+     * Switches from the current task to the given one
+     */
+    static void switch_to(TaskBase* next);
+    
+    /**
+     * Takes the current task out of the ready lists, in the given state and wait list,
+     * and runs the next
+     */
+    static void block(TaskBase::State state, task_queue_type& wait_list);
+    
+    /**
+     * Signals the events queued by interrupt handlers
+     */
+    static void signal_irq_events();
+    
+    /**
+     * Signals the events queued by interrupt handlers, makes ready
+     * the delayed tasks whose deadline is past
+     * @return the next task to run, after idling until one is ready
+     */
+    static TaskBase* schedule();
+    
+    /**
+     * Idles the CPU until an interrupt, with the timer set to match the earliest deadline.
+     * Returns at once if an interrupt handler signaled an event.
+     */
+    static void idle();
+    
+    /**
+     * Changes the priority of a task, moving it in its ready or wait list
+     */
+    static void set_priority(TaskBase* task, TaskBase::Priority priority);
+    
+    /**
+     * Inserts a task in a wait list, behind those of the same priority
+     */
+    static void add_by_priority(task_queue_type& wait_list, TaskBase* task);
+    
+    /**
+     * Inserts a task in the delay queue, behind those of the same deadline
+     */
+    static void add_delayed(TaskBase* task);
+    
+    /**
+     * Removes a task from the delay queue
+     */
+    static void remove_delayed(TaskBase* task);
+    
+    /**
+     * Wraparound safe date comparison
+     * @return true if date a is before date b
+     */
+    static bool is_before(uint32 a, uint32 b) {
+      return int32(a - b) < 0;
+    }
+    
+    static uint32 on_timer_match(hal::Timer& timer, hal::Timer::MatchChannel channel,
+                                 const hal::Timer::MatchInfo& info);
+
     /**
      * All tasks are here
      */
     static uint32 m_task_num;    
     
-    typedef util::List<TaskBase> task_queue_type;
-    static task_queue_type m_run_queue;
+    static task_queue_type m_ready[TaskBase::NB_PRIORITIES];
+    static uint32 m_ready_bitmap;  // bit p set if m_ready[p] is not empty
     static task_queue_type m_sleep_queue;
-    static task_queue_type::iterator m_current_task;
+    static TaskBase* m_current_task;
+    static TaskBase* m_delay_queue;  // delayed tasks, earliest deadline first
+    
+    static hal::Timer* m_timer;
+    static hal::Timer::MatchChannel m_match_channel;
+    static volatile bool m_timer_fired;
+    
+    friend class Event;
+    friend class Mutex;
+    static Event* volatile m_irq_events;  // signaled by interrupt handlers, last first
     
     static TaskBase m_task_main;
     static bool m_started;
@@ -155,7 +289,7 @@ namespace  os {
       //
       init_task(&task);      
     }
-    m_run_queue.add_tail(&task);
+    make_ready(&task);
     ++m_task_num;
   }
 
@@ -170,7 +304,46 @@ namespace  os {
   
   inline
   TaskBase* OS::get_current() {
-    return &*m_current_task;
+    return m_current_task;
+  }
+
+  inline
+  void OS::make_ready(TaskBase* task) {
+    m_ready[task->m_priority].add_tail(task);
+    m_ready_bitmap |= 1 << task->m_priority;
+  }
+
+  inline
+  void OS::make_unready(TaskBase* task) {
+    task_queue_type& level = m_ready[task->m_priority];
+    level.remove(task);
+    if (level.is_empty())
+      m_ready_bitmap &= ~(1 << task->m_priority);
+  }
+
+  inline
+  TaskBase* OS::get_next() {
+    // Highest bit of the 6 bit map, by nibble
+    static const uint8 highest[16] = {0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3};
+    typedef char bitmap_must_fit_2_nibbles[TaskBase::NB_PRIORITIES <= 8 ? 1 : -1] __attribute__((unused));
+    const uint32 high = m_ready_bitmap >> 4;
+    const uint32 priority = high ? 4 + highest[high] : highest[m_ready_bitmap];
+    return m_ready[priority].get_head();
+  }
+  
+  inline
+  uint32 OS::get_time() {
+    return m_timer->getTimerValue();
+  }
+  
+  inline
+  uint32 OS::ms_to_ticks(uint32 ms) {
+    return ms * (m_timer->get_rate() / 1000);
+  }
+  
+  inline
+  void OS::sleep_for(uint32 ms) {
+    sleep_until(get_time() + ms_to_ticks(ms));
   }
   
   inline
@@ -401,35 +401,35 @@ namespace hal {
         st.value = AD0STAT;
         if (st.done0) {
           data_bits.value = AD0DR0;
-          m_result[0].add_sample(data_bits.result);
+          add_sample(0, data_bits.result);
         }
         if (st.done1) {
           data_bits.value = AD0DR1;
-          m_result[1].add_sample(data_bits.result);
+          add_sample(1, data_bits.result);
         }
         if (st.done2) {
           data_bits.value = AD0DR2;
-          m_result[2].add_sample(data_bits.result);
+          add_sample(2, data_bits.result);
         }
         if (st.done3) {
           data_bits.value = AD0DR3;
-          m_result[3].add_sample(data_bits.result);
+          add_sample(3, data_bits.result);
         }
         if (st.done4) {
           data_bits.value = AD0DR4;
-          m_result[4].add_sample(data_bits.result);
+          add_sample(4, data_bits.result);
         }
         if (st.done5) {
           data_bits.value = AD0DR5;
-          m_result[5].add_sample(data_bits.result);
+          add_sample(5, data_bits.result);
         }
         if (st.done6) {
           data_bits.value = AD0DR6;
-          m_result[6].add_sample(data_bits.result);
+          add_sample(6, data_bits.result);
         }
         if (st.done7) {
           data_bits.value = AD0DR7;
-          m_result[7].add_sample(data_bits.result);
+          add_sample(7, data_bits.result);
         }
         break;
 
@@ -437,35 +437,35 @@ namespace hal {
         st.value = AD1STAT;
         if (st.done0) {
           data_bits.value = AD1DR0;
-          m_result[0].add_sample(data_bits.result);
+          add_sample(0, data_bits.result);
         }
         if (st.done1) {
           data_bits.value = AD1DR1;
-          m_result[1].add_sample(data_bits.result);
+          add_sample(1, data_bits.result);
         }
         if (st.done2) {
           data_bits.value = AD1DR2;
-          m_result[2].add_sample(data_bits.result);
+          add_sample(2, data_bits.result);
         }
         if (st.done3) {
           data_bits.value = AD1DR3;
-          m_result[3].add_sample(data_bits.result);
+          add_sample(3, data_bits.result);
         }
         if (st.done4) {
           data_bits.value = AD1DR4;
-          m_result[4].add_sample(data_bits.result);
+          add_sample(4, data_bits.result);
         }
         if (st.done5) {
           data_bits.value = AD1DR5;
-          m_result[5].add_sample(data_bits.result);
+          add_sample(5, data_bits.result);
         }
         if (st.done6) {
           data_bits.value = AD1DR6;
-          m_result[6].add_sample(data_bits.result);
+          add_sample(6, data_bits.result);
         }
         if (st.done7) {
           data_bits.value = AD1DR7;
-          m_result[7].add_sample(data_bits.result);
+          add_sample(7, data_bits.result);
         }
         break;
     }
@@ -478,7 +478,7 @@ namespace hal {
     const uint32 result = glob_data_bits.result;
     
     // Add results
-    m_result[channel].add_sample(result);
+    add_sample(channel, result);
 #endif
   }
 }
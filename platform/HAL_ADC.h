@@ -141,6 +141,12 @@ namespace hal {
       }
     };
     
+    /**
+     * A callback run for each conversion of a channel, in interrupt mode.
+     * NOTE: This function is run within an interrupt service routine
+     */
+    typedef void (*SampleCallback)(ADC& adc, Channel channel, uint32 sample, void* cbData);
+
     /**
      * Constructs an ADC for the given device
      */
@@ -217,6 +223,24 @@ namespace hal {
      * This does not affect the mode of the ADC
      */
     void reset_conversion_result(Channel channel);
+
+    /**
+     * Sets up a function to receive every conversion of a channel, in addition to
+     * the accumulated conversion result. This lets detectors such as util::Goertzel
+     * or util::SlidingDFT follow the signal without buffering windows of samples.
+     * @param cb the callback, or 0 to stop
+     * @param cbData an auxilliary value to be passed to the callback
+     */
+    void set_sample_callback(Channel channel, SampleCallback cb, void* cbData = 0);
+
+    /**
+     * A SampleCallback feeding a detector with add_sample(value_type), passed as cbData:
+     *   adc.set_sample_callback(ADC::CHAN_3, &ADC::feed<util::Goertzel<float, 2> >, &goertzel);
+     */
+    template <class D>
+    static void feed(ADC& adc, Channel channel, uint32 sample, void* detector) {
+      static_cast<D*>(detector)->add_sample(typename D::value_type(static_cast<int32>(sample)));
+    }
     
     /*
      * Sets up a single channel, starts a conversion, waits for the result (busy loop)
@@ -236,12 +260,16 @@ namespace hal {
     const Device m_device;
 
     ConversionResult m_result[NB_CHANNELS];
+    SampleCallback volatile m_callback[NB_CHANNELS];
+    void* volatile m_callback_data[NB_CHANNELS];
     
 #if DEBUG
     volatile uint32 m_interrupt_count;
 #endif
     
     void handle_irq();
+
+    void add_sample(uint32 channel, uint32 sample);
   };
   
   inline 
@@ -249,6 +277,8 @@ namespace hal {
   : m_device(device) {
     for (uint32 i = 0; i < NB_CHANNELS; ++i) {
       m_result[i].reset();
+      m_callback[i] = 0;
+      m_callback_data[i] = 0;
     }
 #if DEBUG
     m_interrupt_count = 0;
@@ -265,6 +295,22 @@ namespace hal {
     m_result[channel].reset();    
   }
   
+  inline
+  void ADC::set_sample_callback(Channel channel, SampleCallback cb, void* cbData) {
+    // The data first, so that the interrupt never sees the new callback with the old data
+    m_callback[channel] = 0;
+    m_callback_data[channel] = cbData;
+    m_callback[channel] = cb;
+  }
+
+  inline
+  void ADC::add_sample(uint32 channel, uint32 sample) {
+    m_result[channel].add_sample(sample);
+    const SampleCallback cb = m_callback[channel];
+    if (cb)
+      cb(*this, static_cast<Channel>(channel), sample, m_callback_data[channel]);
+  }
+
   inline
   void ADC::get_conversion_result(Channel channel, ConversionResult& result, bool reset) {
     result = m_result[channel];
@@ -21,9 +21,11 @@ namespace hal {
    * A class that reads an audio source, and output audio samples to the DAC.
    * It does not free the audio source, as it assumes the audio source is not dynamically
    * allocated.
-   * A timer is used for scheduling samples at 8000 Hz.
+   * A timer is used for scheduling samples at 8000 Hz, times the resampling ratio
+   * of the interpolator.
    */
-  template <class AudioSource_T>
+  template <class AudioSource_T,
+            class Interpolator_T = util::PolyphaseInterpolator<typename AudioSource_T::sample_type, 2, 1, 8> >
   class AudioPlayer: NoCopy {
   public:
     
@@ -41,11 +43,13 @@ namespace hal {
     /**
      * We use this type of interpolator
      */
-    typedef typename util::LinearInterpolator<sample_type> interpolator_type;
+    typedef Interpolator_T interpolator_type;
     
     /**
-     * Which oversamples by this much
+     * Which oversamples by this much, INTERPOLATION_FACTOR / DECIMATION_FACTOR
      */
+    static const uint32 INTERPOLATION_FACTOR = interpolator_type::INTERPOLATION_FACTOR;
+    static const uint32 DECIMATION_FACTOR = interpolator_type::DECIMATION_FACTOR;
     static const uint32 OVERSAMPLING_FACTOR = interpolator_type::OVERSAMPLING_FACTOR;
     
     /**
@@ -120,7 +124,8 @@ namespace hal {
       }
       m_buffer.reset();
       m_interpolator.reset();
-      m_sample_ticks = m_timer.get_rate() / (SAMPLE_RATE * OVERSAMPLING_FACTOR);
+      m_sample_ticks = static_cast<uint32>(static_cast<uint64>(m_timer.get_rate()) * DECIMATION_FACTOR
+                                           / (SAMPLE_RATE * INTERPOLATION_FACTOR));
       m_state = BUFFERING;
     }
     
@@ -8,4 +8,11 @@
  */
 
 #include "HAL_Processor.h"
+#include "lpc214x.h"
 
+namespace hal {
+  void Processor::idle() {
+    // Idle mode, left on any enabled interrupt
+    PCON = 0x01;
+  }
+}
@@ -17,6 +17,11 @@ namespace hal {
     static void disable_interrupts();
     static void enable_interrupts();
     static uint32 get_cpsr();
+    
+    /**
+     * Stops the CPU clock until an interrupt. The peripherals keep running.
+     */
+    static void idle();
   private:
   };
   
@@ -470,6 +470,9 @@ namespace hal {
             while (--max_bytes_sent && !m_send_buffer.is_empty()) {
               regs.thr = m_send_buffer.get();                      
             }            
+            // There is room in the send buffer
+            if (m_send_callback != 0)
+              m_send_callback(m_send_data);
           }
           //
           // Are we really done?
@@ -492,6 +495,8 @@ namespace hal {
 #endif
           // Receive character time out interrupt. Bytes are available in the receive fifo
           // Clear by reading RBR
+        {
+          bool received = false;
           while (regs.lsr.receive_data_ready) {
             const uint8 byte = regs.rbr;
             
@@ -505,11 +510,15 @@ namespace hal {
             } else if (!m_receive_buffer.is_full()) {
               // TODO: If the receive buffer is at some threshold, send an XOFF
               m_receive_buffer.put(byte);
+              received = true;
             } else {
               // TODO: Here the receive buffer is full. We should take note of this overrun
             }
           }
+          if (received && m_receive_callback != 0)
+            m_receive_callback(m_receive_data);
           break;
+        }
         
         case 3:
           // Receive line status change
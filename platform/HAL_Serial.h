@@ -125,6 +125,23 @@ public:
      */
     uint32 read(uint8 *bytes, uint32 count);
     
+    /**
+     * A function called by the interrupt handler
+     */
+    typedef void (*Callback)(void *cbData);
+    
+    /**
+     * Sets up a function called when received bytes were buffered, in interrupt mode.
+     * NOTE: This function is run within an interrupt service routine
+     */
+    void set_receive_callback(Callback cb, void *cbData = 0);
+    
+    /**
+     * Sets up a function called when bytes left the send buffer, in interrupt mode.
+     * NOTE: This function is run within an interrupt service routine
+     */
+    void set_send_callback(Callback cb, void *cbData = 0);
+    
     
 private:
     static const uint32 TX_FIFO_SIZE = 16U;
@@ -154,6 +171,11 @@ private:
     volatile send_buffer_type m_send_buffer;
     volatile receive_buffer_type m_receive_buffer;
     
+    Callback m_receive_callback;
+    void *m_receive_data;
+    Callback m_send_callback;
+    void *m_send_data;
+    
 #if SER_DEBUG
   public:
     uint32 m_nb_read_interrupts;
@@ -167,6 +189,7 @@ private:
   
   inline Serial::Serial(Port port)
   : m_port(port), m_flow_control(FLOW_CONTROL_NONE), m_interrupt_mode(INTERRUPT_DISABLED)
+  , m_receive_callback(0), m_receive_data(0), m_send_callback(0), m_send_data(0)
 #if SER_DEBUG
   , m_nb_read_interrupts(0)
   , m_nb_write_interrupts(0)
@@ -177,4 +200,14 @@ private:
 #endif
   {
   }
+  
+  inline void Serial::set_receive_callback(Callback cb, void *cbData) {
+    m_receive_callback = cb;
+    m_receive_data = cbData;
+  }
+  
+  inline void Serial::set_send_callback(Callback cb, void *cbData) {
+    m_send_callback = cb;
+    m_send_data = cbData;
+  }
 }
@@ -0,0 +1,98 @@
+/*
+ *  bench_aes.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/AES.h"
+#include "../util/AES_ni.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace util;
+
+/**
+ * Throughput of util::AES on its AES-NI path and on its tables, in MB/s,
+ * for each key size and mode, over a 64KB buffer
+ */
+namespace {
+  const uint32 NB_BLOCKS = 4096;
+  const double MIN_TIME = 0.2;  // s per measurement
+
+  enum Operation {
+    ECB_ENCRYPT,
+    CBC_ENCRYPT,
+    CBC_DECRYPT,
+    CTR,
+    NB_OPERATIONS
+  };
+
+  const char* const NAMES[NB_OPERATIONS] = {"ECB encrypt", "CBC encrypt", "CBC decrypt", "CTR"};
+
+  uint8 in[16 * NB_BLOCKS], out[16 * NB_BLOCKS];
+
+  double throughput(int key_size, bool accelerated, Operation operation) {
+    uint8 key[32];
+    for (uint32 i = 0; i < sizeof key; ++i)
+      key[i] = uint8(rand());
+    AES aes;
+    aes.SetParameters(key_size, 128);
+    aes.SetAcceleration(accelerated);
+    if (operation == CBC_DECRYPT)
+      aes.StartDecryption(key);
+    else
+      aes.StartEncryption(key);
+
+    uint8 counter[16];
+    memset(counter, 0, sizeof counter);
+    uint32 rounds = 0;
+    const double start = test::seconds();
+    double elapsed;
+    do {
+      switch (operation) {
+        case ECB_ENCRYPT:
+          aes.Encrypt(in, out, NB_BLOCKS, AES::ECB);
+          break;
+        case CBC_ENCRYPT:
+          aes.Encrypt(in, out, NB_BLOCKS, AES::CBC);
+          break;
+        case CBC_DECRYPT:
+          aes.Decrypt(in, out, NB_BLOCKS, AES::CBC);
+          break;
+        default:
+          aes.EncryptCTR(counter, in, out, NB_BLOCKS);
+          break;
+      }
+      ++rounds;
+      elapsed = test::seconds() - start;
+    } while (elapsed < MIN_TIME);
+    return rounds * sizeof in / elapsed / 1e6;
+  }
+}
+
+int main() {
+#if defined(AES_HAS_NI)
+  const bool has_ni = aes_ni::is_supported();
+#else
+  const bool has_ni = false;
+#endif
+  if (!has_ni)
+    printf("No AES-NI: both columns run on the tables\n");
+  for (uint32 i = 0; i < sizeof in; ++i)
+    in[i] = uint8(rand());
+
+  const int key_sizes[] = {128, 192, 256};
+  printf("%-12s %-5s %10s %10s\n", "", "key", "AES-NI", "tables");
+  for (int operation = 0; operation < NB_OPERATIONS; ++operation) {
+    for (int k = 0; k < 3; ++k) {
+      const double ni = throughput(key_sizes[k], true, Operation(operation));
+      const double tables = throughput(key_sizes[k], false, Operation(operation));
+      printf("%-12s %-5d %6.0f MB/s %6.0f MB/s  %4.1fx\n", NAMES[operation], key_sizes[k], ni, tables, ni / tables);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ *  bench_aes256.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/AES256_wrapper.h"
+#include "../util/aes256.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace util;
+
+/**
+ * Blocks per second of AES256, with its schedules expanded once and its word
+ * tables, against the byte-oriented aes256.c it was built on, which derives
+ * the round keys and the S-box values on the fly for every block.
+ */
+namespace {
+  const uint32 NB_BLOCKS = 1024;
+  const double MIN_TIME = 0.2;  // s per measurement
+
+  uint8 buffer[16 * NB_BLOCKS];
+
+  /**
+   * @return the blocks per second of op(block) over the buffer, repeated
+   */
+  template <class Op>
+  double blocks_per_second(Op& op) {
+    uint32 rounds = 0;
+    const double start = test::seconds();
+    double elapsed;
+    do {
+      for (uint32 b = 0; b < NB_BLOCKS; ++b)
+        op(buffer + 16 * b);
+      ++rounds;
+      elapsed = test::seconds() - start;
+    } while (elapsed < MIN_TIME);
+    return double(rounds) * NB_BLOCKS / elapsed;
+  }
+
+  struct TableEncrypt {
+    AES256& aes;
+    void operator()(uint8* block) { aes.encrypt_ecb(block); }
+  };
+
+  struct TableDecrypt {
+    AES256& aes;
+    void operator()(uint8* block) { aes.decrypt_ecb(block); }
+  };
+
+  struct ByteEncrypt {
+    aes256_context& context;
+    void operator()(uint8* block) { aes256_encrypt_ecb(&context, block); }
+  };
+
+  struct ByteDecrypt {
+    aes256_context& context;
+    void operator()(uint8* block) { aes256_decrypt_ecb(&context, block); }
+  };
+}
+
+int main() {
+  AES256::key_type key;
+  for (uint32 i = 0; i < sizeof key; ++i)
+    key[i] = uint8(rand());
+  for (uint32 i = 0; i < sizeof buffer; ++i)
+    buffer[i] = uint8(rand());
+
+  AES256 aes;
+  aes.set_key(key);
+  aes256_context context;
+  aes256_init(&context, key);
+
+  // Both give the same ciphertext
+  uint8 table_block[16], byte_block[16];
+  memcpy(table_block, buffer, 16);
+  memcpy(byte_block, buffer, 16);
+  aes.encrypt_ecb(table_block);
+  aes256_encrypt_ecb(&context, byte_block);
+  if (memcmp(table_block, byte_block, 16) != 0) {
+    printf("AES256 and aes256.c disagree\n");
+    return 1;
+  }
+
+  TableEncrypt table_encrypt = {aes};
+  TableDecrypt table_decrypt = {aes};
+  ByteEncrypt byte_encrypt = {context};
+  ByteDecrypt byte_decrypt = {context};
+  const double te = blocks_per_second(table_encrypt);
+  const double be = blocks_per_second(byte_encrypt);
+  const double td = blocks_per_second(table_decrypt);
+  const double bd = blocks_per_second(byte_decrypt);
+  printf("AES-256 ECB, blocks/s   AES256     aes256.c\n");
+  printf("  encrypt            %9.0f  %9.0f  %5.1fx\n", te, be, te / be);
+  printf("  decrypt            %9.0f  %9.0f  %5.1fx\n", td, bd, td / bd);
+  aes256_done(&context);
+  return 0;
+}
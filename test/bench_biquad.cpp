@@ -0,0 +1,92 @@
+/*
+ *  bench_biquad.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/Biquad.h"
+#include "../util/FIR.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+using namespace util;
+
+/**
+ * Throughput of a 4th order Butterworth lowpass, 2 biquad sections, against the FIR
+ * of the same response: its impulse response, truncated where the tail is below -80dB.
+ */
+namespace {
+  const float SAMPLE_RATE = 48000;
+  const float CUTOFF = 2000;
+  const uint32 TAPS = 96;
+  const uint32 NB_SAMPLES = 4096;
+  const int ROUNDS = 500;
+
+  double to_double(float v) {
+    return v;
+  }
+
+  double to_double(const Q<24>& v) {
+    return v.to_float();
+  }
+
+  template <typename T>
+  void design(BiquadCascade<T, 2>& cascade) {
+    cascade.set_section(0, BiquadDesign::lowpass(SAMPLE_RATE, CUTOFF, 0.5412f));
+    cascade.set_section(1, BiquadDesign::lowpass(SAMPLE_RATE, CUTOFF, 1.3066f));
+  }
+
+  /**
+   * Prints the throughput of both filters, and the largest difference of their outputs
+   */
+  template <typename T>
+  void run(const char* name) {
+    BiquadCascade<double, 2> impulse;
+    design(impulse);
+    T coef[TAPS];
+    for (uint32 i = 0; i < TAPS; ++i)
+      coef[i] = T(float(impulse.process(i == 0 ? 1.0 : 0.0)));
+
+    static T in[NB_SAMPLES], out[NB_SAMPLES], fir_out[NB_SAMPLES];
+    for (uint32 n = 0; n < NB_SAMPLES; ++n)
+      in[n] = T(float(rand() % 2001 - 1000) / 1000);
+
+    BiquadCascade<T, 2> cascade;
+    design(cascade);
+    double start = test::seconds();
+    for (int r = 0; r < ROUNDS; ++r)
+      cascade.process(in, out, NB_SAMPLES);
+    const double iir = ROUNDS * NB_SAMPLES / (test::seconds() - start) / 1e6;
+
+    FIR<T, TAPS> fir(coef);
+    start = test::seconds();
+    for (int r = 0; r < ROUNDS; ++r)
+      fir.process(in, fir_out, NB_SAMPLES);
+    const double fir_rate = ROUNDS * NB_SAMPLES / (test::seconds() - start) / 1e6;
+
+    // Both from rest, on the same input: the FIR primed with zeros
+    cascade.reset();
+    cascade.process(in, out, NB_SAMPLES);
+    FIR<T, TAPS> rest(coef);
+    rest.add_value(T(0));
+    double worst = 0;
+    for (uint32 n = 0; n < NB_SAMPLES; ++n) {
+      rest.add_value(in[n]);
+      worst = fmax(worst, fabs(to_double(rest.get_filtered_value()) - to_double(out[n])));
+    }
+
+    printf("  %-6s biquads %.1f Msamples/s, FIR %.1f Msamples/s: %.1fx, outputs within %.1e\n",
+           name, iir, fir_rate, iir / fir_rate, worst);
+  }
+}
+
+int main() {
+  printf("4th order lowpass at %.0f Hz for %.0f Hz, 2 sections against %u taps\n", CUTOFF, SAMPLE_RATE, TAPS);
+  run<float>("float");
+  run<Q<24> >("Q<24>");
+  return 0;
+}
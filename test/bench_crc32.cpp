@@ -0,0 +1,90 @@
+/*
+ *  bench_crc32.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/CRC32.h"
+
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#  define BENCH_HAS_TSC 1
+#endif
+
+using namespace util;
+
+/**
+ * Cost of each CRC32 engine for 16B, 256B and 4KB buffers, in time stamp counter
+ * cycles per byte where the host has one, and in MB/s. Each size is measured over
+ * the same total of bytes, the buffer being processed again and again.
+ */
+namespace {
+  const uint32 SIZES[] = {16, 256, 4096};
+  const uint32 NB_SIZES = sizeof SIZES / sizeof SIZES[0];
+  const uint32 TOTAL = 64 << 20;  // bytes per measurement, a 16th of it for the bitwise engine
+
+  uint8 data[4096];
+  volatile uint32 sink;
+
+  uint64 ticks() {
+#if defined(BENCH_HAS_TSC)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  template <class E>
+  void run(const char* name, uint32 total = TOTAL) {
+    printf("  %-8s", name);
+    for (uint32 s = 0; s < NB_SIZES; ++s) {
+      const uint32 size = SIZES[s];
+      const uint32 rounds = total / size;
+      uint32 crc = 0xffffffff;
+      const double start = test::seconds();
+      const uint64 start_ticks = ticks();
+      for (uint32 r = 0; r < rounds; ++r)
+        crc = E::update(crc, data, size);
+      const double cycles = double(ticks() - start_ticks);
+      const double elapsed = test::seconds() - start;
+      sink += crc;
+      const double bytes = double(rounds) * size;
+#if defined(BENCH_HAS_TSC)
+      printf(" %8.2f c/B %7.0f MB/s", cycles / bytes, bytes / elapsed / 1e6);
+#else
+      (void) cycles;
+      printf(" %7.0f MB/s", bytes / elapsed / 1e6);
+#endif
+    }
+    printf("\n");
+  }
+}
+
+int main() {
+  for (uint32 i = 0; i < sizeof data; ++i)
+    data[i] = uint8(rand());
+
+  printf("%-10s", "");
+  for (uint32 s = 0; s < NB_SIZES; ++s)
+#if defined(BENCH_HAS_TSC)
+    printf(" %22u B", SIZES[s]);
+#else
+    printf(" %10u B", SIZES[s]);
+#endif
+  printf("\n");
+  run<CRC32_Bitwise>("Bitwise", TOTAL / 16);
+  run<CRC32_Table256>("Table256");
+  run<CRC32_Slice4>("Slice4");
+  run<CRC32_Slice8>("Slice8");
+#if defined(CRC32_HAS_CLMUL)
+  if (!CRC32_Clmul::is_supported())
+    printf("  no PCLMULQDQ: Clmul runs slicing-by-8\n");
+  run<CRC32_Clmul>("Clmul");
+#endif
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ *  bench_crc32_combine.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/CRC32.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace util;
+
+/**
+ * CRC of a 64MB buffer, in a single stream, then cut in chunks computed on
+ * 2 to 8 host threads and merged with crc32_combine(), with the default engine
+ * and with slicing-by-8. Threads run concurrently, so the time is wall clock time.
+ */
+namespace {
+  const uint32 SIZE = 64 << 20;
+  const uint32 MAX_THREADS = 8;
+  const int ROUNDS = 10;
+
+  uint8* data;
+
+  double wall_seconds() {
+    timeval t;
+    gettimeofday(&t, 0);
+    return t.tv_sec + t.tv_usec * 1e-6;
+  }
+
+  struct Chunk {
+    const uint8* data;
+    uint32 size;
+    uint32 crc;
+  };
+
+  template <class E>
+  void* process(void* arg) {
+    Chunk& chunk = *static_cast<Chunk*>(arg);
+    BasicCRC32<E> crc;
+    chunk.crc = crc.process(chunk.data, chunk.size).get_result();
+    return 0;
+  }
+
+  /**
+   * @return the crc of the buffer, computed in nb_threads chunks and merged
+   */
+  template <class E>
+  uint32 chunked(uint32 nb_threads) {
+    Chunk chunks[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    const uint32 chunk_size = SIZE / nb_threads;
+    for (uint32 t = 0; t < nb_threads; ++t) {
+      chunks[t].data = data + t * chunk_size;
+      chunks[t].size = t + 1 == nb_threads ? SIZE - t * chunk_size : chunk_size;
+      pthread_create(&threads[t], 0, &process<E>, &chunks[t]);
+    }
+    pthread_join(threads[0], 0);
+    uint32 crc = chunks[0].crc;
+    for (uint32 t = 1; t < nb_threads; ++t) {
+      pthread_join(threads[t], 0);
+      crc = crc32_combine(crc, chunks[t].crc, chunks[t].size);
+    }
+    return crc;
+  }
+
+  template <class E>
+  void run(const char* name) {
+    BasicCRC32<E> crc;
+    uint32 expected = 0;
+    double start = wall_seconds();
+    for (int r = 0; r < ROUNDS; ++r) {
+      crc.reset();
+      expected = crc.process(data, SIZE).get_result();
+    }
+    const double single = ROUNDS * double(SIZE) / (wall_seconds() - start) / 1e6;
+    printf("%s, single stream: %.0f MB/s\n", name, single);
+
+    for (uint32 nb_threads = 2; nb_threads <= MAX_THREADS; nb_threads *= 2) {
+      bool same = true;
+      start = wall_seconds();
+      for (int r = 0; r < ROUNDS; ++r) {
+        if (chunked<E>(nb_threads) != expected)
+          same = false;
+      }
+      const double rate = ROUNDS * double(SIZE) / (wall_seconds() - start) / 1e6;
+      printf("  %u threads, combined: %.0f MB/s, %.2fx%s\n", nb_threads, rate, rate / single,
+             same ? "" : ", WRONG RESULT");
+    }
+  }
+}
+
+int main() {
+  data = static_cast<uint8*>(malloc(SIZE));
+  for (uint32 i = 0; i < SIZE; ++i)
+    data[i] = uint8(rand());
+
+  printf("64MB buffer, %ld processors online\n", sysconf(_SC_NPROCESSORS_ONLN));
+  run<CRC32::engine_type>("Default engine");
+  run<CRC32_Slice8>("Slice8");
+  free(data);
+  return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ *  bench_event.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "host_os.h"
+#include "host_serial.h"
+#include "../os/OS_Event.h"
+#include "../os/OS_Reader.h"
+
+using os::OS;
+using os::TaskBase;
+using os::Event;
+
+/**
+ * A reader of a serial port receiving a byte every 5ms, over one simulated second,
+ * yielding when no byte is there or waiting on the receive event.
+ * A background task works 100us every 10ms, or is always ready, working 100us slices.
+ * Each poll of the serial port takes 2us.
+ */
+namespace {
+  const uint32 DURATION = 1000000;
+  const uint32 BYTE_PERIOD = 5000;
+  const uint32 NB_BYTES = DURATION / BYTE_PERIOD;
+  const uint32 STACK_SIZE = 64;
+
+  class ReaderTask: public TaskBase {
+  public:
+    ReaderTask(test::host::Serial& serial, Event* event)
+    : TaskBase("reader", m_stack, STACK_SIZE), m_reader(serial, event) {
+    }
+
+  protected:
+    void run() {
+      for (uint32 i = 0; i < NB_BYTES; ++i) {
+        uint8 c;
+        m_reader.get(c);
+      }
+    }
+
+  private:
+    uint32 m_stack[STACK_SIZE];
+    os::Reader<test::host::Serial> m_reader;
+  };
+
+  class Background: public TaskBase {
+  public:
+    Background(bool always_ready, uint32 end)
+    : TaskBase("background", m_stack, STACK_SIZE), m_always_ready(always_ready), m_end(end) {
+    }
+
+  protected:
+    void run() {
+      uint32 date = OS::get_time();
+      while (int32(OS::get_time() - m_end) < 0) {
+        test::host::work(100);
+        if (m_always_ready) {
+          OS::yield();
+        } else {
+          date += OS::ms_to_ticks(10);
+          OS::sleep_until(date);
+        }
+      }
+    }
+
+  private:
+    uint32 m_stack[STACK_SIZE];
+    const bool m_always_ready;
+    const uint32 m_end;
+  };
+
+  void measure(bool with_event, bool always_ready) {
+    // The tasks, and what they use, outlive the run
+    test::host::Serial& serial = *new test::host::Serial;
+    Event& event = *new Event;
+    const uint32 start = OS::get_time();
+    serial.set_receive_callback(&Event::interrupt_callback, &event);
+    ReaderTask* reader = new ReaderTask(serial, with_event ? &event : 0);
+    Background* background = new Background(always_ready, start + DURATION);
+    const test::host::Counters before = test::host::counters();
+    OS::add(*reader);
+    OS::add(*background);
+    serial.receive(NB_BYTES, BYTE_PERIOD);
+    OS::sleep_until(start + DURATION + 1000);
+
+    const test::host::Counters& after = test::host::counters();
+    printf("  %-11s %-20s %7u empty polls, %5u context switches, CPU idle %5.1f%%\n",
+           with_event ? "event" : "spin-yield", always_ready ? "background ready" : "background 10ms",
+           serial.get_empty_polls(), after.switches - before.switches,
+           100.0 * (after.idle_time - before.idle_time) / (OS::get_time() - start));
+  }
+}
+
+int main() {
+  test::host::start_os();
+  printf("Serial reader, a byte every %u ms for %u s\n", BYTE_PERIOD / 1000, DURATION / 1000000);
+  measure(false, false);
+  measure(true, false);
+  measure(false, true);
+  measure(true, true);
+  return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ *  bench_fir.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/FIR.h"
+
+#include <stdlib.h>
+
+using namespace util;
+
+namespace {
+  const uint32 N = 64;
+  const uint32 NB_SAMPLES = 4096;
+  const int ROUNDS = 500;
+
+  /**
+   * The filter as it was before the circular delay line: every value shifts
+   * all the taps, and each product is rounded
+   */
+  template <typename T>
+  class ShiftFIR {
+  public:
+    explicit ShiftFIR(const T* coef) {
+      for (uint32 i = 0; i < N; ++i) {
+        m_coef[i] = coef[i];
+        m_taps[i] = T(0);
+      }
+    }
+
+    T process(const T& v) {
+      for (uint32 i = N - 1; i > 0; --i)
+        m_taps[i] = m_taps[i - 1];
+      m_taps[0] = v;
+      T temp(0);
+      for (uint32 i = 0; i < N; ++i)
+        temp += m_coef[i] * m_taps[i];
+      return temp;
+    }
+
+  private:
+    T m_taps[N];
+    T m_coef[N];
+  };
+
+  /**
+   * Prints the throughput of both filters
+   */
+  template <typename T>
+  void run(const char* name) {
+    T coef[N];
+    static T in[NB_SAMPLES], out[NB_SAMPLES];
+    for (uint32 i = 0; i < N; ++i)
+      coef[i] = T(float(rand() % 2001 - 1000) / 64000);
+    for (uint32 n = 0; n < NB_SAMPLES; ++n)
+      in[n] = T(float(rand() % 2001 - 1000) / 1000);
+
+    FIR<T, N> fir(coef);
+    double start = test::seconds();
+    for (int r = 0; r < ROUNDS; ++r)
+      fir.process(in, out, NB_SAMPLES);
+    const double circular = ROUNDS * NB_SAMPLES / (test::seconds() - start) / 1e6;
+
+    ShiftFIR<T> shift(coef);
+    start = test::seconds();
+    for (int r = 0; r < ROUNDS; ++r) {
+      for (uint32 n = 0; n < NB_SAMPLES; ++n)
+        out[n] = shift.process(in[n]);
+    }
+    const double shifted = ROUNDS * NB_SAMPLES / (test::seconds() - start) / 1e6;
+
+    printf("  %-6s FIR %.1f Msamples/s, shifting taps %.1f Msamples/s\n", name, circular, shifted);
+  }
+}
+
+int main() {
+  printf("%u taps\n", unsigned(N));
+  run<float>("float");
+  run<Q<16> >("Q<16>");
+  return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ *  bench_fourier.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/Fourier.h"
+
+#include <stdlib.h>
+
+using namespace util;
+
+/**
+ * Time of one transform of N real samples, N = 64 to 4096, through FFT and
+ * RealFFT in float and in Q<24>, against the O(N^2) Fourier::dft in float.
+ * The outputs are globals, so no transform can be optimized away.
+ * Also prints the size of an instance, the tables being shared per size.
+ */
+namespace {
+  typedef Q<24> Q24;
+
+  const uint32 MAX_N = 4096;
+  const double MIN_TIME = 0.2;  // s per measurement
+
+  float x[MAX_N], re[MAX_N], im[MAX_N];
+  Q24 qx[MAX_N], q_re[MAX_N], q_im[MAX_N];
+
+  /**
+   * @return the microseconds per call of op()
+   */
+  template <class Op>
+  double us_per_call(Op& op) {
+    uint32 calls = 0;
+    const double start = test::seconds();
+    double elapsed;
+    do {
+      op();
+      ++calls;
+      elapsed = test::seconds() - start;
+    } while (elapsed < MIN_TIME);
+    return elapsed / calls * 1e6;
+  }
+
+  template <uint32 N>
+  struct Dft {
+    void operator()() {
+      Fourier<float>::dft(x, re, im, N);
+    }
+  };
+
+  template <typename T, uint32 N>
+  struct Complex {
+    FFT<T, N> fft;
+    T* x;
+    T* re;
+    T* im;
+
+    void operator()() {
+      // The imaginary parts of real samples are 0
+      for (uint32 n = 0; n < N; ++n) {
+        re[n] = x[n];
+        im[n] = T(0);
+      }
+      fft.transform(re, im);
+    }
+  };
+
+  template <typename T, uint32 N>
+  struct Real {
+    RealFFT<T, N> fft;
+    T* x;
+    T* re;
+    T* im;
+
+    void operator()() {
+      fft.transform(x, re, im);
+    }
+  };
+
+  template <uint32 N>
+  void run() {
+    static Complex<float, N> fft;
+    static Real<float, N> real_fft;
+    static Complex<Q24, N> q_fft;
+    static Real<Q24, N> q_real_fft;
+    fft.x = x; fft.re = re; fft.im = im;
+    real_fft.x = x; real_fft.re = re; real_fft.im = im;
+    q_fft.x = qx; q_fft.re = q_re; q_fft.im = q_im;
+    q_real_fft.x = qx; q_real_fft.re = q_re; q_real_fft.im = q_im;
+
+    Dft<N> dft;
+    const double t_dft = us_per_call(dft);
+    const double t_fft = us_per_call(fft);
+    const double t_real = us_per_call(real_fft);
+    const double t_q = us_per_call(q_fft);
+    const double t_q_real = us_per_call(q_real_fft);
+    printf("%5u %11.1f %9.2f %9.2f %9.2f %9.2f %7.0fx %6u B\n", N, t_dft, t_fft, t_real, t_q, t_q_real,
+           t_dft / t_real, uint32(sizeof(FFT<float, N>)));
+  }
+}
+
+int main() {
+  for (uint32 n = 0; n < MAX_N; ++n) {
+    x[n] = (rand() % 2001 - 1000) / 1000.0f;
+    qx[n] = Q24(x[n]);
+  }
+
+  printf("us per transform   float                Q<24>                 dft/  instance\n");
+  printf("%5s %11s %9s %9s %9s %9s %8s\n", "N", "dft", "FFT", "RealFFT", "FFT", "RealFFT", "RealFFT");
+  run<64>();
+  run<128>();
+  run<256>();
+  run<512>();
+  run<1024>();
+  run<2048>();
+  run<4096>();
+  return 0;
+}
@@ -0,0 +1,48 @@
+/*
+ *  bench_hmac.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/SHA1.h"
+#include "../util/HMAC.h"
+
+using namespace util;
+
+namespace {
+  const int COUNT = 500000;
+  uint8 key[20];
+  uint8 message[32];
+
+  /**
+   * @return the number of 32 byte MACs per second, setting the key for each when asked
+   */
+  double rate(bool set_key_each_time) {
+    HMAC<SHA1> hmac;
+    hmac.set_key(key, sizeof key);
+    const double start = test::seconds();
+    for (int i = 0; i < COUNT; ++i) {
+      if (set_key_each_time)
+        hmac.set_key(key, sizeof key);
+      else
+        hmac.reset();
+      hmac.process(message, sizeof message);
+      // Chain the messages so that no iteration can be skipped
+      message[0] ^= hmac.get_result()[0];
+    }
+    return COUNT / (test::seconds() - start);
+  }
+}
+
+int main() {
+  for (uint32 i = 0; i < sizeof key; ++i)
+    key[i] = uint8(i);
+
+  printf("HMAC-SHA1, %d bytes, 32 byte messages\n", int(sizeof(HMAC<SHA1>)));
+  printf("  set_key per message: %.2f M/s\n", rate(true) / 1e6);
+  printf("  reset per message:   %.2f M/s\n", rate(false) / 1e6);
+  return 0;
+}
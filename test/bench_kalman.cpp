@@ -0,0 +1,125 @@
+/*
+ *  bench_kalman.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "reference_kalman.h"
+#include "../util/Kalman.h"
+
+using namespace la;
+
+/**
+ * Time per predict and update step of la::Kalman against the textbook filter,
+ * and with the steady state gain, then the arithmetic operations of a step.
+ * The stack used by a step is given by the compiler: build with -fstack-usage
+ * and look up step() in the .su file, the filter itself living in step_time().
+ */
+namespace {
+  const uint32 COUNT = 1000000;
+
+  // Keeps the results alive
+  volatile float sink;
+
+  template <class Filter>
+  __attribute__((noinline))
+  void step(Filter& k, const typename Filter::meas_type& Z) {
+    k.update_time();
+    k.update_measurement(Z);
+  }
+
+  /**
+   * A float counting its operations
+   */
+  struct CountedFloat {
+    static uint32 adds, multiplies, divides;
+
+    float v;
+    CountedFloat() : v(0) {}
+    CountedFloat(float f) : v(f) {}
+    CountedFloat operator+(CountedFloat o) const { ++adds; return v + o.v; }
+    CountedFloat operator-(CountedFloat o) const { ++adds; return v - o.v; }
+    CountedFloat operator*(CountedFloat o) const { ++multiplies; return v * o.v; }
+    CountedFloat operator/(CountedFloat o) const { ++divides; return v / o.v; }
+    CountedFloat operator-() const { return -v; }
+    CountedFloat& operator+=(CountedFloat o) { ++adds; v += o.v; return *this; }
+    CountedFloat& operator-=(CountedFloat o) { ++adds; v -= o.v; return *this; }
+    bool operator<(CountedFloat o) const { return v < o.v; }
+    bool operator<=(CountedFloat o) const { return v <= o.v; }
+    bool operator>=(int o) const { return v >= o; }
+  };
+  uint32 CountedFloat::adds, CountedFloat::multiplies, CountedFloat::divides;
+
+  /**
+   * @return the time per step of the filter, set up beforehand
+   */
+  template <class Filter>
+  double step_time(Filter& k) {
+    typename Filter::meas_type Z[64];
+    for (uint32 n = 0; n < 64; ++n)
+      test::measurement(Z[n], n);
+
+    const double start = test::seconds();
+    for (uint32 n = 0; n < COUNT; ++n) {
+      step(k, Z[n & 63]);
+    }
+    const double t = test::seconds() - start;
+    sink = k.X(0, 0);
+    return t / COUNT * 1e9;
+  }
+
+  template <uint32 N, uint32 M>
+  void compare() {
+    typedef test::KalmanTraits<N, M> traits;
+    test::ReferenceKalman<traits> reference;
+    Kalman<traits> full, steady;
+    test::setup_kalman(reference);
+    test::setup_kalman(full);
+    test::setup_kalman(steady);
+    steady.set_steady_state();
+    printf("  %u/%u   %7.0f ns   %7.0f ns   %7.0f ns\n", N, M,
+           step_time(reference), step_time(full), step_time(steady));
+  }
+
+  template <uint32 N, uint32 M>
+  void count(bool steady_state) {
+    Kalman<test::KalmanTraits<N, M, CountedFloat> > k;
+    test::setup_kalman(k);
+    if (steady_state)
+      k.set_steady_state();
+    typename Kalman<test::KalmanTraits<N, M, CountedFloat> >::meas_type Z;
+    test::measurement(Z, 0);
+    CountedFloat::adds = CountedFloat::multiplies = CountedFloat::divides = 0;
+    step(k, Z);
+    printf("   %3u/%3u/%u", CountedFloat::adds, CountedFloat::multiplies, CountedFloat::divides);
+  }
+
+  template <uint32 N, uint32 M>
+  void count() {
+    printf("  %u/%u", N, M);
+    count<N, M>(false);
+    count<N, M>(true);
+    printf("\n");
+  }
+}
+
+int main() {
+  printf("Kalman<float> predict + update\n");
+  printf("  n/m    textbook     expressions  steady state\n");
+  compare<2, 1>();
+  compare<4, 1>();
+  compare<4, 2>();
+  compare<6, 1>();
+  compare<6, 2>();
+
+  printf("Operations per step, add/multiply/divide\n");
+  printf("  n/m   full        steady state\n");
+  count<2, 1>();
+  count<4, 2>();
+  count<6, 1>();
+  count<6, 2>();
+  return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ *  bench_mutex.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "host_os.h"
+#include "../os/OS_Mutex.h"
+
+using os::OS;
+using os::TaskBase;
+using os::Mutex;
+
+/**
+ * Contention on one mutex. Two PRIORITY_DEFAULT tasks keep taking it for 300us of
+ * work in 100us slices, yielding in between, a higher priority task is busy for
+ * 500us out of each 1.5ms, and the highest priority task takes the mutex once per ms.
+ * Reports how long each task waited for the mutex, and the number of context switches.
+ */
+namespace {
+  const uint32 SLICE = 100;
+  const uint32 NB_ROUNDS = 500;
+  const uint32 STACK_SIZE = 64;
+
+  Mutex mutex;
+  bool done;
+
+  class Task: public TaskBase {
+  public:
+    Task(Priority priority) : TaskBase("task", m_stack, STACK_SIZE, priority),
+      total_wait(0), max_wait(0), rounds(0) {
+    }
+
+    uint32 total_wait, max_wait;
+    uint32 rounds;
+
+  protected:
+    /**
+     * Takes the mutex and counts the wait
+     */
+    void acquire() {
+      const uint32 start = test::host::now();
+      mutex.acquire();
+      const uint32 wait = test::host::now() - start;
+      total_wait += wait;
+      if (wait > max_wait)
+        max_wait = wait;
+      ++rounds;
+    }
+
+  private:
+    uint32 m_stack[STACK_SIZE];
+  };
+
+  class Worker: public Task {
+  public:
+    Worker() : Task(PRIORITY_DEFAULT) {
+    }
+
+  protected:
+    void run() {
+      while (!done) {
+        acquire();
+        for (uint32 i = 0; i < 3; ++i) {
+          test::host::work(SLICE);
+          OS::yield();
+        }
+        mutex.release();
+        OS::yield();
+      }
+    }
+  };
+
+  class Busy: public TaskBase {
+  public:
+    Busy() : TaskBase("busy", m_stack, STACK_SIZE, PRIORITY_DEFAULT + 1) {
+    }
+
+  protected:
+    void run() {
+      while (!done) {
+        test::host::work(5 * SLICE);
+        OS::sleep_for(1);
+      }
+    }
+
+  private:
+    uint32 m_stack[STACK_SIZE];
+  };
+
+  class Periodic: public Task {
+  public:
+    Periodic() : Task(PRIORITY_HIGHEST) {
+    }
+
+  protected:
+    void run() {
+      while (rounds < NB_ROUNDS) {
+        OS::sleep_for(1);
+        acquire();
+        test::host::work(SLICE / 2);
+        mutex.release();
+      }
+      done = true;
+    }
+  };
+
+  /**
+   * An acquire() and release() pair with no other task involved
+   */
+  double uncontended_time() {
+    const uint32 count = 10000000;
+    Mutex free;
+    const double start = test::seconds();
+    for (uint32 i = 0; i < count; ++i) {
+      free.acquire();
+      free.release();
+    }
+    return (test::seconds() - start) / count * 1e9;
+  }
+
+  void report(const Task& task, const char* name) {
+    printf("  %s: %u acquisitions, wait %.1f us average, %u max\n", name, task.rounds,
+           task.rounds == 0 ? 0.0 : double(task.total_wait) / task.rounds, task.max_wait);
+  }
+}
+
+int main() {
+  test::host::start_os();
+  printf("Mutex acquire() and release(), uncontended: %.1f ns\n", uncontended_time());
+
+  static Worker first, second;
+  static Busy busy;
+  static Periodic periodic;
+  OS::add(first);
+  OS::add(second);
+  OS::add(busy);
+  OS::add(periodic);
+  const uint32 switches = test::host::counters().switches;
+  const uint32 start = test::host::now();
+  while (!done)
+    OS::sleep_for(10);
+  printf("%u ms of contention, %u context switches\n", (test::host::now() - start) / 1000,
+         test::host::counters().switches - switches);
+  report(periodic, "PRIORITY_HIGHEST, every ms");
+  report(first, "PRIORITY_DEFAULT");
+  report(second, "PRIORITY_DEFAULT");
+  return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ *  bench_polyphase.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/Interpolator.h"
+
+#include <math.h>
+
+using namespace util;
+
+namespace {
+  const uint32 NB_INPUTS = 48000;
+  const int ROUNDS = 100;
+
+  /**
+   * Prints the cost of a 2x, 8 taps per phase resampler per output sample,
+   * next to the linear interpolator it replaced in AudioPlayer
+   */
+  template <typename T>
+  void run(const char* name, double amplitude) {
+    static T in[NB_INPUTS], out[2 * NB_INPUTS + 1];
+    for (uint32 i = 0; i < NB_INPUTS; ++i)
+      in[i] = T(float(amplitude * (1 + sin(2 * M_PI * 0.05 * i)) / 2));
+
+    PolyphaseInterpolator<T, 2, 1, 8> polyphase;
+    uint32 total = 0;
+    double start = test::seconds();
+    for (int r = 0; r < ROUNDS; ++r)
+      total += polyphase.process(in, NB_INPUTS, out);
+    const double polyphase_ns = (test::seconds() - start) / total * 1e9;
+
+    LinearInterpolator<T> linear;
+    total = 0;
+    start = test::seconds();
+    for (int r = 0; r < ROUNDS; ++r) {
+      for (uint32 i = 0; i < NB_INPUTS; ) {
+        if (linear.interpolate(in[i], out[total % (2 * NB_INPUTS)]))
+          ++i;
+        ++total;
+      }
+    }
+    const double linear_ns = (test::seconds() - start) / total * 1e9;
+
+    printf("  %-7s polyphase %.1f ns, linear %.1f ns per output sample\n", name, polyphase_ns, linear_ns);
+  }
+}
+
+int main() {
+  printf("2x resampling\n");
+  run<int16>("int16", 30000);
+  run<uint16>("uint16", 60000);
+  run<uint8>("uint8", 250);
+  run<float>("float", 1);
+  run<Q<16> >("Q<16>", 1);
+  return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ *  bench_scheduler.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "host_os.h"
+#include "../os/OS_Event.h"
+
+using os::OS;
+using os::TaskBase;
+
+/**
+ * Wakeup latency of a high priority task behind busy background tasks.
+ * Ten PRIORITY_DEFAULT tasks work in 100us slices, yielding in between.
+ * An interrupt signals an event at varying dates; the task waiting for it records
+ * how many slices started, and how long it took, until it ran. The waiting task
+ * is PRIORITY_HIGHEST, then PRIORITY_DEFAULT, that is, plain round-robin.
+ */
+namespace {
+  const uint32 NB_BACKGROUND = 10;
+  const uint32 SLICE = 100;
+  const uint32 NB_WAKEUPS = 1000;
+  const uint32 STACK_SIZE = 64;
+
+  os::Event event;
+  uint32 raised_date;
+  uint32 slices;
+  uint32 slices_at_raise;
+
+  void raise(void* data) {
+    raised_date = test::host::now();
+    slices_at_raise = slices;
+    os::Event::interrupt_callback(data);
+  }
+
+  class Background: public TaskBase {
+  public:
+    Background() : TaskBase("background", m_stack, STACK_SIZE) {
+    }
+
+  protected:
+    void run() {
+      for (;;) {
+        ++slices;
+        test::host::work(SLICE);
+        OS::yield();
+      }
+    }
+
+  private:
+    uint32 m_stack[STACK_SIZE];
+  };
+
+  class Waiter: public TaskBase {
+  public:
+    Waiter(Priority priority) : TaskBase("waiter", m_stack, STACK_SIZE, priority),
+      total_slices(0), max_slices(0), total_latency(0), max_latency(0), wakeups(0) {
+    }
+
+    uint32 total_slices, max_slices;
+    uint32 total_latency, max_latency;
+    uint32 wakeups;
+
+  protected:
+    void run() {
+      uint32 seed = 1;
+      while (wakeups < NB_WAKEUPS) {
+        // Next wakeup from 1 to 4 slices ahead, at any point of a slice
+        seed = seed * 1664525 + 1013904223;
+        test::host::raise_at(test::host::now() + SLICE + (seed >> 8) % (3 * SLICE), &raise, &event);
+        event.wait();
+
+        const uint32 s = slices - slices_at_raise;
+        const uint32 latency = test::host::now() - raised_date;
+        total_slices += s;
+        total_latency += latency;
+        if (s > max_slices)
+          max_slices = s;
+        if (latency > max_latency)
+          max_latency = latency;
+        ++wakeups;
+      }
+    }
+
+  private:
+    uint32 m_stack[STACK_SIZE];
+  };
+
+  /**
+   * A task yielding with no other task of its priority ready: the scheduling path alone
+   */
+  double yield_time() {
+    const uint32 count = 10000000;
+    const double start = test::seconds();
+    for (uint32 i = 0; i < count; ++i)
+      OS::yield();
+    return (test::seconds() - start) / count * 1e9;
+  }
+
+  void measure(Waiter& waiter, const char* name) {
+    OS::add(waiter);
+    // The main task is one more background task until the wakeups are done
+    while (waiter.wakeups < NB_WAKEUPS) {
+      ++slices;
+      test::host::work(SLICE);
+      OS::yield();
+    }
+    printf("  %s: slices started before running %.2f average, %u max; latency %.1f us average, %u max\n",
+           name, double(waiter.total_slices) / waiter.wakeups, waiter.max_slices,
+           double(waiter.total_latency) / waiter.wakeups, waiter.max_latency);
+  }
+}
+
+int main() {
+  test::host::start_os();
+  printf("OS::yield() alone: %.1f ns\n", yield_time());
+
+  static Background background[NB_BACKGROUND];
+  for (uint32 i = 0; i < NB_BACKGROUND; ++i)
+    OS::add(background[i]);
+  printf("%u background tasks, %u us slices, %u wakeups\n", NB_BACKGROUND + 1, SLICE, NB_WAKEUPS);
+
+  static Waiter high(TaskBase::PRIORITY_HIGHEST);
+  measure(high, "PRIORITY_HIGHEST");
+  static Waiter peer(TaskBase::PRIORITY_DEFAULT);
+  measure(peer, "PRIORITY_DEFAULT");
+  return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ *  bench_sha1.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/SHA1.h"
+
+#include <stdlib.h>
+
+using namespace util;
+
+namespace {
+  const uint32 BUFFER_SIZE = 65536;
+  const int ROUNDS = 1000;
+  uint8 data[BUFFER_SIZE + 8];
+  volatile uint8 sink;
+
+  /**
+   * @return the throughput in MB/s, hashing 64KB buffers starting at the given offset
+   */
+  double throughput(uint32 offset) {
+    const double start = test::seconds();
+    for (int i = 0; i < ROUNDS; ++i) {
+      SHA1 sha;
+      sink = sha.process(data + offset, BUFFER_SIZE).get_result()[0];
+    }
+    const double elapsed = test::seconds() - start;
+    return ROUNDS * BUFFER_SIZE / 1e6 / elapsed;
+  }
+}
+
+int main() {
+  for (uint32 i = 0; i < sizeof data; ++i)
+    data[i] = uint8(rand());
+
+  printf("SHA1, %d bytes per hasher\n", int(sizeof(SHA1)));
+  printf("  aligned:   %.0f MB/s\n", throughput(0));
+  printf("  unaligned: %.0f MB/s\n", throughput(1));
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ *  bench_variance.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/Variance.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace util;
+
+/**
+ * Accumulation of 32M values, one sample or one block at a time, on 1 to 8
+ * host threads with a Variance each, merged at the end. Threads run concurrently,
+ * so the time is wall clock time, and the speedup is against the single thread.
+ */
+namespace {
+  const uint32 NB_VALUES = 1 << 25;
+  const uint32 BLOCK_SIZE = 256;
+  const uint32 MAX_THREADS = 8;
+  std::vector<double> data;
+
+  double wall_seconds() {
+    timeval t;
+    gettimeofday(&t, 0);
+    return t.tv_sec + t.tv_usec * 1e-6;
+  }
+
+  struct Part {
+    uint32 begin;
+    uint32 end;
+    bool by_block;
+    Variance<double> variance;
+  };
+
+  void* accumulate(void* arg) {
+    Part& part = *static_cast<Part*>(arg);
+    Variance<double>& v = part.variance;
+    const uint32 end = part.end;
+    if (part.by_block) {
+      for (uint32 i = part.begin; i < end; i += BLOCK_SIZE)
+        v.add_block(&data[i], end - i < BLOCK_SIZE ? end - i : BLOCK_SIZE);
+    } else {
+      for (uint32 i = part.begin; i < end; ++i)
+        v.add_data(data[i]);
+    }
+    return 0;
+  }
+
+  /**
+   * Accumulates the data split in nb_threads parts, each on its own thread,
+   * and merges the parts in order
+   * @return the time taken in seconds
+   */
+  double run(bool by_block, uint32 nb_threads, Variance<double>& all) {
+    Part parts[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    const double start = wall_seconds();
+    for (uint32 t = 0; t < nb_threads; ++t) {
+      parts[t].begin = uint32(uint64(NB_VALUES) * t / nb_threads);
+      parts[t].end = uint32(uint64(NB_VALUES) * (t + 1) / nb_threads);
+      parts[t].by_block = by_block;
+      pthread_create(&threads[t], 0, &accumulate, &parts[t]);
+    }
+    for (uint32 t = 0; t < nb_threads; ++t) {
+      pthread_join(threads[t], 0);
+      all.merge(parts[t].variance);
+    }
+    return wall_seconds() - start;
+  }
+
+  bool close(double a, double b) {
+    return fabs(a - b) <= 1e-9 * fabs(b);
+  }
+}
+
+int main() {
+  data.resize(NB_VALUES);
+  srand(1);
+  for (uint32 i = 0; i < NB_VALUES; ++i) {
+    const double u = rand() / double(RAND_MAX);
+    data[i] = 100 + u * u * u * 10;
+  }
+
+  printf("Variance<double>, %u values, %ld processors online\n", NB_VALUES, sysconf(_SC_NPROCESSORS_ONLN));
+  for (int by_block = 0; by_block < 2; ++by_block) {
+    Variance<double> single;
+    const double t1 = run(by_block != 0, 1, single);
+    printf("  %-9s mean %.9f variance %.9f skewness %.6f\n", by_block ? "add_block" : "add_data",
+           single.get_mean(), single.get_variance(), single.get_skewness());
+    for (uint32 nb_threads = 1; nb_threads <= MAX_THREADS; nb_threads *= 2) {
+      Variance<double> all;
+      const double t = nb_threads == 1 ? t1 : run(by_block != 0, nb_threads, all);
+      const bool same = nb_threads == 1 || (close(all.get_mean(), single.get_mean())
+          && close(all.get_variance(), single.get_variance()) && fabs(all.get_skewness() - single.get_skewness()) < 1e-6);
+      printf("    %u thread(s): %.3fs, %.2fx%s\n", nb_threads, t, t1 / t, same ? "" : ", WRONG RESULT");
+    }
+  }
+  return 0;
+}
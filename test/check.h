@@ -0,0 +1,55 @@
+/*
+ *  check.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+#pragma once
+
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * Minimal support for the host test programs: each failed check is printed
+ * with its location, and check_result() gives the exit code of the program.
+ */
+namespace test {
+
+  inline
+  int& failure_count() {
+    static int count = 0;
+    return count;
+  }
+
+  inline
+  bool check(bool ok, const char* expression, const char* file, int line) {
+    if (!ok) {
+      printf("%s:%d: check failed: %s\n", file, line, expression);
+      ++failure_count();
+    }
+    return ok;
+  }
+
+  /**
+   * @return the exit code of the test program, after printing a summary
+   */
+  inline
+  int check_result(const char* name) {
+    if (failure_count() == 0)
+      printf("%s: ok\n", name);
+    else
+      printf("%s: %d failed\n", name, failure_count());
+    return failure_count() == 0 ? 0 : 1;
+  }
+
+  /**
+   * @return the processor time used so far, in seconds, for the benchmarks
+   */
+  inline
+  double seconds() {
+    return double(clock()) / CLOCKS_PER_SEC;
+  }
+}
+
+#define CHECK(E) test::check((E), #E, __FILE__, __LINE__)
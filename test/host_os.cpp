@@ -0,0 +1,272 @@
+/*
+ *  host_os.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "host_os.h"
+#include "../platform/HAL_Processor.h"
+
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+namespace {
+  const uint32 NB_RAISED = 32;
+  const uint32 CONTEXT_STACK_SIZE = 64 * 1024;
+
+  /**
+   * An interrupt raised by raise_at()
+   */
+  struct Raised {
+    uint32 date;
+    void (*handler)(void*);
+    void* data;
+    bool scheduled;
+    bool pending;
+  };
+
+  uint32 date = 0;
+  bool interrupts_enabled = true;
+  bool in_interrupt = false;
+  Raised raised[NB_RAISED];
+  test::host::Counters counters;
+
+  // Timer registers: match control (one interrupt bit per channel),
+  // match values and pending matches
+  uint32 mcr[hal::Timer::NB_TIMERS];
+  uint32 mr[hal::Timer::NB_TIMERS][hal::Timer::NB_MATCH_CHANNELS];
+  uint32 ir[hal::Timer::NB_TIMERS];
+  hal::InterruptHandler* handlers[hal::Timer::NB_TIMERS];
+
+  hal::Timer os_timer(hal::Timer::TIMER0);
+
+  /**
+   * @return true if a date is within (date, end], the counter wrapping around
+   */
+  bool is_due(uint32 when, uint32 end) {
+    return when - date - 1 < end - date;
+  }
+
+  void run_interrupts() {
+    in_interrupt = true;
+    for (uint32 t = 0; t < hal::Timer::NB_TIMERS; ++t) {
+      if (ir[t] != 0) {
+        ++counters.interrupts;
+        oo_irq_handler(handlers[t]);
+      }
+    }
+    for (uint32 i = 0; i < NB_RAISED; ++i) {
+      if (raised[i].pending) {
+        raised[i].pending = false;
+        ++counters.interrupts;
+        raised[i].handler(raised[i].data);
+      }
+    }
+    in_interrupt = false;
+  }
+
+  bool has_pending_interrupt() {
+    for (uint32 t = 0; t < hal::Timer::NB_TIMERS; ++t)
+      if (ir[t] != 0)
+        return true;
+    for (uint32 i = 0; i < NB_RAISED; ++i)
+      if (raised[i].pending)
+        return true;
+    return false;
+  }
+
+  /**
+   * Moves the date to the first interrupt due until end, if any, and makes it pending
+   * @return false if there is none
+   */
+  bool next_interrupt(uint32 end) {
+    bool found = false;
+    uint32 first = end;
+    for (uint32 t = 0; t < hal::Timer::NB_TIMERS; ++t)
+      for (uint32 c = 0; c < hal::Timer::NB_MATCH_CHANNELS; ++c)
+        if ((mcr[t] & (1 << (3 * c))) && is_due(mr[t][c], first)) {
+          first = mr[t][c];
+          found = true;
+        }
+    for (uint32 i = 0; i < NB_RAISED; ++i)
+      if (raised[i].scheduled && is_due(raised[i].date, first)) {
+        first = raised[i].date;
+        found = true;
+      }
+    if (!found)
+      return false;
+
+    date = first;
+    for (uint32 t = 0; t < hal::Timer::NB_TIMERS; ++t)
+      for (uint32 c = 0; c < hal::Timer::NB_MATCH_CHANNELS; ++c)
+        if ((mcr[t] & (1 << (3 * c))) && mr[t][c] == first)
+          ir[t] |= 1 << c;
+    for (uint32 i = 0; i < NB_RAISED; ++i)
+      if (raised[i].scheduled && raised[i].date == first) {
+        raised[i].scheduled = false;
+        raised[i].pending = true;
+      }
+    return true;
+  }
+
+  void count_match_write() {
+    if (interrupts_enabled && !in_interrupt)
+      ++counters.unmasked_match_writes;
+  }
+
+  std::map<os::TaskBase*, ucontext_t*> contexts;
+  os::TaskBase* starting_task;
+  void (*starting_entry)(os::TaskBase*);
+
+  void start_task() {
+    starting_entry(starting_task);
+    // The task is over
+    for (;;)
+      os::OS::suspend();
+  }
+}
+
+namespace test {
+  namespace host {
+    hal::Timer& get_timer() {
+      return os_timer;
+    }
+
+    void start_os() {
+      os_timer.configure(1000000);
+      os_timer.start();
+      os::OS::set_timer(os_timer, hal::Timer::MATCH0);
+      os::OS::start();
+    }
+
+    void work(uint32 us) {
+      const uint32 end = date + us;
+      while (next_interrupt(end)) {
+        if (interrupts_enabled)
+          run_interrupts();
+      }
+      date = end;
+    }
+
+    uint32 now() {
+      return date;
+    }
+
+    void raise_at(uint32 when, void (*handler)(void*), void* data) {
+      for (uint32 i = 0; i < NB_RAISED; ++i) {
+        if (!raised[i].scheduled && !raised[i].pending) {
+          Raised r = { when, handler, data, true, false };
+          raised[i] = r;
+          return;
+        }
+      }
+      printf("host_os: more than %u interrupts raised\n", NB_RAISED);
+      abort();
+    }
+
+    Counters& counters() {
+      return ::counters;
+    }
+  }
+}
+
+namespace os {
+  void host_switch_context(TaskBase* from, TaskBase* to, void (*entry)(TaskBase*)) {
+    ++counters.switches;
+    ucontext_t*& from_context = contexts[from];
+    if (from_context == 0)
+      from_context = new ucontext_t;
+    ucontext_t*& to_context = contexts[to];
+    if (to_context == 0) {
+      to_context = new ucontext_t;
+      getcontext(to_context);
+      to_context->uc_stack.ss_sp = malloc(CONTEXT_STACK_SIZE);
+      to_context->uc_stack.ss_size = CONTEXT_STACK_SIZE;
+      to_context->uc_link = 0;
+      makecontext(to_context, &start_task, 0);
+      starting_task = to;
+      starting_entry = entry;
+    }
+    swapcontext(from_context, to_context);
+  }
+}
+
+namespace hal {
+  void Processor::disable_interrupts() {
+    interrupts_enabled = false;
+  }
+
+  void Processor::enable_interrupts() {
+    interrupts_enabled = true;
+    if (has_pending_interrupt())
+      run_interrupts();
+  }
+
+  uint32 Processor::get_cpsr() {
+    return 0;
+  }
+
+  void Processor::idle() {
+    ++counters.idles;
+    if (has_pending_interrupt())
+      return;
+    const uint32 start = date;
+    // Any date ahead, the counter wrapping around
+    if (!next_interrupt(date - 1)) {
+      printf("host_os: idle with no interrupt to come, at %u us\n", date);
+      abort();
+    }
+    counters.idle_time += date - start;
+  }
+
+  Timer::MatchInfo Timer::matchInfo[NB_TIMERS][NB_MATCH_CHANNELS];
+
+  bool Timer::configure(uint32 rate) {
+    m_rate = rate;
+    handlers[m_timerId] = this;
+    return true;
+  }
+
+  void Timer::start() {
+  }
+
+  void Timer::stop() {
+  }
+
+  void Timer::match(MatchChannel channel, uint32 value, MatchCallback cb, void *cbData) {
+    count_match_write();
+    matchInfo[m_timerId][channel].value = value;
+    matchInfo[m_timerId][channel].callback = cb;
+    matchInfo[m_timerId][channel].callbackData = cbData;
+    mr[m_timerId][channel] = value;
+    mcr[m_timerId] &= ~(0x07 << (3 * channel));
+    mcr[m_timerId] |= 1 << (3 * channel);
+  }
+
+  void Timer::stop_match(MatchChannel channel) {
+    count_match_write();
+    mcr[m_timerId] &= ~(0x07 << (3 * channel));
+  }
+
+  uint32 Timer::getTimerValue() const {
+    return date;
+  }
+
+  void Timer::handle_irq() {
+    for (uint32 channel = MATCH0; channel <= MATCH3; ++channel) {
+      const uint32 bitmask = 1 << channel;
+      if (ir[m_timerId] & bitmask) {
+        ir[m_timerId] &= ~bitmask;
+        MatchInfo& info = matchInfo[m_timerId][channel];
+        if (info.callback != 0) {
+          info.value = mr[m_timerId][channel];
+          mr[m_timerId][channel] = info.callback(*this, MatchChannel(channel), info);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,57 @@
+/*
+ *  host_os.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+#pragma once
+
+#include "../os/OS_os.h"
+
+/**
+ * Host build of the OS, for the tests and benchmarks of the scheduler.
+ * Tasks switch with ucontext. The processor and the timers are simulated: time,
+ * in microseconds, only moves when a task works or when the OS idles.
+ * An interrupt due while interrupts are enabled runs at once, over the running task;
+ * one due while they are disabled runs as soon as they are enabled again.
+ * Idling jumps to the next interrupt, as the processor would sleep until it.
+ */
+namespace test {
+  namespace host {
+    struct Counters {
+      uint32 switches;        // context switches
+      uint32 idles;           // times the processor idled
+      uint32 idle_time;       // microseconds spent idling
+      uint32 interrupts;      // interrupt handlers run
+      uint32 unmasked_match_writes;  // timer match registers updated by a task with interrupts enabled
+    };
+
+    /**
+     * The OS timer, TIMER0 at 1MHz, on MATCH0
+     */
+    hal::Timer& get_timer();
+
+    /**
+     * Hands the timer to the OS and starts it, the caller becoming the main task
+     */
+    void start_os();
+
+    /**
+     * Keeps the processor busy for a duration, running the interrupts due meanwhile
+     */
+    void work(uint32 us);
+
+    /**
+     * @return the date, in microseconds
+     */
+    uint32 now();
+
+    /**
+     * Raises an interrupt at a date: handler(data) runs then, or once interrupts are enabled
+     */
+    void raise_at(uint32 date, void (*handler)(void*), void* data);
+
+    Counters& counters();
+  }
+}
@@ -0,0 +1,173 @@
+/*
+ *  host_serial.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+#pragma once
+
+#include "host_os.h"
+
+namespace test {
+  namespace host {
+    /**
+     * A serial port receiving bytes by interrupt, on the host build of the OS.
+     * As hal::Serial in interrupt mode, it runs its receive callback from the
+     * interrupt handler once the byte is buffered. Each poll of the receive
+     * buffer takes POLL_TIME of processor time.
+     * Bytes written go to a FIFO of SEND_FIFO_SIZE bytes sent one every SEND_TIME,
+     * the send callback running from the interrupt handler each time one is sent.
+     */
+    class Serial: NoCopy {
+    public:
+      typedef void (*Callback)(void *cbData);
+
+      static const uint32 POLL_TIME = 2;  // us
+      static const uint32 SEND_FIFO_SIZE = 16;
+      static const uint32 SEND_TIME = 100;  // us per byte
+      static const uint32 SENT_SIZE = 256;
+
+      Serial();
+
+      void set_receive_callback(Callback cb, void *cbData = 0);
+
+      void set_send_callback(Callback cb, void *cbData = 0);
+
+      /**
+       * Receives bytes 0, 1, 2... one every period, the first one period from now
+       */
+      void receive(uint32 count, uint32 period);
+
+      uint32 read(uint8 *bytes, uint32 count);
+
+      bool get(uint8& c);
+
+      /**
+       * Queues as many bytes as the send FIFO has room for
+       * @return the number of bytes queued
+       */
+      uint32 write(const uint8 *bytes, uint32 count);
+
+      /**
+       * @return the bytes sent so far, at most SENT_SIZE of them
+       */
+      const uint8* get_sent() const {
+        return m_sent;
+      }
+
+      uint32 get_sent_count() const {
+        return m_sent_count;
+      }
+
+      /**
+       * @return the number of polls, reads or gets, that found no byte
+       */
+      uint32 get_empty_polls() const {
+        return m_empty_polls;
+      }
+
+    private:
+      static void on_receive(void* serial);
+      static void on_send(void* serial);
+
+      static const uint32 BUFFER_SIZE = 64;
+      uint8 m_buffer[BUFFER_SIZE];
+      uint32 m_put, m_get;
+
+      uint32 m_to_receive;
+      uint32 m_period;
+      uint8 m_next;
+      uint32 m_empty_polls;
+
+      uint8 m_send_fifo[SEND_FIFO_SIZE];
+      uint32 m_send_put, m_send_get;
+      uint8 m_sent[SENT_SIZE];
+      uint32 m_sent_count;
+
+      Callback m_receive_callback;
+      void *m_receive_data;
+      Callback m_send_callback;
+      void *m_send_data;
+    };
+
+    inline
+    Serial::Serial() : m_put(0), m_get(0), m_to_receive(0), m_period(0), m_next(0), m_empty_polls(0),
+      m_send_put(0), m_send_get(0), m_sent_count(0),
+      m_receive_callback(0), m_receive_data(0), m_send_callback(0), m_send_data(0) {
+    }
+
+    inline
+    void Serial::set_receive_callback(Callback cb, void *cbData) {
+      m_receive_callback = cb;
+      m_receive_data = cbData;
+    }
+
+    inline
+    void Serial::set_send_callback(Callback cb, void *cbData) {
+      m_send_callback = cb;
+      m_send_data = cbData;
+    }
+
+    inline
+    void Serial::receive(uint32 count, uint32 period) {
+      m_to_receive = count;
+      m_period = period;
+      if (count > 0)
+        raise_at(now() + period, &on_receive, this);
+    }
+
+    inline
+    uint32 Serial::read(uint8 *bytes, uint32 count) {
+      work(POLL_TIME);
+      uint32 n = 0;
+      while (n < count && m_get != m_put)
+        bytes[n++] = m_buffer[m_get++ % BUFFER_SIZE];
+      if (n == 0)
+        ++m_empty_polls;
+      return n;
+    }
+
+    inline
+    bool Serial::get(uint8& c) {
+      return read(&c, 1) == 1;
+    }
+
+    inline
+    uint32 Serial::write(const uint8 *bytes, uint32 count) {
+      work(POLL_TIME);
+      uint32 n = 0;
+      while (n < count && m_send_put - m_send_get < SEND_FIFO_SIZE) {
+        if (m_send_put == m_send_get)
+          raise_at(now() + SEND_TIME, &on_send, this);
+        m_send_fifo[m_send_put++ % SEND_FIFO_SIZE] = bytes[n++];
+      }
+      return n;
+    }
+
+    inline
+    void Serial::on_receive(void* serial) {
+      Serial& s = *static_cast<Serial*>(serial);
+      if (s.m_put - s.m_get < BUFFER_SIZE)
+        s.m_buffer[s.m_put++ % BUFFER_SIZE] = s.m_next;
+      ++s.m_next;
+      if (--s.m_to_receive > 0)
+        raise_at(now() + s.m_period, &on_receive, &s);
+      if (s.m_receive_callback != 0)
+        s.m_receive_callback(s.m_receive_data);
+    }
+
+    inline
+    void Serial::on_send(void* serial) {
+      Serial& s = *static_cast<Serial*>(serial);
+      const uint8 c = s.m_send_fifo[s.m_send_get++ % SEND_FIFO_SIZE];
+      if (s.m_sent_count < SENT_SIZE)
+        s.m_sent[s.m_sent_count] = c;
+      ++s.m_sent_count;
+      if (s.m_send_put != s.m_send_get)
+        raise_at(now() + SEND_TIME, &on_send, &s);
+      if (s.m_send_callback != 0)
+        s.m_send_callback(s.m_send_data);
+    }
+  }
+}
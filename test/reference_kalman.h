@@ -0,0 +1,144 @@
+/*
+ *  reference_kalman.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+#pragma once
+
+#include "../util/LinearAlgebra.h"
+
+#include <math.h>
+
+namespace test {
+  /**
+   * The textbook Kalman filter, written with the la free functions and
+   * temporaries, as la::Kalman was before the matrix expressions.
+   * The tests and benchmarks compare la::Kalman against it.
+   */
+  template <class Traits>
+  class ReferenceKalman {
+  public:
+    typedef typename Traits::value_type k_real_type;
+    enum {
+      STATE_SIZE = Traits::state_size,
+      MEAS_SIZE = Traits::meas_size,
+      INPUT_SIZE = Traits::input_size
+    };
+
+    typedef la::Matrix<STATE_SIZE, 1, k_real_type> state_type;
+    typedef la::Matrix<STATE_SIZE, STATE_SIZE, k_real_type> state_transition_type;
+    typedef la::Matrix<INPUT_SIZE, 1, k_real_type> input_type;
+    typedef la::Matrix<STATE_SIZE, INPUT_SIZE, k_real_type> input_to_state_type;
+    typedef la::Matrix<MEAS_SIZE, 1, k_real_type> meas_type;
+    typedef la::Matrix<MEAS_SIZE, STATE_SIZE, k_real_type> meas_gain_type;
+    typedef la::Matrix<MEAS_SIZE, MEAS_SIZE, k_real_type> meas_noise_covariance_type;
+    typedef la::Matrix<STATE_SIZE, STATE_SIZE, k_real_type> prob_type;
+    typedef la::Matrix<STATE_SIZE, MEAS_SIZE, k_real_type> kalman_gain_type;
+
+    state_type X;
+    state_transition_type A;
+    input_type U;
+    input_to_state_type B;
+    meas_gain_type H;
+    prob_type Q;
+    meas_noise_covariance_type R;
+    prob_type P;
+    prob_type I;
+
+    state_type X_predicted;
+    prob_type P_predicted;
+    kalman_gain_type K;
+
+    ReferenceKalman() {
+      la::set_identity(I);
+      la::set_zero(K);
+    }
+
+    void update_time() {
+      using namespace la;
+
+      state_type X_from_time; mult(X_from_time, A, X);
+      state_type X_from_input; mult(X_from_input, B, U);
+      plus(X_predicted, X_from_time, X_from_input);
+
+      prob_type AP; mult(AP, A, P);
+      prob_type At; transpose(At, A);
+      prob_type APAt; mult(APAt, AP, At);
+      plus(P_predicted, APAt, Q);
+
+      Matrix<STATE_SIZE, MEAS_SIZE, k_real_type> Ht; transpose(Ht, H);
+      kalman_gain_type PHt; mult(PHt, P_predicted, Ht);
+      meas_noise_covariance_type HPHt; mult(HPHt, H, PHt);
+      meas_noise_covariance_type HPHt_R; plus(HPHt_R, HPHt, R);
+      meas_noise_covariance_type inv_HPHt_R; set_zero(inv_HPHt_R);
+      if (invert(inv_HPHt_R, HPHt_R))
+        mult(K, PHt, inv_HPHt_R);
+    }
+
+    void update_measurement(const meas_type& Z) {
+      using namespace la;
+
+      meas_type Z_predicted; mult(Z_predicted, H, X_predicted);
+      meas_type J; minus(J, Z, Z_predicted);
+
+      state_type KInnov; mult(KInnov, K, J);
+      plus(X, X_predicted, KInnov);
+
+      prob_type KH; mult(KH, K, H);
+      prob_type I_KH; minus(I_KH, I, KH);
+      mult(P, I_KH, P_predicted);
+    }
+  };
+
+  /**
+   * Filter sizes for the tests and benchmarks
+   */
+  template <uint32 N, uint32 M, typename T = float>
+  struct KalmanTraits {
+    typedef T value_type;
+    enum {
+      state_size = N,
+      meas_size = M,
+      input_size = 1
+    };
+  };
+
+  /**
+   * A stable, time invariant system: damped states coupled to their neighbour,
+   * the input driving the second state, every other state measured
+   */
+  template <class Filter>
+  void setup_kalman(Filter& k) {
+    typedef typename Filter::k_real_type T;
+    la::set_zero(k.X); la::set_zero(k.U);
+    la::set_zero(k.A); la::set_zero(k.B); la::set_zero(k.H);
+    la::set_zero(k.Q); la::set_zero(k.R); la::set_zero(k.P);
+    for (uint32 i = 0; i < Filter::STATE_SIZE; ++i) {
+      k.A(i, i) = T(0.95f);
+      if (i + 1 < Filter::STATE_SIZE)
+        k.A(i, i + 1) = T(0.1f);
+      k.Q(i, i) = T(0.01f);
+      k.P(i, i) = T(1.0f);
+    }
+    k.B(Filter::STATE_SIZE > 1 ? 1 : 0, 0) = T(0.1f);
+    for (uint32 j = 0; j < Filter::MEAS_SIZE; ++j) {
+      k.H(j, (2 * j) % Filter::STATE_SIZE) = T(1.0f);
+      k.R(j, j) = T(0.1f * (j + 1));
+    }
+    k.U(0, 0) = T(0.1f);
+  }
+
+  /**
+   * A noisy measurement of slow sines, the same for every filter at step n
+   */
+  template <class Meas>
+  void measurement(Meas& Z, uint32 n) {
+    typedef typename Meas::value_type T;
+    for (uint32 j = 0; j < Meas::ROWS; ++j) {
+      const uint32 noise = (n * 2654435761u + j * 40503u) >> 24;
+      Z(j, 0) = T(float(sin(0.01 * (j + 1) * n) + (int32(noise) - 128) / 512.0));
+    }
+  }
+}
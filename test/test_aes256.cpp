@@ -0,0 +1,179 @@
+/*
+ *  test_aes256.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/AES256_wrapper.h"
+#include "../util/AES.h"
+#include "../util/AES_ni.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace util;
+
+namespace {
+  /**
+   * FIPS-197 appendix C.3, AES-256
+   */
+  const uint8 KEY[32] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f
+  };
+  const uint8 PLAINTEXT[16] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+  };
+  const uint8 CIPHERTEXT[16] = {
+    0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89
+  };
+
+  /**
+   * Known answer through the word-oriented rounds of AES256
+   */
+  void test_known_answer_table() {
+    AES256 aes;
+    aes.set_key(KEY);
+
+    uint8 block[16];
+    memcpy(block, PLAINTEXT, 16);
+    aes.encrypt_ecb(block);
+    CHECK(memcmp(block, CIPHERTEXT, 16) == 0);
+    aes.decrypt_ecb(block);
+    CHECK(memcmp(block, PLAINTEXT, 16) == 0);
+
+    // CBC with a zero vector starts with the same block
+    memcpy(block, PLAINTEXT, 16);
+    aes.reset().encrypt(block);
+    CHECK(memcmp(block, CIPHERTEXT, 16) == 0);
+  }
+
+  /**
+   * Known answer through util::AES, which runs the AES-NI path when the processor
+   * has it. Five blocks cover both the 4 block pipeline and the single block tail.
+   */
+  void test_known_answer_aes() {
+    uint8 in[5 * 16], out[5 * 16], back[5 * 16];
+    for (int i = 0; i < 5; ++i)
+      memcpy(in + 16 * i, PLAINTEXT, 16);
+
+    AES aes;
+    aes.SetParameters(256, 128);
+    aes.StartEncryption(KEY);
+    aes.Encrypt(in, out, 5, AES::ECB);
+    for (int i = 0; i < 5; ++i)
+      CHECK(memcmp(out + 16 * i, CIPHERTEXT, 16) == 0);
+
+    uint8 block[16];
+    aes.EncryptBlock(PLAINTEXT, block);
+    CHECK(memcmp(block, CIPHERTEXT, 16) == 0);
+
+    aes.StartDecryption(KEY);
+    aes.Decrypt(out, back, 5, AES::ECB);
+    CHECK(memcmp(back, in, sizeof in) == 0);
+    aes.DecryptBlock(CIPHERTEXT, block);
+    CHECK(memcmp(block, PLAINTEXT, 16) == 0);
+  }
+
+  /**
+   * Both implementations agree in CBC mode on random keys and data
+   */
+  void test_cross_check() {
+    for (int t = 0; t < 200; ++t) {
+      AES256::key_type key;
+      uint8 in[8 * 16], table_out[8 * 16], aes_out[8 * 16];
+      for (uint32 i = 0; i < sizeof key; ++i)
+        key[i] = uint8(rand());
+      for (uint32 i = 0; i < sizeof in; ++i)
+        in[i] = uint8(rand());
+
+      AES256 table;
+      table.set_key(key);
+      memcpy(table_out, in, sizeof in);
+      table.reset().encrypt(table_out, 8);
+
+      AES aes;
+      aes.SetParameters(256, 128);
+      aes.StartEncryption(key);
+      aes.Encrypt(in, aes_out, 8, AES::CBC);
+      if (!CHECK(memcmp(table_out, aes_out, sizeof in) == 0))
+        return;
+
+      table.reset().decrypt(table_out, 8);
+      if (!CHECK(memcmp(table_out, in, sizeof in) == 0))
+        return;
+    }
+  }
+
+  /**
+   * The AES-NI path gives the same output as the tables for every key size and mode,
+   * from 1 to 9 blocks for the 4 block pipeline and its tail. The CTR counter
+   * crosses a 32 bit wrap, which must leave the nonce alone.
+   */
+  void test_accelerated() {
+    const int key_sizes[] = {128, 192, 256};
+    for (int k = 0; k < 3; ++k) {
+      for (uint32 nblocks = 1; nblocks <= 9; ++nblocks) {
+        uint8 key[32], in[9 * 16];
+        for (uint32 i = 0; i < sizeof key; ++i)
+          key[i] = uint8(rand());
+        for (uint32 i = 0; i < sizeof in; ++i)
+          in[i] = uint8(rand());
+
+        AES fast, reference;
+        fast.SetParameters(key_sizes[k], 128);
+        reference.SetParameters(key_sizes[k], 128);
+        reference.SetAcceleration(false);
+
+        uint8 fast_out[9 * 16], reference_out[9 * 16];
+        const uint32 size = 16 * nblocks;
+        bool same = true;
+        fast.StartEncryption(key);
+        reference.StartEncryption(key);
+        for (int mode = AES::ECB; mode <= AES::CBC; ++mode) {
+          fast.Encrypt(in, fast_out, nblocks, AES::BlockMode(mode));
+          reference.Encrypt(in, reference_out, nblocks, AES::BlockMode(mode));
+          same = same && memcmp(fast_out, reference_out, size) == 0;
+        }
+
+        uint8 fast_counter[16], reference_counter[16];
+        for (uint32 i = 0; i < 12; ++i)
+          fast_counter[i] = reference_counter[i] = uint8(rand());
+        const uint8 wrap[4] = {0xff, 0xff, 0xff, 0xfc};
+        memcpy(fast_counter + 12, wrap, 4);
+        memcpy(reference_counter + 12, wrap, 4);
+        fast.EncryptCTR(fast_counter, in, fast_out, nblocks);
+        reference.EncryptCTR(reference_counter, in, reference_out, nblocks);
+        same = same && memcmp(fast_out, reference_out, size) == 0;
+        same = same && memcmp(fast_counter, reference_counter, 16) == 0;
+
+        fast.StartDecryption(key);
+        reference.StartDecryption(key);
+        for (int mode = AES::ECB; mode <= AES::CBC; ++mode) {
+          fast.Decrypt(in, fast_out, nblocks, AES::BlockMode(mode));
+          reference.Decrypt(in, reference_out, nblocks, AES::BlockMode(mode));
+          same = same && memcmp(fast_out, reference_out, size) == 0;
+        }
+        if (!CHECK(same)) {
+          printf("  %d bit key, %u blocks\n", key_sizes[k], nblocks);
+          return;
+        }
+      }
+    }
+  }
+}
+
+int main() {
+#if defined(AES_HAS_NI)
+  if (!aes_ni::is_supported())
+    printf("test_aes256: no AES-NI, util::AES ran on its tables\n");
+#endif
+  test_known_answer_table();
+  test_known_answer_aes();
+  test_cross_check();
+  test_accelerated();
+  return test::check_result("test_aes256");
+}
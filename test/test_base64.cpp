@@ -0,0 +1,157 @@
+/*
+ *  test_base64.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/Base64Stream.h"
+#include "../util/MemReader.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace util;
+
+namespace {
+  const char* ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  /**
+   * Straightforward encoding, the reference for the bulk paths
+   * @return the number of characters
+   */
+  uint32 reference_encode(const uint8* p, uint32 size, char* out) {
+    uint32 n = 0;
+    for (uint32 i = 0; i < size; i += 3) {
+      const uint32 w = p[i] << 16 | (i + 1 < size ? p[i + 1] << 8 : 0) | (i + 2 < size ? p[i + 2] : 0);
+      out[n++] = ALPHABET[w >> 18];
+      out[n++] = ALPHABET[(w >> 12) & 63];
+      out[n++] = i + 1 < size ? ALPHABET[(w >> 6) & 63] : '=';
+      out[n++] = i + 2 < size ? ALPHABET[w & 63] : '=';
+    }
+    return n;
+  }
+
+  /**
+   * A writer taking at most 5 bytes at a time
+   */
+  class SlowWriter: public Writer {
+  public:
+    SlowWriter() : m_size(0) {
+    }
+
+    size_type write(const uint8* bytes, size_type count) {
+      const size_type n = count > 5 ? 5 : count;
+      memcpy(m_data + m_size, bytes, n);
+      m_size += n;
+      return n;
+    }
+
+    char m_data[1024];
+    size_type m_size;
+  };
+
+  void test_encode_decode() {
+    for (int t = 0; t < 2000; ++t) {
+      uint8 in[400], decoded[400];
+      char expected[600], encoded[600];
+      const uint32 size = rand() % 400;
+      for (uint32 i = 0; i < size; ++i)
+        in[i] = uint8(rand());
+
+      const uint32 chars = reference_encode(in, size, expected);
+      if (!CHECK(Base64Encoder::encode(in, size, encoded) == chars && memcmp(encoded, expected, chars) == 0))
+        return;
+
+      Base64Decoder::size_type decoded_size;
+      Base64Decoder::decode(encoded, chars, decoded, decoded_size);
+      if (!CHECK(decoded_size == size && memcmp(decoded, in, size) == 0))
+        return;
+    }
+  }
+
+  void test_writer() {
+    for (int t = 0; t < 500; ++t) {
+      uint8 in[200];
+      char expected[300];
+      const uint32 size = rand() % 200;
+      for (uint32 i = 0; i < size; ++i)
+        in[i] = uint8(rand());
+
+      SlowWriter slow;
+      Base64Writer writer(slow);
+      for (uint32 done = 0; done < size; ) {
+        uint32 piece = 1 + rand() % 20;
+        if (piece > size - done)
+          piece = size - done;
+        done += writer.write(in + done, piece);
+      }
+      writer.finish();
+      const uint32 chars = reference_encode(in, size, expected);
+      if (!CHECK(slow.m_size == chars && memcmp(slow.m_data, expected, chars) == 0))
+        return;
+    }
+  }
+
+  /**
+   * Reads of any size, including less than a group, with line breaks in the input
+   */
+  void test_reader() {
+    for (int t = 0; t < 2000; ++t) {
+      uint8 in[200], out[200];
+      char encoded[300], text[400];
+      const uint32 size = rand() % 200;
+      for (uint32 i = 0; i < size; ++i)
+        in[i] = uint8(rand());
+
+      const uint32 chars = reference_encode(in, size, encoded);
+      uint32 text_size = 0;
+      for (uint32 i = 0; i < chars; ++i) {
+        text[text_size++] = encoded[i];
+        if (rand() % 40 == 0) {
+          text[text_size++] = '\r';
+          text[text_size++] = '\n';
+        }
+      }
+
+      MemReader source(reinterpret_cast<const uint8*>(text), text_size);
+      Base64Reader reader(source);
+      const uint32 max_read = 1 + rand() % (t % 2 ? 4 : 40);
+      uint32 got = 0;
+      for (;;) {
+        const uint32 r = reader.read(out + got, 1 + rand() % max_read);
+        if (r == 0)
+          break;
+        got += r;
+      }
+      // Only a padded encoding ends with DONE
+      const bool ended = size % 3 == 0 || reader.get_status() == Base64Decoder::DONE;
+      if (!CHECK(got == size && memcmp(out, in, size) == 0 && ended)) {
+        printf("size %u, reads up to %u\n", unsigned(size), unsigned(max_read));
+        return;
+      }
+    }
+  }
+
+  void test_reader_read_all() {
+    const char* text = "SGVsbG8sIHdvcmxk";
+    MemReader source(reinterpret_cast<const uint8*>(text), strlen(text));
+    Base64Reader reader(source);
+    uint8 out[12];
+    CHECK(reader.read_all(out, 5) == 5);
+    CHECK(memcmp(out, "Hello", 5) == 0);
+    CHECK(reader.read(out, 1) == 1 && out[0] == ',');
+    CHECK(reader.read_all(out, 12) == 6);
+    CHECK(memcmp(out, " world", 6) == 0);
+  }
+}
+
+int main() {
+  test_encode_decode();
+  test_writer();
+  test_reader();
+  test_reader_read_all();
+  return test::check_result("test_base64");
+}
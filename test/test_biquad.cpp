@@ -0,0 +1,133 @@
+/*
+ *  test_biquad.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/Biquad.h"
+
+#include <complex>
+#include <math.h>
+
+using namespace util;
+
+namespace {
+  typedef std::complex<double> complex;
+
+  /**
+   * @return the gain of a section at a frequency, from its coefficients
+   */
+  double gain(const BiquadCoefficients& c, double sample_rate, double frequency) {
+    const double w = 2 * M_PI * frequency / sample_rate;
+    const complex z1 = std::polar(1.0, -w);
+    const complex z2 = z1 * z1;
+    return std::abs((double(c.b0) + double(c.b1) * z1 + double(c.b2) * z2) /
+                    (1.0 + double(c.a1) * z1 + double(c.a2) * z2));
+  }
+
+  double db(double g) {
+    return 20 * log10(g);
+  }
+
+  /**
+   * Unity gain at DC, -3dB at the cutoff, including a cutoff far below the sample rate
+   */
+  void test_lowpass() {
+    const double rates[][2] = {{48000, 1000}, {48000, 12000}, {400, 1}};
+    for (uint32 i = 0; i < 3; ++i) {
+      const double fs = rates[i][0], fc = rates[i][1];
+      const BiquadCoefficients c = BiquadDesign::lowpass(float(fs), float(fc), 0.7071f);
+      CHECK(fabs(gain(c, fs, 0) - 1) < 1e-4);
+      CHECK(fabs(db(gain(c, fs, fc)) + 3.0103) < 0.01);
+      CHECK(gain(c, fs, fs / 2) < 1e-6);
+    }
+  }
+
+  void test_highpass() {
+    const double fs = 48000, fc = 300;
+    const BiquadCoefficients c = BiquadDesign::highpass(float(fs), float(fc), 0.7071f);
+    CHECK(gain(c, fs, 0) < 1e-6);
+    CHECK(fabs(db(gain(c, fs, fc)) + 3.0103) < 0.01);
+    CHECK(fabs(gain(c, fs, fs / 2) - 1) < 1e-4);
+  }
+
+  /**
+   * The notch zeros are on the unit circle, within the float rounding of the frequency:
+   * the tone is removed, in the design and once filtered, and the others pass
+   */
+  void test_notch() {
+    const double fs = 8000, f0 = 50;
+    const BiquadCoefficients c = BiquadDesign::notch(float(fs), float(f0), 10);
+    CHECK(c.b0 == c.b2);
+    const double zero = acos(-double(c.b1) / (2 * double(c.b0))) * fs / (2 * M_PI);
+    CHECK(fabs(zero - f0) < 0.005);
+    CHECK(db(gain(c, fs, f0)) < -60);
+    CHECK(db(gain(BiquadDesign::notch(float(fs), 1000, 10), fs, 1000)) < -100);
+    CHECK(fabs(gain(c, fs, 0) - 1) < 1e-4);
+    CHECK(fabs(gain(c, fs, 1000) - 1) < 1e-3);
+
+    BiquadCascade<float, 1> notch;
+    notch.set_section(0, c);
+    double peak = 0;
+    for (uint32 n = 0; n < 4 * 8000; ++n) {
+      const float y = notch.process(float(sin(2 * M_PI * f0 * n / fs)));
+      if (n >= 3 * 8000)
+        peak = fmax(peak, fabs(y));
+    }
+    CHECK(db(peak) < -60);
+  }
+
+  /**
+   * A 4th order Butterworth lowpass as 2 sections: float and Q<24> follow the double
+   * precision cascade of the same coefficients, block and sample by sample alike
+   */
+  void test_cascade() {
+    const float fs = 48000, fc = 2000;
+    const BiquadCoefficients first = BiquadDesign::lowpass(fs, fc, 0.5412f);
+    const BiquadCoefficients second = BiquadDesign::lowpass(fs, fc, 1.3066f);
+    CHECK(fabs(db(gain(first, fs, fc) * gain(second, fs, fc)) + 3.0103) < 0.01);
+
+    BiquadCascade<double, 2> reference;
+    BiquadCascade<float, 2> single, block;
+    BiquadCascade<Q<24>, 2> fixed;
+    reference.set_section(0, first).set_section(1, second);
+    single.set_section(0, first).set_section(1, second);
+    block.set_section(0, first).set_section(1, second);
+    fixed.set_section(0, first).set_section(1, second);
+
+    const uint32 NB_SAMPLES = 4096;
+    static float in[NB_SAMPLES], out[NB_SAMPLES];
+    uint32 seed = 1;
+    for (uint32 n = 0; n < NB_SAMPLES; ++n) {
+      seed = seed * 1664525 + 1013904223;
+      // A tone in the pass band, one in the stop band, noise
+      in[n] = float(0.4 * sin(2 * M_PI * 500 * n / fs) + 0.3 * sin(2 * M_PI * 9000 * n / fs)
+                    + 0.2 * (double(seed >> 8) / (1 << 24) - 0.5));
+    }
+    block.process(in, out, NB_SAMPLES);
+
+    double worst_float = 0, worst_fixed = 0;
+    bool same = true;
+    for (uint32 n = 0; n < NB_SAMPLES; ++n) {
+      const double y = reference.process(in[n]);
+      const float y_float = single.process(in[n]);
+      same = same && y_float == out[n];
+      worst_float = fmax(worst_float, fabs(y_float - y));
+      worst_fixed = fmax(worst_fixed, fabs(fixed.process(Q<24>(in[n])).to_float() - y));
+    }
+    CHECK(same);
+    CHECK(worst_float < 2e-6);
+    CHECK(worst_fixed < 1e-5);
+  }
+}
+
+int main() {
+  test_lowpass();
+  test_highpass();
+  test_notch();
+  test_cascade();
+  return test::check_result("test_biquad");
+}
@@ -0,0 +1,135 @@
+/*
+ *  test_crc32.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/CRC32.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace util;
+
+namespace {
+  const uint32 BUFFER_SIZE = 10000;
+  uint8 data[BUFFER_SIZE];
+  uint8 zeros[BUFFER_SIZE];
+
+  uint32 crc_of(const uint8* p, uint32 size) {
+    CRC32 crc;
+    return crc.process(p, size).get_result();
+  }
+
+  template <typename Engine>
+  uint32 engine_crc_of(const uint8* p, uint32 size) {
+    BasicCRC32<Engine> crc;
+    return crc.process(p, size).get_result();
+  }
+
+  /**
+   * The engines agree with the bitwise one, for every alignment and for sizes
+   * around the word, slice and fold boundaries
+   */
+  void test_engines() {
+    for (uint32 offset = 0; offset < 16; ++offset) {
+      for (uint32 size = 0; size < 1200; size += size < 300 ? 1 : 37) {
+        const uint8* p = data + offset;
+        const uint32 expected = engine_crc_of<CRC32_Bitwise>(p, size);
+        bool ok = CHECK(engine_crc_of<CRC32_Table256>(p, size) == expected);
+        ok = ok && CHECK(engine_crc_of<CRC32_Slice4>(p, size) == expected);
+        ok = ok && CHECK(engine_crc_of<CRC32_Slice8>(p, size) == expected);
+#if defined(CRC32_HAS_CLMUL)
+        ok = ok && CHECK(engine_crc_of<CRC32_Clmul>(p, size) == expected);
+#endif
+        if (!ok) {
+          printf("offset %u, size %u\n", unsigned(offset), unsigned(size));
+          return;
+        }
+      }
+    }
+  }
+
+  /**
+   * The byte engine's own table is slicing table 0
+   */
+  void test_byte_table() {
+    CHECK(memcmp(crc32_detail::byte_table, crc32_detail::slice_table[0], sizeof crc32_detail::byte_table) == 0);
+  }
+
+  /**
+   * A long buffer processed in uneven pieces gives the same result on every engine
+   */
+  void test_engines_split() {
+    BasicCRC32<CRC32_Bitwise> expected;
+    BasicCRC32<CRC32_Slice8> slice8;
+#if defined(CRC32_HAS_CLMUL)
+    BasicCRC32<CRC32_Clmul> clmul;
+#endif
+    for (uint32 done = 0, size = 1; done + size <= BUFFER_SIZE; done += size, size = size * 3 % 997) {
+      expected.process(data + done, size);
+      slice8.process(data + done, size);
+#if defined(CRC32_HAS_CLMUL)
+      clmul.process(data + done, size);
+#endif
+    }
+    CHECK(slice8.get_result() == expected.get_result());
+#if defined(CRC32_HAS_CLMUL)
+    CHECK(clmul.get_result() == expected.get_result());
+#endif
+  }
+
+  void test_check_value() {
+    CHECK(crc_of(reinterpret_cast<const uint8*>("123456789"), 9) == 0xcbf43926);
+    CHECK(crc_of(data, 0) == 0);
+  }
+
+  /**
+   * Checksums of random splits combine to the checksum of the whole buffer
+   */
+  void test_combine() {
+    for (int i = 0; i < 2000; ++i) {
+      const uint32 size = rand() % BUFFER_SIZE;
+      const uint32 split = rand() % (size + 1);
+      const uint32 crc_a = crc_of(data, split);
+      const uint32 crc_b = crc_of(data + split, size - split);
+      if (!CHECK(crc32_combine(crc_a, crc_b, size - split) == crc_of(data, size)))
+        return;
+    }
+  }
+
+  /**
+   * append_zeros matches processing real zero bytes
+   */
+  void test_append_zeros() {
+    for (int i = 0; i < 2000; ++i) {
+      const uint32 size = rand() % BUFFER_SIZE;
+      const uint32 zero_count = rand() % (BUFFER_SIZE - size);
+      CRC32 processed, appended;
+      processed.process(data, size).process(zeros, zero_count);
+      appended.process(data, size).append_zeros(zero_count);
+      if (!CHECK(processed.get_result() == appended.get_result()))
+        return;
+    }
+  }
+}
+
+int main() {
+  for (uint32 i = 0; i < BUFFER_SIZE; ++i)
+    data[i] = uint8(rand());
+
+  test_check_value();
+  test_engines();
+  test_byte_table();
+  test_engines_split();
+  test_combine();
+  test_append_zeros();
+#if defined(CRC32_HAS_CLMUL)
+  if (!CRC32_Clmul::is_supported())
+    printf("test_crc32: no PCLMULQDQ, the clmul engine ran on slicing-by-8\n");
+#endif
+  return test::check_result("test_crc32");
+}
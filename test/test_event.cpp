@@ -0,0 +1,200 @@
+/*
+ *  test_event.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "host_os.h"
+#include "host_serial.h"
+#include "../os/OS_Event.h"
+#include "../os/OS_Reader.h"
+#include "../os/OS_Writer.h"
+
+using os::OS;
+using os::TaskBase;
+using os::Event;
+
+namespace {
+  /**
+   * A task waiting for an event a number of times, recording when it got it
+   */
+  class Waiter: public TaskBase {
+  public:
+    Waiter(Event& event, Priority priority = PRIORITY_DEFAULT, uint32 count = 1)
+    : TaskBase("waiter", m_stack, STACK_SIZE, priority), woken(0), date(0), m_event(event), m_count(count) {
+    }
+
+    uint32 woken;
+    uint32 date;
+
+  protected:
+    void run() {
+      for (uint32 i = 0; i < m_count; ++i) {
+        m_event.wait();
+        ++woken;
+        date = OS::get_time();
+      }
+    }
+
+  private:
+    static const uint32 STACK_SIZE = 64;
+    uint32 m_stack[STACK_SIZE];
+    Event& m_event;
+    const uint32 m_count;
+  };
+
+  /**
+   * Before OS::start(), e.g. for boot messages, a blocking reader or writer
+   * polls the serial port, there being no task to suspend
+   */
+  void test_before_start() {
+    static test::host::Serial serial;
+    static Event received, sent;
+    serial.set_receive_callback(&Event::interrupt_callback, &received);
+    serial.set_send_callback(&Event::interrupt_callback, &sent);
+
+    os::Writer<test::host::Serial> writer(serial, os::Writer<test::host::Serial>::BLOCKING, &sent);
+    const char message[] = "booting, more than a FIFO of text";
+    writer << message;
+    const uint32 size = sizeof(message) - 1;
+    test::host::work(test::host::Serial::SEND_FIFO_SIZE * test::host::Serial::SEND_TIME);
+    CHECK(serial.get_sent_count() == size);
+    bool same = true;
+    for (uint32 i = 0; i < size; ++i)
+      same = same && serial.get_sent()[i] == uint8(message[i]);
+    CHECK(same);
+
+    os::Reader<test::host::Serial> reader(serial, &received);
+    serial.receive(3, 100);
+    uint8 bytes[3];
+    CHECK(reader.read(bytes, 3) == 3);
+    CHECK(bytes[0] == 0 && bytes[1] == 1 && bytes[2] == 2);
+    CHECK(serial.get_empty_polls() > 3);
+  }
+
+  /**
+   * A signal without waiter is remembered for the next wait, once
+   */
+  void test_remembered() {
+    Event event;
+    event.signal();
+    event.signal();
+    const uint32 switches = test::host::counters().switches;
+    event.wait();
+    CHECK(test::host::counters().switches == switches);
+
+    static Waiter waiter(event);
+    OS::add(waiter);
+    OS::yield();
+    CHECK(waiter.woken == 0);
+    event.signal();
+    OS::yield();
+    CHECK(waiter.woken == 1);
+  }
+
+  /**
+   * A signal wakes up the first waiter, by priority then arrival
+   */
+  void test_first_waiter() {
+    static Event event;
+    static Waiter first(event), second(event), high(event, TaskBase::PRIORITY_DEFAULT + 1);
+    OS::add(first);
+    OS::add(second);
+    OS::yield();
+    OS::add(high);
+    OS::yield();
+    event.signal();
+    OS::yield();
+    CHECK(high.woken == 1 && first.woken == 0 && second.woken == 0);
+    event.signal();
+    OS::yield();
+    CHECK(first.woken == 1 && second.woken == 0);
+    event.signal();
+    OS::yield();
+    CHECK(second.woken == 1);
+  }
+
+  /**
+   * An interrupt handler's signal ends the idle mode and wakes up the waiter
+   * then, a second one before the waiter ran being the same signal
+   */
+  void test_from_interrupt() {
+    static Event event;
+    static Waiter waiter(event, TaskBase::PRIORITY_DEFAULT, 2);
+    OS::add(waiter);
+    OS::yield();
+    const uint32 start = OS::get_time();
+    test::host::raise_at(start + 300, &Event::interrupt_callback, &event);
+    test::host::raise_at(start + 300, &Event::interrupt_callback, &event);
+    OS::sleep_for(1);
+    CHECK(waiter.woken == 1 && waiter.date == start + 300);
+
+    // Raised while the main task works: signaled at the next scheduling point,
+    // the waiter running behind the main task, its peer
+    test::host::raise_at(OS::get_time() + 10, &Event::interrupt_callback, &event);
+    test::host::work(50);
+    CHECK(waiter.woken == 1);
+    OS::yield();
+    OS::yield();
+    CHECK(waiter.woken == 2);
+  }
+
+  /**
+   * A reader waiting on the serial event polls once per byte, the CPU idling in between
+   */
+  void test_reader() {
+    static test::host::Serial serial;
+    static Event event;
+    serial.set_receive_callback(&Event::interrupt_callback, &event);
+    os::Reader<test::host::Serial> reader(serial, &event);
+
+    const uint32 idles = test::host::counters().idles;
+    const uint32 start = OS::get_time();
+    serial.receive(10, 1000);
+    uint8 bytes[10];
+    CHECK(reader.read(bytes, 10) == 10);
+    CHECK(OS::get_time() - start < 10000 + 10 * 2 * test::host::Serial::POLL_TIME);
+    for (uint32 i = 0; i < 10; ++i)
+      CHECK(bytes[i] == i);
+    CHECK(serial.get_empty_polls() == 10);
+    CHECK(test::host::counters().idles - idles == 10);
+  }
+
+  /**
+   * Within a critical section, a blocked reader polls instead of switching tasks
+   */
+  void test_critical_section() {
+    static test::host::Serial serial;
+    static Event event, other;
+    serial.set_receive_callback(&Event::interrupt_callback, &event);
+    os::Reader<test::host::Serial> reader(serial, &event);
+    static Waiter peer(other);
+    OS::add(peer);
+
+    const uint32 switches = test::host::counters().switches;
+    OS::enter_critical_section();
+    other.signal();
+    serial.receive(3, 100);
+    uint8 bytes[3];
+    CHECK(reader.read(bytes, 3) == 3);
+    CHECK(test::host::counters().switches == switches);
+    CHECK(peer.woken == 0);
+    OS::leave_critical_section();
+    OS::yield();
+    CHECK(peer.woken == 1);
+  }
+}
+
+int main() {
+  test_before_start();
+  test::host::start_os();
+  test_remembered();
+  test_first_waiter();
+  test_from_interrupt();
+  test_reader();
+  test_critical_section();
+  return test::check_result("test_event");
+}
@@ -0,0 +1,89 @@
+/*
+ *  test_fir.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/FIR.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+using namespace util;
+
+namespace {
+  const uint32 N = 64;
+  const uint32 NB_SAMPLES = 4096;
+  typedef Q<16> Q16;
+
+  double coef[N];
+  double samples[NB_SAMPLES];
+
+  /**
+   * Direct convolution, the first sample standing for the ones before it
+   */
+  double reference(uint32 n) {
+    double y = 0;
+    for (uint32 i = 0; i < N; ++i)
+      y += coef[i] * samples[n >= i ? n - i : 0];
+    return y;
+  }
+
+  void test_float() {
+    float c[N];
+    for (uint32 i = 0; i < N; ++i)
+      c[i] = float(coef[i]);
+    FIR<float, N> single(c);
+    FIR<float, N> block(c);
+
+    static float in[NB_SAMPLES], out[NB_SAMPLES];
+    for (uint32 n = 0; n < NB_SAMPLES; ++n)
+      in[n] = float(samples[n]);
+    block.process(in, out, NB_SAMPLES);
+
+    double worst = 0;
+    bool same = true;
+    for (uint32 n = 0; n < NB_SAMPLES; ++n) {
+      single.add_value(in[n]);
+      same = same && single.get_filtered_value() == out[n];
+      worst = fmax(worst, fabs(out[n] - reference(n)));
+    }
+    CHECK(same);
+    CHECK(worst < 1e-5);
+  }
+
+  /**
+   * The products are accumulated in 64 bits and rounded once, so the output
+   * stays within one step of the exact convolution of the Q values
+   */
+  void test_fixed_point() {
+    Q16 c[N];
+    for (uint32 i = 0; i < N; ++i) {
+      c[i] = Q16(float(coef[i]));
+      coef[i] = c[i].to_float();
+    }
+    FIR<Q16, N> fir(c);
+
+    double worst = 0;
+    for (uint32 n = 0; n < NB_SAMPLES; ++n) {
+      const Q16 x(float(samples[n]));
+      samples[n] = x.to_float();
+      worst = fmax(worst, fabs(fir.process(x).to_float() - reference(n)));
+    }
+    CHECK(worst <= 1.0 / 65536);
+  }
+}
+
+int main() {
+  for (uint32 i = 0; i < N; ++i)
+    coef[i] = (rand() % 2001 - 1000) / 64000.0;
+  for (uint32 n = 0; n < NB_SAMPLES; ++n)
+    samples[n] = (rand() % 2001 - 1000) / 1000.0;
+
+  test_float();
+  test_fixed_point();
+  return test::check_result("test_fir");
+}
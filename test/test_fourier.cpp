@@ -0,0 +1,128 @@
+/*
+ *  test_fourier.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/Fourier.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+using namespace util;
+
+namespace {
+  typedef Q<24> Q24;
+
+  /**
+   * Largest distance between two spectra over the first nb_bins bins
+   */
+  double distance(const float* re, const float* im, const float* ref_re, const float* ref_im, uint32 nb_bins) {
+    double d = 0;
+    for (uint32 k = 0; k < nb_bins; ++k) {
+      const double e = hypot(re[k] - ref_re[k], im[k] - ref_im[k]);
+      if (e > d)
+        d = e;
+    }
+    return d;
+  }
+
+  template <uint32 N>
+  void to_float(const Q24* q, float* f, uint32 nb_bins) {
+    // Fixed point transforms are divided by N
+    for (uint32 k = 0; k < nb_bins; ++k)
+      f[k] = q[k].to_float() * N;
+  }
+
+  /**
+   * The transforms of N random samples in [-1, 1] against dft().
+   * Both use the 15 bit twiddles of SineLUT, the remaining differences come
+   * from the order of the operations and, for Q, from the scaling by N.
+   */
+  template <uint32 N>
+  void test_against_dft() {
+    static FFT<float, N> fft;
+    static RealFFT<float, N> real_fft;
+    static FFT<Q24, N> q_fft;
+    static RealFFT<Q24, N> q_real_fft;
+    static float x[N], dft_re[N], dft_im[N], re[N], im[N];
+    static Q24 qx[N], q_re[N], q_im[N];
+
+    for (uint32 n = 0; n < N; ++n) {
+      x[n] = (rand() % 2001 - 1000) / 1000.0f;
+      qx[n] = Q24(x[n]);
+    }
+    Fourier<float>::dft(x, dft_re, dft_im, N);
+    const double tolerance = 2e-5 * N + 1e-4;
+
+    for (uint32 n = 0; n < N; ++n) {
+      re[n] = x[n];
+      im[n] = 0;
+    }
+    fft.transform(re, im);
+    CHECK(distance(re, im, dft_re, dft_im, N) < tolerance);
+
+    real_fft.transform(x, re, im);
+    CHECK(distance(re, im, dft_re, dft_im, N / 2 + 1) < tolerance);
+
+    for (uint32 n = 0; n < N; ++n) {
+      q_re[n] = qx[n];
+      q_im[n] = Q24();
+    }
+    q_fft.transform(q_re, q_im);
+    to_float<N>(q_re, re, N);
+    to_float<N>(q_im, im, N);
+    CHECK(distance(re, im, dft_re, dft_im, N) < tolerance);
+
+    q_real_fft.transform(qx, q_re, q_im);
+    to_float<N>(q_re, re, N / 2 + 1);
+    to_float<N>(q_im, im, N / 2 + 1);
+    CHECK(distance(re, im, dft_re, dft_im, N / 2 + 1) < tolerance);
+  }
+
+  /**
+   * A cosine on bin 5 gives N/2 on bins 5 and N-5, nothing elsewhere
+   */
+  void test_tone() {
+    const uint32 N = 64;
+    static RealFFT<float, N> real_fft;
+    float x[N], re[N / 2 + 1], im[N / 2 + 1];
+    for (uint32 n = 0; n < N; ++n)
+      x[n] = float(cos(2 * M_PI * 5 * n / N));
+    real_fft.transform(x, re, im);
+    for (uint32 k = 0; k <= N / 2; ++k) {
+      const double expected = k == 5 ? N / 2 : 0;
+      CHECK(fabs(re[k] - expected) < 1e-2 && fabs(im[k]) < 1e-2);
+    }
+  }
+
+  /**
+   * The table sine at the quarter points and its symmetries
+   */
+  void test_sine() {
+    const int32 top = SineLUT::SCALING - 1;
+    const uint32 quarter = SineLUT::SIZE / 4;
+    CHECK(fourier_detail::sine(0) == 0);
+    CHECK(fourier_detail::sine(quarter) == top);
+    CHECK(fourier_detail::sine(3 * quarter) == -top);
+    CHECK(fourier_detail::cosine(0) == top);
+    for (uint32 a = 1; a < quarter; ++a) {
+      const int32 s = fourier_detail::sine(a);
+      if (!CHECK(fourier_detail::sine(2 * quarter - a) == s && fourier_detail::sine(2 * quarter + a) == -s
+                 && fourier_detail::sine(a + SineLUT::SIZE) == s))
+        return;
+    }
+  }
+}
+
+int main() {
+  test_sine();
+  test_tone();
+  test_against_dft<4>();
+  test_against_dft<64>();
+  test_against_dft<256>();
+  return test::check_result("test_fourier");
+}
@@ -0,0 +1,264 @@
+/*
+ *  test_gcm.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/AES256_wrapper.h"
+#include "../util/AES.h"
+#include "../util/GCM.h"
+#include "../util/BinHex.h"
+#include "../util/CipherStream.h"
+#include "../util/MemReader.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace util;
+
+namespace {
+  /**
+   * Test cases 4 and 16 of the GCM specification (McGrew and Viega):
+   * the same plaintext, IV and additional data, with AES-128 and AES-256 keys
+   */
+  const char* KEY_128 = "feffe9928665731c6d6a8f9467308308";
+  const char* KEY_256 = "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308";
+  const char* IV = "cafebabefacedbaddecaf888";
+  const char* AAD = "feedfacedeadbeeffeedfacedeadbeefabaddad2";
+  const char* PLAINTEXT = "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+                          "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39";
+  const char* CIPHERTEXT_128 = "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+                               "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091";
+  const char* TAG_128 = "5bc94fbc3221a5db94fae95ae7121a47";
+  const char* CIPHERTEXT_256 = "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+                               "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662";
+  const char* TAG_256 = "76fc6ece0f4e1768cddf8853bb2d551b";
+
+  uint8 iv[12], aad[20], plaintext[60];
+
+  bool equals(const uint8* bytes, const char* hex, uint32 size) {
+    uint8 expected[64];
+    hex_to_bytes(expected, hex, size);
+    return memcmp(bytes, expected, size) == 0;
+  }
+
+  /**
+   * Encrypts in uneven pieces, then decrypts and checks the tag
+   */
+  template <class C>
+  void check_vector(C& cipher, const char* ciphertext, const char* tag) {
+    GCM<C> gcm(cipher);
+    uint8 data[60], computed_tag[16];
+
+    memcpy(data, plaintext, sizeof data);
+    gcm.start(iv).add_aad(aad, 7).add_aad(aad + 7, 13);
+    gcm.encrypt(data, 17).encrypt(data + 17, 43);
+    gcm.get_tag(computed_tag);
+    CHECK(equals(data, ciphertext, sizeof data));
+    CHECK(equals(computed_tag, tag, sizeof computed_tag));
+
+    gcm.start(iv).add_aad(aad, sizeof aad);
+    gcm.decrypt(data, sizeof data);
+    CHECK(gcm.check_tag(computed_tag));
+    CHECK(memcmp(data, plaintext, sizeof data) == 0);
+  }
+
+  void test_vectors() {
+    AES256::key_type key_256;
+    hex_to_bytes(key_256, KEY_256, sizeof key_256);
+    AES256 aes256;
+    aes256.set_key(key_256);
+    check_vector(aes256, CIPHERTEXT_256, TAG_256);
+
+    uint8 key_128[16];
+    hex_to_bytes(key_128, KEY_128, sizeof key_128);
+    AES aes;
+    aes.SetParameters(128, 128);
+    aes.StartEncryption(key_128);
+    check_vector(aes, CIPHERTEXT_128, TAG_128);
+  }
+
+  /**
+   * @return check_tag() for the test case 16 message, with the given tag
+   */
+  bool check_truncated(GCM<AES256>& gcm, const uint8* tag, uint32 tag_size) {
+    uint8 data[60];
+    hex_to_bytes(data, CIPHERTEXT_256, sizeof data);
+    gcm.start(iv).add_aad(aad, sizeof aad).decrypt(data, sizeof data);
+    return gcm.check_tag(tag, tag_size);
+  }
+
+  /**
+   * Tags may be truncated down to 12 bytes, 8 and 4 byte ones need allow_short_tags()
+   */
+  void test_tag_sizes() {
+    AES256::key_type key;
+    hex_to_bytes(key, KEY_256, sizeof key);
+    AES256 aes;
+    aes.set_key(key);
+    GCM<AES256> gcm(aes);
+
+    uint8 tag[16];
+    hex_to_bytes(tag, TAG_256, sizeof tag);
+    for (uint32 size = 12; size <= 16; ++size)
+      CHECK(check_truncated(gcm, tag, size));
+    CHECK(!check_truncated(gcm, tag, 0));
+    CHECK(!check_truncated(gcm, tag, 4));
+    CHECK(!check_truncated(gcm, tag, 8));
+    CHECK(!check_truncated(gcm, tag, 11));
+    CHECK(!check_truncated(gcm, tag, 17));
+
+    gcm.allow_short_tags();
+    CHECK(check_truncated(gcm, tag, 4));
+    CHECK(check_truncated(gcm, tag, 8));
+    CHECK(!check_truncated(gcm, tag, 6));
+
+    // A wrong byte within the compared prefix is caught
+    tag[3] ^= 1;
+    CHECK(!check_truncated(gcm, tag, 4));
+    CHECK(!check_truncated(gcm, tag, 16));
+  }
+
+  /**
+   * A memory writer taking at most max_write bytes per call, until it is full
+   */
+  class ChoppyWriter: public Writer {
+  public:
+    ChoppyWriter(uint8* memory, size_type size, size_type max_write)
+    : m_memory(memory), m_size(size), m_max_write(max_write), m_pos(0) {
+    }
+
+    ~ChoppyWriter() {
+    }
+
+    size_type write(const uint8 *bytes, size_type count) {
+      size_type nb = 0;
+      while (m_pos < m_size && nb < count && nb < m_max_write)
+        m_memory[m_pos++] = bytes[nb++];
+      return nb;
+    }
+
+    size_type get_size() const {
+      return m_pos;
+    }
+
+  private:
+    uint8* const m_memory;
+    const size_type m_size;
+    const size_type m_max_write;
+    size_type m_pos;
+  };
+
+  /**
+   * A memory reader returning at most max_read bytes per call
+   */
+  class ChoppyReader: public Reader {
+  public:
+    ChoppyReader(const uint8* memory, size_type size, size_type max_read)
+    : m_reader(memory, size), m_max_read(max_read) {
+    }
+
+    ~ChoppyReader() {
+    }
+
+    size_type read(uint8 *bytes, size_type count) {
+      return m_reader.read(bytes, count < m_max_read ? count : m_max_read);
+    }
+
+  private:
+    MemReader m_reader;
+    const size_type m_max_read;
+  };
+
+  const uint32 STREAM_SIZE = 300;
+  const uint32 PIECES[] = { 1, 7, 33, 64, 2, 95, 13 };  // cycled through
+  const uint32 NB_PIECES = sizeof PIECES / sizeof PIECES[0];
+
+  /**
+   * Decrypts the stream through a CipherReader in uneven reads
+   * @return check_tag() on the tag, data holding the decrypted stream
+   */
+  bool read_stream(GCM<AES256>& gcm, const uint8* stream, const uint8* tag, uint8* data) {
+    ChoppyReader memory(stream, STREAM_SIZE, 11);
+    CipherReader<GCM<AES256> > reader(gcm, memory);
+    gcm.start(iv).add_aad(aad, sizeof aad);
+    uint32 size = 0;
+    for (uint32 p = 0; size < STREAM_SIZE; ++p) {
+      const uint32 r = reader.read(data + size, PIECES[p % NB_PIECES]);
+      if (r == 0)
+        break;
+      size += r;
+    }
+    return size == STREAM_SIZE && gcm.check_tag(tag);
+  }
+
+  /**
+   * A round trip through CipherWriter and CipherReader in GCM, over memory that
+   * takes and gives a few bytes at a time, in write and read sizes of their own.
+   * The stream is the same as a single encrypt(), and an altered byte or tag is refused.
+   */
+  void test_streams() {
+    AES256::key_type key;
+    hex_to_bytes(key, KEY_256, sizeof key);
+    AES256 aes;
+    aes.set_key(key);
+    GCM<AES256> gcm(aes);
+
+    uint8 data[STREAM_SIZE], expected[STREAM_SIZE], expected_tag[16];
+    for (uint32 i = 0; i < STREAM_SIZE; ++i)
+      data[i] = uint8(rand());
+    memcpy(expected, data, sizeof expected);
+    gcm.start(iv).add_aad(aad, sizeof aad).encrypt(expected, sizeof expected);
+    gcm.get_tag(expected_tag);
+
+    uint8 stream[STREAM_SIZE], tag[16];
+    ChoppyWriter memory(stream, sizeof stream, 5);
+    CipherWriter<GCM<AES256> > writer(gcm, memory);
+    gcm.start(iv).add_aad(aad, sizeof aad);
+    uint32 size = 0;
+    for (uint32 p = 0; size < STREAM_SIZE; ++p) {
+      uint32 piece = PIECES[p % NB_PIECES];
+      if (piece > STREAM_SIZE - size)
+        piece = STREAM_SIZE - size;
+      if (!CHECK(writer.write(data + size, piece) == piece))
+        return;
+      size += piece;
+    }
+    gcm.get_tag(tag);
+    CHECK(memory.get_size() == STREAM_SIZE);
+    CHECK(memcmp(stream, expected, sizeof stream) == 0);
+    CHECK(memcmp(tag, expected_tag, sizeof tag) == 0);
+
+    uint8 back[STREAM_SIZE];
+    CHECK(read_stream(gcm, stream, tag, back));
+    CHECK(memcmp(back, data, sizeof back) == 0);
+
+    // Tampered data, then a tampered tag
+    stream[150] ^= 0x20;
+    CHECK(!read_stream(gcm, stream, tag, back));
+    stream[150] ^= 0x20;
+    tag[15] ^= 1;
+    CHECK(!read_stream(gcm, stream, tag, back));
+
+    // A full writer: the bytes effectively sent are reported
+    uint8 small[40];
+    ChoppyWriter full(small, sizeof small, 5);
+    CipherWriter<GCM<AES256> > short_writer(gcm, full);
+    gcm.start(iv);
+    CHECK(short_writer.write(data, 64) == sizeof small);
+  }
+}
+
+int main() {
+  hex_to_bytes(iv, IV, sizeof iv);
+  hex_to_bytes(aad, AAD, sizeof aad);
+  hex_to_bytes(plaintext, PLAINTEXT, sizeof plaintext);
+
+  test_vectors();
+  test_tag_sizes();
+  test_streams();
+  return test::check_result("test_gcm");
+}
@@ -0,0 +1,107 @@
+/*
+ *  test_goertzel.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/Goertzel.h"
+
+#include <math.h>
+
+using namespace util;
+
+namespace {
+  const uint32 BLOCK = 64;
+  const uint32 RATE = 8000;
+  const uint32 NB_BINS = 3;
+  const uint32 BINS[NB_BINS] = { 8, 5, 13 };  // 1000Hz, 625Hz and 1625Hz
+
+  float samples[BLOCK];
+
+  double to_double(float f) {
+    return f;
+  }
+
+  double to_double(const Q<16>& q) {
+    return q.to_float();
+  }
+
+  /**
+   * A pure tone of amplitude 0.5 on bin 8, out of phase with the DFT
+   */
+  float tone(uint32 n) {
+    return float(0.5 * cos(2 * M_PI * BINS[0] * n / BLOCK + 1.0));
+  }
+
+  template <typename T>
+  void set_bins(Goertzel<T, NB_BINS>& goertzel) {
+    for (uint32 i = 0; i < NB_BINS; ++i)
+      goertzel.set_frequency(i, BINS[i] * RATE / BLOCK, RATE);
+  }
+
+  /**
+   * The power of each bin over a block against |X(k)|^2 / BLOCK^2 from Fourier::dft,
+   * over two blocks to check that the states restart at each block
+   */
+  template <typename T>
+  void test_against_dft(double tolerance) {
+    float re[BLOCK], im[BLOCK];
+    Fourier<float>::dft(samples, re, im, BLOCK);
+
+    Goertzel<T, NB_BINS> goertzel(BLOCK);
+    set_bins(goertzel);
+    for (uint32 block = 1; block <= 2; ++block) {
+      for (uint32 n = 0; n < BLOCK; ++n)
+        goertzel.add_sample(T(samples[n]));
+      CHECK(goertzel.get_block_count() == block);
+      for (uint32 i = 0; i < NB_BINS; ++i) {
+        const uint32 k = BINS[i];
+        const double expected = (double(re[k]) * re[k] + double(im[k]) * im[k]) / (BLOCK * BLOCK);
+        if (!CHECK(fabs(to_double(goertzel.get_power(i)) - expected) < tolerance))
+          printf("  block %u, bin %u: %g against %g\n", block, k, to_double(goertzel.get_power(i)), expected);
+      }
+    }
+    // A quarter of the squared amplitude on the tone, nothing on the others
+    CHECK(fabs(to_double(goertzel.get_power(0)) - 0.0625) < tolerance);
+    CHECK(fabs(to_double(goertzel.get_power(1))) < tolerance);
+  }
+
+  /**
+   * reset() drops a partial block, and the block count, but not the latched results
+   */
+  template <typename T>
+  void test_reset(double tolerance) {
+    Goertzel<T, NB_BINS> goertzel(BLOCK);
+    set_bins(goertzel);
+    for (uint32 n = 0; n < BLOCK; ++n)
+      goertzel.add_sample(T(samples[n]));
+    const double latched = to_double(goertzel.get_power(0));
+
+    // Half a block of another tone, then dropped
+    for (uint32 n = 0; n < BLOCK / 2; ++n)
+      goertzel.add_sample(T(float(0.7 * sin(2 * M_PI * BINS[1] * n / BLOCK))));
+    goertzel.reset();
+    CHECK(goertzel.get_block_count() == 0);
+    CHECK(to_double(goertzel.get_power(0)) == latched);
+
+    for (uint32 n = 0; n < BLOCK; ++n)
+      goertzel.add_sample(T(samples[n]));
+    CHECK(goertzel.get_block_count() == 1);
+    CHECK(fabs(to_double(goertzel.get_power(0)) - 0.0625) < tolerance);
+    CHECK(fabs(to_double(goertzel.get_power(1))) < tolerance);
+  }
+}
+
+int main() {
+  for (uint32 n = 0; n < BLOCK; ++n)
+    samples[n] = tone(n);
+
+  test_against_dft<float>(1e-5);
+  test_against_dft<Q<16> >(5e-5);
+  test_reset<float>(1e-5);
+  test_reset<Q<16> >(5e-5);
+  return test::check_result("test_goertzel");
+}
@@ -0,0 +1,100 @@
+/*
+ *  test_hmac.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/SHA1.h"
+#include "../util/HMAC.h"
+
+#include <string.h>
+
+using namespace util;
+
+namespace {
+  typedef HMAC<SHA1> HMAC_SHA1;
+
+  /**
+   * @return true if the result, in host order, is the digest written in hex
+   */
+  bool digest_is(SHA1::Result result, const char* hex) {
+    SHA1::Result expected;
+    expected.assign(hex);
+    result.to_network_order();
+    return result.matches(expected);
+  }
+
+  const uint8* bytes(const char* text) {
+    return reinterpret_cast<const uint8*>(text);
+  }
+
+  /**
+   * RFC 2202 test cases for HMAC-SHA1, cases 6 and 7 with keys longer than a block
+   */
+  void test_rfc2202() {
+    uint8 key[80];
+    uint8 data[50];
+    HMAC_SHA1 hmac;
+
+    memset(key, 0x0b, 20);
+    hmac.set_key(key, 20).process(bytes("Hi There"), 8);
+    CHECK(digest_is(hmac.get_result(), "b617318655057264e28bc0b6fb378c8ef146be00"));
+
+    hmac.set_key(bytes("Jefe"), 4).process(bytes("what do ya want for nothing?"), 28);
+    CHECK(digest_is(hmac.get_result(), "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79"));
+
+    memset(key, 0xaa, 20);
+    memset(data, 0xdd, 50);
+    hmac.set_key(key, 20).process(data, 50);
+    CHECK(digest_is(hmac.get_result(), "125d7342b9ac11cd91a39af48aa17b4f63f175d3"));
+
+    for (uint8 i = 0; i < 25; ++i)
+      key[i] = i + 1;
+    memset(data, 0xcd, 50);
+    hmac.set_key(key, 25).process(data, 50);
+    CHECK(digest_is(hmac.get_result(), "4c9007f4026250c6bc8414f9bf50c86c2d7235da"));
+
+    memset(key, 0x0c, 20);
+    hmac.set_key(key, 20).process(bytes("Test With Truncation"), 20);
+    CHECK(digest_is(hmac.get_result(), "4c1a03424b55e07fe7f27be1d58bb9324a9a5a04"));
+
+    memset(key, 0xaa, 80);
+    hmac.set_key(key, 80).process(bytes("Test Using Larger Than Block-Size Key - Hash Key First"), 54);
+    CHECK(digest_is(hmac.get_result(), "aa4ae5e15272d00e95705637ce8a3b55ed402112"));
+
+    hmac.set_key(key, 80).process(bytes("Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data"), 73);
+    CHECK(digest_is(hmac.get_result(), "e8e99d0f45237d786d6bbaa7965c7808bbff1a91"));
+  }
+
+  /**
+   * Before set_key(), the key is empty
+   */
+  void test_default_key() {
+    HMAC_SHA1 hmac;
+    CHECK(digest_is(hmac.get_result(), "fbdb1d1b18aa6c08324b7d64b71fb76370690e1d"));
+    HMAC_SHA1 other;
+    other.reset().process(bytes("abc"), 3);
+    CHECK(digest_is(other.get_result(), "9b4a918f398d74d3e367970aba3cbe54e4d2b5d9"));
+  }
+
+  /**
+   * The key stays in effect after reset(), for the next messages
+   */
+  void test_reset() {
+    HMAC_SHA1 hmac;
+    hmac.set_key(bytes("Jefe"), 4).process(bytes("something else"), 14);
+    hmac.get_result();
+    hmac.reset().process(bytes("what do ya want "), 16).process(bytes("for nothing?"), 12);
+    CHECK(digest_is(hmac.get_result(), "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79"));
+  }
+}
+
+int main() {
+  test_rfc2202();
+  test_reset();
+  test_default_key();
+  return test::check_result("test_hmac");
+}
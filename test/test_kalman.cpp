@@ -0,0 +1,265 @@
+/*
+ *  test_kalman.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "reference_kalman.h"
+#include "../util/Kalman.h"
+#include "../util/SequentialKalman.h"
+
+#include <stdlib.h>
+
+using namespace la;
+
+namespace {
+  template <uint32 R, uint32 C>
+  void randomize(Matrix<R, C, float>& m) {
+    for (uint32 i = 0; i < R; ++i)
+      for (uint32 j = 0; j < C; ++j)
+        m(i, j) = rand() / float(RAND_MAX) - 0.5f;
+  }
+
+  template <class A, class B>
+  float max_difference(const A& a, const B& b) {
+    float d = 0;
+    for (uint32 i = 0; i < A::ROWS; ++i)
+      for (uint32 j = 0; j < A::COLS; ++j)
+        if (util::abs(a(i, j) - b(i, j)) > d)
+          d = util::abs(a(i, j) - b(i, j));
+    return d;
+  }
+
+  /**
+   * Each expression against the free functions
+   */
+  void test_expressions() {
+    Matrix<3, 4> a, b, expected, result;
+    Matrix<4, 2> c;
+    Matrix<3, 3> p, q;
+    randomize(a); randomize(b); randomize(c); randomize(p); randomize(q);
+
+    plus(expected, a, b);
+    result = a + b;
+    CHECK(max_difference(result, expected) == 0);
+
+    minus(expected, a, b);
+    result = a - b;
+    CHECK(max_difference(result, expected) == 0);
+
+    mult(expected, a, 3.0f);
+    result = a * 3.0f;
+    CHECK(max_difference(result, expected) == 0);
+    result = 3.0f * a;
+    CHECK(max_difference(result, expected) == 0);
+
+    Matrix<3, 2> product, expected_product;
+    mult(expected_product, a, c);
+    product = a * c;
+    CHECK(max_difference(product, expected_product) < 1e-6f);
+
+    Matrix<4, 3> t, expected_t;
+    transpose(expected_t, a);
+    t = transpose(a);
+    CHECK(max_difference(t, expected_t) == 0);
+
+    // Nested: (A + B) * C - 2 * A * C
+    Matrix<3, 2> nested, expected_nested, ac;
+    Matrix<3, 4> ab;
+    plus(ab, a, b);
+    mult(expected_nested, ab, c);
+    mult(ac, a, c);
+    for (uint32 i = 0; i < 3; ++i)
+      for (uint32 j = 0; j < 2; ++j)
+        expected_nested(i, j) -= 2 * ac(i, j);
+    nested = (a + b) * c - 2.0f * (a * c);
+    CHECK(max_difference(nested, expected_nested) < 1e-5f);
+
+    // Congruence A.P.A^T on a symmetric P, alone and plus Q
+    Matrix<3, 3> s, at, sp, expected_apat, apat;
+    randomize(s);
+    Matrix<3, 3> st;
+    transpose(st, s);
+    plus(sp, s, st);
+    Matrix<3, 3> m, m_sp, m_t;
+    randomize(m);
+    mult(m_sp, m, sp);
+    transpose(m_t, m);
+    mult(expected_apat, m_sp, m_t);
+    apat = congruence(m, sp);
+    CHECK(max_difference(apat, expected_apat) < 1e-5f);
+    CHECK(max_difference(apat, transpose(apat)) == 0);
+
+    Matrix<3, 3> expected_plus_q;
+    plus(expected_plus_q, expected_apat, q);
+    apat = congruence(m, sp) + q;
+    CHECK(max_difference(apat, expected_plus_q) < 1e-5f);
+  }
+
+  /**
+   * The in place steps against the textbook filter, over many steps
+   */
+  template <uint32 N, uint32 M>
+  void test_filter() {
+    typedef test::KalmanTraits<N, M> traits;
+    Kalman<traits> k;
+    test::ReferenceKalman<traits> reference;
+    test::setup_kalman(k);
+    test::setup_kalman(reference);
+
+    float largest = 0;
+    for (uint32 n = 0; n < 2000; ++n) {
+      typename Kalman<traits>::meas_type Z;
+      test::measurement(Z, n);
+      k.update_time();
+      k.update_measurement(Z);
+      reference.update_time();
+      reference.update_measurement(Z);
+      const float d = max_difference(k.X, reference.X);
+      if (d > largest)
+        largest = d;
+    }
+    if (!CHECK(largest < 1e-4f))
+      printf("  %u states, %u measurements: %g\n", N, M, largest);
+    CHECK(max_difference(k.K, reference.K) < 1e-5f);
+    CHECK(max_difference(k.P, reference.P) < 1e-5f);
+  }
+
+  /**
+   * With H * P^ * H_T + R singular, here no measurement and no noise,
+   * the gain is kept from the previous step
+   */
+  void test_singular() {
+    typedef test::KalmanTraits<2, 1> traits;
+    Kalman<traits> k;
+    test::setup_kalman(k);
+    typename Kalman<traits>::meas_type Z;
+    test::measurement(Z, 0);
+    k.update_time();
+    k.update_measurement(Z);
+    const typename Kalman<traits>::kalman_gain_type K = k.K;
+    CHECK(K(0, 0) != 0);
+
+    set_zero(k.H);
+    set_zero(k.R);
+    k.update_time();
+    k.update_measurement(Z);
+    CHECK(max_difference(k.K, K) == 0);
+
+    // From the start, the gain is zero
+    Kalman<traits> singular;
+    test::setup_kalman(singular);
+    set_zero(singular.H);
+    set_zero(singular.R);
+    singular.update_time();
+    singular.update_measurement(Z);
+    CHECK(singular.K(0, 0) == 0 && singular.K(1, 0) == 0);
+    CHECK(max_difference(singular.X, singular.X_predicted) == 0);
+  }
+
+  /**
+   * The factored, sequential filter against la::Kalman in float: both compute
+   * the same estimate, R being diagonal. Their gains differ in form, K holding
+   * one scalar measurement gain per column, so the states and covariances are compared.
+   */
+  template <uint32 N, uint32 M>
+  void test_sequential() {
+    typedef test::KalmanTraits<N, M> traits;
+    Kalman<traits> k;
+    SequentialKalman<traits> sequential;
+    test::setup_kalman(k);
+    test::setup_kalman(sequential);
+
+    float largest_X = 0;
+    float largest_P = 0;
+    for (uint32 n = 0; n < 2000; ++n) {
+      typename Kalman<traits>::meas_type Z;
+      test::measurement(Z, n);
+      k.update_time();
+      k.update_measurement(Z);
+      sequential.update_time();
+      sequential.update_measurement(Z);
+      const float dX = max_difference(sequential.X, k.X);
+      const float dP = max_difference(sequential.P, k.P);
+      if (dX > largest_X)
+        largest_X = dX;
+      if (dP > largest_P)
+        largest_P = dP;
+    }
+    if (!CHECK(largest_X < 1e-5f && largest_P < 1e-5f))
+      printf("  %u states, %u measurements: X %g, P %g\n", N, M, largest_X, largest_P);
+  }
+
+  /**
+   * The steady state gain against the full filter run side by side:
+   * the full filter gain converges to it, and the states stay close
+   */
+  template <uint32 N, uint32 M>
+  void test_steady_state() {
+    typedef test::KalmanTraits<N, M> traits;
+    Kalman<traits> full, steady;
+    test::setup_kalman(full);
+    test::setup_kalman(steady);
+    CHECK(!steady.is_steady_state());
+    CHECK(steady.set_steady_state());
+    CHECK(steady.is_steady_state());
+    const typename Kalman<traits>::kalman_gain_type K = steady.K;
+
+    float largest = 0;
+    for (uint32 n = 0; n < 5000; ++n) {
+      typename Kalman<traits>::meas_type Z;
+      test::measurement(Z, n);
+      full.update_time();
+      full.update_measurement(Z);
+      steady.update_time();
+      steady.update_measurement(Z);
+      const float d = max_difference(full.X, steady.X);
+      if (n >= 4500 && d > largest)
+        largest = d;
+    }
+    CHECK(max_difference(steady.K, K) == 0);
+    if (!CHECK(max_difference(full.K, K) < 2e-5f && largest < 1e-3f))
+      printf("  %u states, %u measurements: gain %g, state %g\n", N, M, max_difference(full.K, K), largest);
+
+    // Back to the full filter
+    steady.set_dynamic();
+    CHECK(!steady.is_steady_state());
+    typename Kalman<traits>::meas_type Z;
+    test::measurement(Z, 0);
+    steady.P = full.P;
+    steady.update_time();
+    steady.update_measurement(Z);
+    full.update_time();
+    full.update_measurement(Z);
+    CHECK(max_difference(steady.K, full.K) == 0);
+
+    // Without enough iterations, the filter stays dynamic
+    Kalman<traits> unconverged;
+    test::setup_kalman(unconverged);
+    CHECK(!unconverged.set_steady_state(2));
+    CHECK(!unconverged.is_steady_state());
+  }
+}
+
+int main() {
+  srand(1);
+  test_expressions();
+  test_filter<1, 1>();
+  test_filter<2, 1>();
+  test_filter<4, 2>();
+  test_filter<6, 1>();
+  test_filter<6, 2>();
+  test_singular();
+  test_sequential<2, 1>();
+  test_sequential<4, 2>();
+  test_sequential<6, 1>();
+  test_sequential<6, 2>();
+  test_steady_state<2, 1>();
+  test_steady_state<4, 2>();
+  test_steady_state<6, 1>();
+  test_steady_state<6, 2>();
+  return test::check_result("test_kalman");
+}
@@ -0,0 +1,179 @@
+/*
+ *  test_linear_algebra.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "reference_kalman.h"
+#include "../util/Kalman.h"
+#include "../util/SequentialKalman.h"
+#include "../util/LeastSquaresEstimator.h"
+
+#include <math.h>
+
+using namespace la;
+
+namespace {
+  typedef util::Q<16, int32> q16;
+  typedef util::Q<20, int32> q20;
+
+  template <uint32 N>
+  float to_float(const util::Q<N, int32>& v) {
+    return v.to_float();
+  }
+
+  /**
+   * Largest difference between the elements of a fixed point and a float matrix
+   */
+  template <class A, class B>
+  float max_difference(const A& a, const B& b) {
+    float d = 0;
+    for (uint32 i = 0; i < A::ROWS; ++i)
+      for (uint32 j = 0; j < A::COLS; ++j)
+        if (fabsf(to_float(a(i, j)) - b(i, j)) > d)
+          d = fabsf(to_float(a(i, j)) - b(i, j));
+    return d;
+  }
+
+  /**
+   * 1/x rounded to the nearest LSB, for both signs
+   */
+  template <uint32 N>
+  void test_reciprocal() {
+    typedef util::Q<N, int32> q_type;
+    typedef numeric_traits<q_type> traits;
+    const float values[] = { 0.01f, 0.3f, 0.5f, 1.0f, 1.7f, 3.0f, 4.0f, 100.0f };
+    for (uint32 i = 0; i < sizeof values / sizeof values[0]; ++i) {
+      for (int sign = -1; sign <= 1; sign += 2) {
+        const q_type x(sign * values[i]);
+        const double expected = double(int64(1) << (2 * N)) / x.get_raw();
+        const int32 raw = traits::reciprocal(x).get_raw();
+        if (!CHECK(fabs(raw - expected) <= 0.5))
+          printf("  Q%u 1/%g: %d, expected %g\n", N, x.to_float(), raw, expected);
+      }
+    }
+    CHECK(traits::reciprocal(q_type::from_raw(0)).get_raw() == q_type::max().get_raw());
+    CHECK(traits::reciprocal(q_type::from_raw(1)).get_raw() == q_type::max().get_raw());
+    CHECK(traits::reciprocal(q_type::from_raw(-1)).get_raw() == util::limits<int32>::min_value);
+  }
+
+  void test_invert() {
+    Matrix<1, 1, q16> a, inverse;
+    a(0, 0) = q16(-4.0f);
+    CHECK(invert(inverse, a));
+    CHECK(inverse(0, 0).to_float() == -0.25f);
+    a(0, 0) = q16(4.0f);
+    CHECK(invert(inverse, a));
+    CHECK(inverse(0, 0).to_float() == 0.25f);
+    a(0, 0) = q16(0.0f);
+    CHECK(!invert(inverse, a));
+
+    // Determinants of both signs
+    const float m[][4] = {
+      { 2, 1, 1, 3 },       // 5
+      { 1, 2, 3, 1 },       // -5
+      { -0.5f, 0.25f, 0.75f, 1.5f },
+      { 0, 1, 1, 0 },       // -1
+    };
+    for (uint32 n = 0; n < sizeof m / sizeof m[0]; ++n) {
+      Matrix<2, 2, q16> q, q_inverse;
+      Matrix<2, 2, float> f, f_inverse;
+      for (uint32 i = 0; i < 4; ++i) {
+        q(i / 2, i % 2) = q16(m[n][i]);
+        f(i / 2, i % 2) = m[n][i];
+      }
+      CHECK(invert(q_inverse, q));
+      CHECK(invert(f_inverse, f));
+      if (!CHECK(max_difference(q_inverse, f_inverse) < 1e-4f))
+        printf("  matrix %u: %g\n", n, max_difference(q_inverse, f_inverse));
+    }
+
+    Matrix<2, 2, q16> singular, singular_inverse;
+    singular(0, 0) = q16(1.0f); singular(0, 1) = q16(2.0f);
+    singular(1, 0) = q16(2.0f); singular(1, 1) = q16(4.0f);
+    CHECK(!invert(singular_inverse, singular));
+  }
+
+  /**
+   * A Q20 filter fed the same measurements as a float one.
+   * The noise in the measurements makes the innovations change sign.
+   */
+  template <template <class> class Filter, uint32 N, uint32 M>
+  void test_kalman(float tolerance) {
+    Filter<test::KalmanTraits<N, M, q20> > q;
+    Filter<test::KalmanTraits<N, M, float> > f;
+    test::setup_kalman(q);
+    test::setup_kalman(f);
+
+    float largest = 0;
+    for (uint32 n = 0; n < 3000; ++n) {
+      typename Filter<test::KalmanTraits<N, M, float> >::meas_type Z;
+      typename Filter<test::KalmanTraits<N, M, q20> >::meas_type Zq;
+      test::measurement(Z, n);
+      for (uint32 j = 0; j < M; ++j)
+        Zq(j, 0) = q20(Z(j, 0));
+      q.update_time();
+      q.update_measurement(Zq);
+      f.update_time();
+      f.update_measurement(Z);
+      const float d = max_difference(q.X, f.X);
+      if (d > largest)
+        largest = d;
+    }
+    if (!CHECK(largest < tolerance))
+      printf("  %u states, %u measurements: %g\n", N, M, largest);
+  }
+
+  void test_steady_state() {
+    Kalman<test::KalmanTraits<4, 2, q20> > q;
+    Kalman<test::KalmanTraits<4, 2, float> > f;
+    test::setup_kalman(q);
+    test::setup_kalman(f);
+    CHECK(q.set_steady_state());
+    CHECK(f.set_steady_state());
+    CHECK(max_difference(q.K, f.K) < 1e-4f);
+  }
+
+  struct AffineTraits: LeastSquaresEstimator_Affine_Traits {
+    typedef q16 real_type;
+  };
+
+  /**
+   * Affine fit of y = 2 + x / 2, the x spanning both signs
+   */
+  void test_least_squares() {
+    LeastSquaresEstimator<LeastSquaresEstimator_Affine_Traits> f(1.0f);
+    LeastSquaresEstimator<AffineTraits> q(q16(1.0f));
+
+    for (uint32 n = 0; n < 200; ++n) {
+      const float x = float(int32(n % 21) - 10);
+      const float y = 2 + x / 2 + (int32((n * 2654435761u) >> 28) - 8) / 64.0f;
+      Matrix<1, 1, float> fy; fy(0, 0) = y;
+      Matrix<2, 1, float> fa; fa(0, 0) = 1; fa(1, 0) = x;
+      Matrix<1, 1, q16> qy; qy(0, 0) = q16(y);
+      Matrix<2, 1, q16> qa; qa(0, 0) = q16(1.0f); qa(1, 0) = q16(x);
+      f.update(fy, fa);
+      q.update(qy, qa);
+    }
+    CHECK(fabsf(f.get_state(0) - 2) < 0.01f && fabsf(f.get_state(1) - 0.5f) < 0.01f);
+    if (!CHECK(max_difference(q.get_state(), f.get_state()) < 1e-3f))
+      printf("  %g %g against %g %g\n", q.get_state(0).to_float(), q.get_state(1).to_float(),
+             f.get_state(0), f.get_state(1));
+  }
+}
+
+int main() {
+  test_reciprocal<16>();
+  test_reciprocal<20>();
+  test_invert();
+  test_kalman<Kalman, 2, 1>(1e-3f);
+  test_kalman<Kalman, 4, 2>(2e-3f);
+  test_kalman<Kalman, 6, 1>(5e-3f);
+  test_kalman<SequentialKalman, 6, 2>(5e-3f);
+  test_steady_state();
+  test_least_squares();
+  return test::check_result("test_linear_algebra");
+}
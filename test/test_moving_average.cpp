@@ -0,0 +1,121 @@
+/*
+ *  test_moving_average.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/MovingAverage.h"
+#include "../util/SlidingWindow.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+using namespace util;
+
+namespace {
+  const int NB_VALUES = 20000;
+  int32 history[NB_VALUES];
+
+  /**
+   * Sorted copy of the window of the size last values ending at n
+   */
+  void sorted_window(int n, uint32 size, int32* w) {
+    for (uint32 i = 0; i < size; ++i) {
+      const int32 v = history[n + 1 - size + i];
+      uint32 j = i;
+      for (; j > 0 && w[j - 1] > v; --j)
+        w[j] = w[j - 1];
+      w[j] = v;
+    }
+  }
+
+  /**
+   * Min, max, median and sum against a brute force window
+   */
+  template <uint32 CAPACITY>
+  void test_windows(uint32 capacity) {
+    SlidingMin<int32, CAPACITY> min(capacity);
+    SlidingMax<int32, CAPACITY> max(capacity);
+    SlidingMedian<int32, CAPACITY> median(capacity);
+    MovingAverage<int32, CAPACITY> average(capacity);
+
+    for (int n = 0; n < NB_VALUES; ++n) {
+      const int32 v = history[n];
+      min.add_value(v);
+      max.add_value(v);
+      median.add_value(v);
+      average.add_value(v);
+
+      const uint32 size = uint32(n + 1) < capacity ? n + 1 : capacity;
+      int32 w[CAPACITY];
+      sorted_window(n, size, w);
+      int64 sum = 0;
+      for (uint32 i = 0; i < size; ++i)
+        sum += w[i];
+      const int32 expected_median = size & 1 ? w[size / 2] : (w[size / 2] + w[size / 2 - 1]) / 2;
+
+      if (!CHECK(min.get_value() == w[0] && max.get_value() == w[size - 1]
+                 && median.get_value() == expected_median && average.get_sum() == sum)) {
+        printf("capacity %u, value %d\n", unsigned(capacity), n);
+        return;
+      }
+    }
+  }
+
+  /**
+   * A full window of 16 bit values does not overflow the sum
+   */
+  void test_wide_sum() {
+    MovingAverage<uint16, 256> u16;
+    for (int i = 0; i < 300; ++i)
+      u16.add_value(1000);
+    CHECK(u16.get_sum() == 256000);
+    CHECK(u16.get_average<uint32>() == 1000);
+
+    MovingAverage<int16, 256> i16;
+    for (int i = 0; i < 300; ++i)
+      i16.add_value(-30000);
+    CHECK(i16.get_average<int32>() == -30000);
+
+    MovingAverage<int32, 16> i32;
+    for (int i = 0; i < 20; ++i)
+      i32.add_value(2000000000);
+    CHECK(i32.get_average<float>() == 2e9f);
+  }
+
+  /**
+   * Float sums are recomputed once per window, so that they do not drift
+   */
+  void test_float_drift() {
+    MovingAverage<float, 33> average;
+    double worst = 0;
+    for (int n = 0; n < NB_VALUES; ++n) {
+      average.add_value(history[n] * 0.001f + 1000.f);
+      const uint32 size = n + 1 < 33 ? n + 1 : 33;
+      double sum = 0;
+      for (uint32 i = 0; i < size; ++i)
+        sum += history[n - i] * 0.001f + 1000.f;
+      worst = fmax(worst, fabs(average.get_sum() - sum));
+    }
+    CHECK(worst < 0.1);
+  }
+}
+
+int main() {
+  // Many equal values one time out of three
+  for (int n = 0; n < NB_VALUES; ++n)
+    history[n] = rand() % (n % 3 ? 1000 : 10);
+
+  test_windows<1>(1);
+  test_windows<2>(2);
+  test_windows<7>(7);
+  test_windows<16>(16);
+  test_windows<64>(33);
+  test_windows<100>(100);
+  test_wide_sum();
+  test_float_drift();
+  return test::check_result("test_moving_average");
+}
@@ -0,0 +1,202 @@
+/*
+ *  test_mutex.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "host_os.h"
+#include "../os/OS_Mutex.h"
+
+using os::OS;
+using os::TaskBase;
+using os::Mutex;
+
+namespace {
+  /**
+   * A task running a function
+   */
+  class Task: public TaskBase {
+  public:
+    Task(Priority priority, void (*body)())
+    : TaskBase("task", m_stack, STACK_SIZE, priority), m_body(body) {
+    }
+
+  protected:
+    void run() {
+      m_body();
+    }
+
+  private:
+    static const uint32 STACK_SIZE = 64;
+    uint32 m_stack[STACK_SIZE];
+    void (*const m_body)();
+  };
+
+  /**
+   * Runs the tasks till they are done
+   */
+  void run(Task& a, Task& b, Task& c) {
+    OS::add(a);
+    OS::add(b);
+    OS::add(c);
+    OS::sleep_for(100);
+  }
+
+  /**
+   * A low priority owner keeps the mutex for 2ms, yielding, while a middle priority
+   * task stays busy for 20ms. The high priority waiter gets it when the owner is
+   * done, 1ms after asking, the owner running at its priority meanwhile.
+   */
+  namespace inversion {
+    Mutex mutex;
+    uint32 wait;
+    TaskBase::Priority owner_priority;
+
+    void low() {
+      mutex.acquire();
+      for (uint32 i = 0; i < 20; ++i) {
+        test::host::work(100);
+        OS::yield();
+      }
+      owner_priority = OS::get_current()->get_priority();
+      mutex.release();
+    }
+
+    void middle() {
+      OS::sleep_for(1);
+      const uint32 end = OS::get_time() + 20000;
+      while (int32(OS::get_time() - end) < 0) {
+        test::host::work(100);
+        OS::yield();
+      }
+    }
+
+    void high() {
+      OS::sleep_for(1);
+      const uint32 start = OS::get_time();
+      mutex.acquire();
+      wait = OS::get_time() - start;
+      mutex.release();
+    }
+  }
+
+  void test_inversion() {
+    static Task low(1, &inversion::low), middle(3, &inversion::middle), high(5, &inversion::high);
+    run(low, middle, high);
+    if (!CHECK(inversion::wait <= 1100))
+      printf("  waited %u us\n", inversion::wait);
+    CHECK(inversion::owner_priority == 5);
+    CHECK(low.get_priority() == 1);
+  }
+
+  /**
+   * Each mutex hands over to its own waiter
+   */
+  namespace separate {
+    Mutex first, second;
+    TaskBase* first_owner;
+    TaskBase* second_owner;
+
+    void hold() {
+      first.acquire();
+      second.acquire();
+      OS::sleep_for(5);
+      second.release();
+      OS::sleep_for(5);
+      first.release();
+    }
+
+    void wait_first() {
+      OS::sleep_for(1);
+      first.acquire();
+      first_owner = OS::get_current();
+      first.release();
+    }
+
+    void wait_second() {
+      OS::sleep_for(2);
+      second.acquire();
+      second_owner = OS::get_current();
+      second.release();
+    }
+  }
+
+  void test_separate() {
+    static Task holder(2, &separate::hold), first(2, &separate::wait_first), second(2, &separate::wait_second);
+    run(holder, first, second);
+    CHECK(separate::first_owner == &first);
+    CHECK(separate::second_owner == &second);
+  }
+
+  /**
+   * The priority goes down the chain of owners, and back up on release
+   */
+  namespace chain {
+    Mutex a, b;
+    TaskBase::Priority low_priority, middle_priority;
+
+    void low() {
+      a.acquire();
+      OS::sleep_for(5);
+      low_priority = OS::get_current()->get_priority();
+      a.release();
+    }
+
+    void middle() {
+      OS::sleep_for(1);
+      b.acquire();
+      a.acquire();
+      middle_priority = OS::get_current()->get_priority();
+      a.release();
+      b.release();
+    }
+
+    void high() {
+      OS::sleep_for(2);
+      b.acquire();
+      b.release();
+    }
+  }
+
+  void test_chain() {
+    static Task low(1, &chain::low), middle(2, &chain::middle), high(5, &chain::high);
+    run(low, middle, high);
+    CHECK(chain::low_priority == 5);
+    CHECK(chain::middle_priority == 5);
+    CHECK(low.get_priority() == 1 && middle.get_priority() == 2);
+  }
+
+  void test_ceiling() {
+    Mutex mutex(4);
+    TaskBase* main = OS::get_current();
+    mutex.acquire();
+    CHECK(main->get_priority() == 4);
+    mutex.release();
+    CHECK(main->get_priority() == main->get_base_priority());
+  }
+
+  void test_recursive() {
+    Mutex mutex;
+    CHECK(!mutex.release());
+    CHECK(mutex.try_acquire());
+    CHECK(mutex.try_acquire());
+    mutex.acquire();
+    mutex.release();
+    mutex.release();
+    CHECK(mutex.release());
+    CHECK(!mutex.release());
+  }
+}
+
+int main() {
+  test::host::start_os();
+  test_inversion();
+  test_separate();
+  test_chain();
+  test_ceiling();
+  test_recursive();
+  return test::check_result("test_mutex");
+}
@@ -0,0 +1,114 @@
+/*
+ *  test_polyphase.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/Interpolator.h"
+
+#include <math.h>
+
+using namespace util;
+
+namespace {
+  const int NB_INPUTS = 2000;
+
+  /**
+   * Block resampling of a sine against zero stuffing, filtering at the
+   * oversampled rate and decimating, with the same filter
+   */
+  template <uint32 L, uint32 M, uint32 K>
+  void test_against_reference() {
+    static float h[L * K];
+    polyphase_detail::design_lowpass(h, L * K, L, M);
+    static float x[NB_INPUTS];
+    for (int i = 0; i < NB_INPUTS; ++i)
+      x[i] = float(sin(2 * M_PI * 0.05 * i));
+
+    static float y[NB_INPUTS * L / M + 1];
+    PolyphaseInterpolator<float, L, M, K> resampler;
+    const uint32 n = resampler.process(x, NB_INPUTS, y);
+    CHECK(n == (NB_INPUTS * L + M - 1) / M);
+
+    double worst = 0;
+    for (uint32 o = 0; o < n; ++o) {
+      double expected = 0;
+      const int64 position = int64(o) * M;
+      for (uint32 j = 0; j < L * K; ++j) {
+        const int64 up = position - j;
+        if (up >= 0 && up % L == 0)
+          expected += h[j] * x[up / L];
+      }
+      worst = fmax(worst, fabs(expected - y[o]));
+    }
+    if (!CHECK(worst < 1e-5))
+      printf("L %u, M %u: %g\n", unsigned(L), unsigned(M), worst);
+  }
+
+  /**
+   * A constant input settles to the same constant, for every integer sample type
+   */
+  template <typename T>
+  void check_dc(T value) {
+    PolyphaseInterpolator<T, 2, 1, 8> resampler;
+    T out = 0;
+    for (int i = 0; i < 100; ++i) {
+      if (!resampler.interpolate(value, out))
+        resampler.interpolate(value, out);
+    }
+    const double error = fabs(double(out) - double(value));
+    if (!CHECK(error <= 1 + fabs(double(value)) * 1e-4))
+      printf("%g gives %g\n", double(value), double(out));
+  }
+
+  void test_integer_dc() {
+    check_dc<uint8>(200);
+    check_dc<int8>(-100);
+    check_dc<uint16>(40000);
+    check_dc<int16>(-20000);
+    check_dc<int16>(32767);
+    check_dc<uint32>(3000000000u);
+    check_dc<int32>(-1000000000);
+  }
+
+  /**
+   * 16 bit samples follow the float filter to within a step or two,
+   * and consume their inputs at the same points
+   */
+  void test_int16_against_float() {
+    PolyphaseInterpolator<int16, 2, 1, 8> fixed;
+    PolyphaseInterpolator<float, 2, 1, 8> floating;
+    int16 in[400];
+    for (int i = 0; i < 400; ++i)
+      in[i] = int16(20000 * sin(2 * M_PI * 0.05 * i));
+
+    uint32 consumed = 0;
+    double worst = 0;
+    bool same_consumption = true;
+    for (int o = 0; o < 780; ++o) {
+      int16 out;
+      float out_float;
+      const bool a = fixed.interpolate(in[consumed], out);
+      const bool b = floating.interpolate(float(in[consumed]), out_float);
+      same_consumption = same_consumption && a == b;
+      if (a)
+        ++consumed;
+      worst = fmax(worst, fabs(out - out_float));
+    }
+    CHECK(same_consumption);
+    CHECK(worst <= 2);
+  }
+}
+
+int main() {
+  test_against_reference<2, 1, 8>();
+  test_against_reference<3, 2, 8>();
+  test_against_reference<2, 3, 12>();
+  test_against_reference<160, 147, 8>();
+  test_integer_dc();
+  test_int16_against_float();
+  return test::check_result("test_polyphase");
+}
@@ -0,0 +1,253 @@
+/*
+ *  test_queue.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "host_os.h"
+#include "../os/OS_Queue.h"
+
+using os::OS;
+using os::TaskBase;
+
+namespace {
+  /**
+   * A task running a function with an argument
+   */
+  class Task: public TaskBase {
+  public:
+    Task(void (*body)(uint32), uint32 arg = 0, Priority priority = PRIORITY_DEFAULT)
+    : TaskBase("task", m_stack, STACK_SIZE, priority), m_body(body), m_arg(arg) {
+    }
+
+  protected:
+    void run() {
+      m_body(m_arg);
+    }
+
+  private:
+    static const uint32 STACK_SIZE = 64;
+    uint32 m_stack[STACK_SIZE];
+    void (*const m_body)(uint32);
+    const uint32 m_arg;
+  };
+
+  /**
+   * Two producers and two consumers through a 4 slot queue: each blocks in turn,
+   * every item arrives once, in order per producer
+   */
+  namespace transfer {
+    const uint32 NB_ITEMS = 20;
+
+    os::Queue<uint32, 4> queue;
+    uint32 received[2 * NB_ITEMS];
+    uint32 nb_received;
+    uint32 consumers_done;
+
+    void produce(uint32 id) {
+      for (uint32 i = 0; i < NB_ITEMS; ++i) {
+        CHECK(queue.put(id << 16 | i));
+        if (i % 3 == 0)
+          OS::yield();
+      }
+    }
+
+    void consume(uint32) {
+      for (uint32 i = 0; i < NB_ITEMS; ++i) {
+        uint32 item;
+        CHECK(queue.get(item));
+        received[nb_received++] = item;
+        test::host::work(10);
+      }
+      ++consumers_done;
+    }
+  }
+
+  void test_transfer() {
+    static Task first(&transfer::produce, 0), second(&transfer::produce, 1);
+    static Task consumer1(&transfer::consume), consumer2(&transfer::consume);
+    OS::add(first);
+    OS::add(second);
+    OS::add(consumer1);
+    OS::add(consumer2);
+    while (transfer::consumers_done < 2)
+      OS::yield();
+
+    CHECK(transfer::nb_received == 2 * transfer::NB_ITEMS);
+    uint32 next[2] = {0, 0};
+    bool ordered = true;
+    for (uint32 i = 0; i < transfer::nb_received; ++i) {
+      const uint32 id = transfer::received[i] >> 16;
+      ordered = ordered && id < 2 && (transfer::received[i] & 0xFFFF) == next[id];
+      ++next[id];
+    }
+    CHECK(ordered);
+    CHECK(next[0] == transfer::NB_ITEMS && next[1] == transfer::NB_ITEMS);
+    CHECK(transfer::queue.size() == 0);
+  }
+
+  /**
+   * get() and put() give up after the wait time, at once with no wait time
+   */
+  void test_timeout() {
+    os::Queue<uint32, 2> queue;
+    uint32 item;
+    const uint32 switches = test::host::counters().switches;
+    uint32 start = OS::get_time();
+    CHECK(!queue.get(item, 0));
+    CHECK(OS::get_time() == start && test::host::counters().switches == switches);
+
+    start = OS::get_time();
+    CHECK(!queue.get(item, 5));
+    CHECK(OS::get_time() - start == OS::ms_to_ticks(5));
+
+    CHECK(queue.put(1, 0) && queue.put(2, 0));
+    start = OS::get_time();
+    CHECK(!queue.put(3, 0));
+    CHECK(OS::get_time() == start);
+    CHECK(!queue.put(3, 3));
+    CHECK(OS::get_time() - start == OS::ms_to_ticks(3));
+    CHECK(queue.get(item, 0) && item == 1);
+    CHECK(queue.get(item, 0) && item == 2);
+    CHECK(queue.size() == 0);
+  }
+
+  /**
+   * A producer blocking between reserve() and commit() holds back the others,
+   * although there is room: the records come out whole, in order
+   */
+  namespace reserve {
+    const uint32 FRAME_SIZE = 64;
+    const uint32 NB_FRAMES = 5;
+
+    struct Frame {
+      uint32 words[FRAME_SIZE];
+    };
+
+    os::Queue<Frame, 3> queue;
+    uint32 committed[2];
+    uint32 put_dates[2 * NB_FRAMES];
+    uint32 nb_put;
+
+    void write(uint32 id) {
+      for (uint32 n = 0; n < NB_FRAMES; ++n) {
+        Frame* frame = queue.reserve();
+        const uint32 value = id << 16 | n;
+        for (uint32 i = 0; i < FRAME_SIZE / 2; ++i)
+          frame->words[i] = value;
+        OS::sleep_for(1);
+        for (uint32 i = FRAME_SIZE / 2; i < FRAME_SIZE; ++i)
+          frame->words[i] = value;
+        queue.commit();
+        put_dates[nb_put++] = OS::get_time();
+        ++committed[id];
+      }
+    }
+  }
+
+  void test_reserve() {
+    static Task first(&reserve::write, 0), second(&reserve::write, 1);
+    OS::add(first);
+    OS::add(second);
+
+    uint32 next[2] = {0, 0};
+    bool whole = true, ordered = true;
+    for (uint32 n = 0; n < 2 * reserve::NB_FRAMES; ++n) {
+      reserve::Frame frame;
+      CHECK(reserve::queue.get(frame));
+      const uint32 value = frame.words[0];
+      for (uint32 i = 1; i < reserve::FRAME_SIZE; ++i)
+        whole = whole && frame.words[i] == value;
+      const uint32 id = value >> 16;
+      ordered = ordered && id < 2 && (value & 0xFFFF) == next[id];
+      ++next[id];
+    }
+    CHECK(whole);
+    CHECK(ordered);
+    CHECK(reserve::committed[0] == reserve::NB_FRAMES && reserve::committed[1] == reserve::NB_FRAMES);
+    // Each record took 1ms to write, none overlapping
+    bool apart = true;
+    for (uint32 n = 1; n < reserve::nb_put; ++n)
+      apart = apart && reserve::put_dates[n] - reserve::put_dates[n - 1] >= OS::ms_to_ticks(1);
+    CHECK(apart);
+  }
+
+  /**
+   * A waiter woken up for an item or a slot that another task takes before it runs
+   * waits again, till its date
+   */
+  namespace woken {
+    os::Queue<uint32, 1> queue;
+    bool got;
+    uint32 item;
+    uint32 waited;
+
+    void get(uint32 ms) {
+      const uint32 start = OS::get_time();
+      got = queue.get(item, ms);
+      waited = OS::get_time() - start;
+    }
+
+    void put(uint32 ms) {
+      const uint32 start = OS::get_time();
+      got = queue.put(7, ms);
+      waited = OS::get_time() - start;
+    }
+  }
+
+  void test_woken_then_timed_out() {
+    // The consumer is woken up by put(), but main takes the item back
+    static Task consumer(&woken::get, 5);
+    OS::add(consumer);
+    OS::yield();
+    OS::sleep_for(1);
+    CHECK(woken::queue.put(1, 0));
+    uint32 item;
+    CHECK(woken::queue.get(item, 0) && item == 1);
+    OS::sleep_for(10);
+    CHECK(!woken::got);
+    CHECK(woken::waited == OS::ms_to_ticks(5));
+
+    // The producer is woken up by get(), but main fills the slot again
+    CHECK(woken::queue.put(2, 0));
+    static Task producer(&woken::put, 5);
+    OS::add(producer);
+    OS::yield();
+    OS::sleep_for(1);
+    CHECK(woken::queue.get(item, 0) && item == 2);
+    CHECK(woken::queue.put(3, 0));
+    OS::sleep_for(10);
+    CHECK(!woken::got);
+    CHECK(woken::waited == OS::ms_to_ticks(5));
+    CHECK(woken::queue.get(item, 0) && item == 3);
+  }
+
+  /**
+   * A waiter woken up for an item, but running past its date, still takes the item
+   */
+  void test_woken_late() {
+    static Task consumer(&woken::get, 2);
+    OS::add(consumer);
+    OS::yield();
+    OS::sleep_for(1);
+    CHECK(woken::queue.put(4, 0));
+    test::host::work(3000);
+    OS::yield();
+    CHECK(woken::got && woken::item == 4);
+    CHECK(woken::waited > OS::ms_to_ticks(2));
+    CHECK(woken::queue.size() == 0);
+  }
+}
+
+int main() {
+  test::host::start_os();
+  test_transfer();
+  test_timeout();
+  test_reserve();
+  test_woken_then_timed_out();
+  test_woken_late();
+  return test::check_result("test_queue");
+}
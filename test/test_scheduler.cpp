@@ -0,0 +1,119 @@
+/*
+ *  test_scheduler.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "host_os.h"
+
+#include <string.h>
+
+using os::OS;
+using os::TaskBase;
+
+namespace {
+  char trace[256];
+  uint32 trace_size = 0;
+
+  void log(char c) {
+    if (trace_size + 1 < sizeof trace)
+      trace[trace_size++] = c;
+    trace[trace_size] = 0;
+  }
+
+  bool traced(const char* expected) {
+    const bool ok = strcmp(trace, expected) == 0;
+    if (!ok)
+      printf("  trace %s, expected %s\n", trace, expected);
+    trace_size = 0;
+    trace[0] = 0;
+    return ok;
+  }
+
+  /**
+   * A task logging its name a number of times, yielding or waiting in between
+   */
+  class Logger: public TaskBase {
+  public:
+    Logger(char name, Priority priority, uint32 count, bool suspend = false)
+    : TaskBase("logger", m_stack, STACK_SIZE, priority), m_name(name), m_count(count), m_suspend(suspend) {
+    }
+
+  protected:
+    void run() {
+      for (uint32 i = 0; i < m_count; ++i) {
+        if (m_suspend)
+          OS::suspend();
+        log(m_name);
+        if (!m_suspend)
+          OS::yield();
+      }
+    }
+
+  private:
+    static const uint32 STACK_SIZE = 64;
+    uint32 m_stack[STACK_SIZE];
+    const char m_name;
+    const uint32 m_count;
+    const bool m_suspend;
+  };
+
+  /**
+   * Tasks of one priority run in turn, lower ones only when they all wait
+   */
+  void test_round_robin() {
+    static Logger a('a', TaskBase::PRIORITY_DEFAULT, 3);
+    static Logger b('b', TaskBase::PRIORITY_DEFAULT, 3);
+    static Logger low('l', TaskBase::PRIORITY_DEFAULT - 1, 1);
+    OS::add(a);
+    OS::add(low);
+    OS::add(b);
+    for (uint32 i = 0; i < 3; ++i) {
+      log('M');
+      OS::yield();
+    }
+    CHECK(traced("MabMabMab"));
+    OS::sleep_for(1);
+    CHECK(traced("l"));
+  }
+
+  /**
+   * A woken up task runs at the next yield, ahead of the lower priorities
+   */
+  void test_priority() {
+    static Logger high('h', TaskBase::PRIORITY_HIGHEST, 3, true);
+    static Logger peer('p', TaskBase::PRIORITY_DEFAULT, 4);
+    OS::add(high);
+    OS::add(peer);
+    OS::yield();
+    CHECK(traced("p"));
+    for (uint32 i = 0; i < 3; ++i) {
+      log('M');
+      OS::wakeup(&high);
+      log('W');
+      OS::yield();
+    }
+    CHECK(traced("MWhpMWhpMWhp"));
+    CHECK(high.get_priority() == TaskBase::PRIORITY_HIGHEST);
+  }
+
+  /**
+   * Priorities above the highest are clamped
+   */
+  void test_clamp() {
+    static Logger task('c', TaskBase::PRIORITY_HIGHEST + 3, 0);
+    CHECK(task.get_priority() == TaskBase::PRIORITY_HIGHEST);
+    CHECK(task.get_base_priority() == TaskBase::PRIORITY_HIGHEST);
+  }
+}
+
+int main() {
+  test::host::start_os();
+  test_round_robin();
+  test_priority();
+  test_clamp();
+  return test::check_result("test_scheduler");
+}
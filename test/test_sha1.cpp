@@ -0,0 +1,102 @@
+/*
+ *  test_sha1.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/SHA1.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace util;
+
+namespace {
+  const uint32 BUFFER_SIZE = 6000;
+  uint8 data[BUFFER_SIZE];
+
+  /**
+   * @return true if the result, in host order, is the digest written in hex
+   */
+  bool digest_is(SHA1::Result result, const char* hex) {
+    SHA1::Result expected;
+    expected.assign(hex);
+    result.to_network_order();
+    return result.matches(expected);
+  }
+
+  SHA1::Result hash_of(const char* text) {
+    SHA1 sha;
+    return sha.process(reinterpret_cast<const uint8*>(text), strlen(text)).get_result();
+  }
+
+  /**
+   * FIPS 180-2 appendix A and B examples
+   */
+  void test_vectors() {
+    CHECK(digest_is(hash_of("abc"), "a9993e364706816aba3e25717850c26c9cd0d89d"));
+    CHECK(digest_is(hash_of(""), "da39a3ee5e6b4b0d3255bfef95601890afd80709"));
+    CHECK(digest_is(hash_of("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+                    "84983e441c3bd26ebaae4aa1f95129e5e54670f1"));
+
+    uint8 a[1000];
+    memset(a, 'a', sizeof a);
+    SHA1 sha;
+    for (int i = 0; i < 1000; ++i)
+      sha.process(a, sizeof a);
+    CHECK(digest_is(sha.get_result(), "34aa973cd4c4daa4f61eeb2bdbad27316534016f"));
+  }
+
+  /**
+   * Hashing in random pieces, from any alignment, gives the same result as in one go
+   */
+  void test_splits() {
+    for (int i = 0; i < 2000; ++i) {
+      const uint32 size = rand() % 5000;
+      const uint32 offset = rand() % 8;
+      const uint8* p = data + offset;
+
+      SHA1 whole;
+      whole.process(p, size);
+
+      SHA1 pieces;
+      for (uint32 done = 0; done < size; ) {
+        uint32 piece = rand() % 200;
+        if (piece > size - done)
+          piece = size - done;
+        pieces.process(p + done, piece);
+        done += piece;
+      }
+      if (!CHECK(whole.get_result().matches(pieces.get_result())))
+        return;
+    }
+  }
+
+  /**
+   * A midstate saved on a block boundary resumes the same hash
+   */
+  void test_midstate() {
+    SHA1 sha;
+    sha.process(data, 2 * SHA1::BYTE_BLOCK_SIZE);
+    SHA1::midstate_type midstate;
+    sha.get_midstate(midstate);
+    const SHA1::Result expected = sha.process(data + 128, 1000).get_result();
+
+    SHA1 resumed;
+    resumed.set_midstate(midstate);
+    CHECK(resumed.process(data + 128, 1000).get_result().matches(expected));
+  }
+}
+
+int main() {
+  for (uint32 i = 0; i < BUFFER_SIZE; ++i)
+    data[i] = uint8(rand());
+
+  test_vectors();
+  test_splits();
+  test_midstate();
+  return test::check_result("test_sha1");
+}
@@ -0,0 +1,139 @@
+/*
+ *  test_sleep.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "host_os.h"
+
+using os::OS;
+using os::TaskBase;
+
+namespace {
+  const uint32 NB_WAKES = 64;
+
+  struct Wake {
+    uint32 task;
+    uint32 slept;
+    uint32 deadline;
+    uint32 date;
+  };
+  Wake wakes[NB_WAKES];
+  uint32 nb_wakes = 0;
+
+  /**
+   * A periodic task, recording each wake
+   */
+  class Periodic: public TaskBase {
+  public:
+    Periodic(uint32 id, uint32 period_ms, uint32 count)
+    : TaskBase("periodic", m_stack, STACK_SIZE), m_id(id), m_period(period_ms), m_count(count) {
+    }
+
+  protected:
+    void run() {
+      uint32 date = OS::get_time();
+      for (uint32 i = 0; i < m_count; ++i) {
+        const uint32 slept = OS::get_time();
+        date += OS::ms_to_ticks(m_period);
+        OS::sleep_until(date);
+        if (nb_wakes < NB_WAKES) {
+          Wake w = { m_id, slept, date, OS::get_time() };
+          wakes[nb_wakes++] = w;
+        }
+      }
+    }
+
+  private:
+    static const uint32 STACK_SIZE = 64;
+    uint32 m_stack[STACK_SIZE];
+    const uint32 m_id;
+    const uint32 m_period;
+    const uint32 m_count;
+  };
+
+  /**
+   * Periodic tasks across the counter wrap wake at their deadline, in deadline
+   * order, first come first served on ties, the CPU idling in between
+   */
+  void test_periodic() {
+    // 20ms before the counter wraps
+    test::host::work(0u - 20000 - test::host::now());
+    static Periodic a(0, 3, 10), b(1, 5, 6), c(2, 7, 4), d(3, 11, 3);
+    OS::add(a);
+    OS::add(b);
+    OS::add(c);
+    OS::add(d);
+    const uint32 idles = test::host::counters().idles;
+    OS::sleep_for(50);
+
+    CHECK(nb_wakes == 23);
+    for (uint32 i = 0; i < nb_wakes; ++i) {
+      CHECK(wakes[i].date == wakes[i].deadline);
+      if (i > 0) {
+        CHECK(wakes[i].deadline - wakes[i - 1].deadline < 0x80000000);
+        // At 15ms, b (asleep since 10ms) then a (since 12ms)
+        if (wakes[i].deadline == wakes[i - 1].deadline)
+          CHECK(wakes[i].slept - wakes[i - 1].slept < 0x80000000 && wakes[i].task != wakes[i - 1].task);
+      }
+    }
+    // One idle per distinct deadline (20), and the main task's own at 50ms
+    CHECK(test::host::counters().idles - idles == 21);
+    CHECK(test::host::counters().idle_time > 49000);
+  }
+
+  /**
+   * The OS sets its timer match with interrupts masked
+   */
+  void test_masked_match() {
+    CHECK(test::host::counters().unmasked_match_writes == 0);
+  }
+
+  /**
+   * A sleeper woken early returns at once, a past date does not sleep
+   */
+  class Sleeper: public TaskBase {
+  public:
+    Sleeper() : TaskBase("sleeper", m_stack, STACK_SIZE), woken(0) {
+    }
+
+    uint32 woken;
+
+  protected:
+    void run() {
+      OS::sleep_for(1000);
+      woken = OS::get_time();
+    }
+
+  private:
+    static const uint32 STACK_SIZE = 64;
+    uint32 m_stack[STACK_SIZE];
+  };
+
+  void test_wakeup() {
+    static Sleeper sleeper;
+    OS::add(sleeper);
+    OS::yield();
+    const uint32 start = OS::get_time();
+    test::host::work(100);
+    OS::wakeup(&sleeper);
+    OS::yield();
+    CHECK(sleeper.woken == start + 100);
+
+    const uint32 now = OS::get_time();
+    OS::sleep_until(now - 1);
+    OS::sleep_until(now);
+    CHECK(OS::get_time() == now);
+  }
+}
+
+int main() {
+  test::host::start_os();
+  test_periodic();
+  test_masked_match();
+  test_wakeup();
+  return test::check_result("test_sleep");
+}
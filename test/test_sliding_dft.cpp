@@ -0,0 +1,112 @@
+/*
+ *  test_sliding_dft.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/SlidingDFT.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+using namespace util;
+
+namespace {
+  const uint32 WINDOW = 64;
+  const uint32 NB_SAMPLES = 1000;
+  double samples[NB_SAMPLES];
+
+  /**
+   * Exact bin k over the WINDOW samples ending at n, the oldest first
+   */
+  void exact_bin(uint32 n, uint32 k, double& re, double& im) {
+    re = 0;
+    im = 0;
+    for (uint32 m = 0; m < WINDOW; ++m) {
+      const double x = n + 1 >= WINDOW - m ? samples[n + 1 + m - WINDOW] : 0;
+      re += x * cos(2 * M_PI * k * m / WINDOW);
+      im -= x * sin(2 * M_PI * k * m / WINDOW);
+    }
+  }
+
+  double to_double(float f) {
+    return f;
+  }
+
+  double to_double(const Q<16>& q) {
+    return q.to_float();
+  }
+
+  /**
+   * Every sample, the bins match the exact DFT of the last WINDOW samples
+   * @param tolerance relative to WINDOW, the largest value of a bin. The 15 bit
+   *        twiddles of SineLUT leave about 3e-4.
+   */
+  template <typename T>
+  void check_bins(SlidingDFT<T, 3, WINDOW>& dft, const uint32* k, double tolerance) {
+    double worst = 0;
+    for (uint32 n = 0; n < NB_SAMPLES; ++n) {
+      dft.add_sample(T(float(samples[n])));
+      for (uint32 i = 0; i < 3; ++i) {
+        double re, im;
+        exact_bin(n, k[i], re, im);
+        const double e = hypot(to_double(dft.get_real(i)) - re, to_double(dft.get_imaginary(i)) - im);
+        if (e > worst)
+          worst = e;
+      }
+    }
+    CHECK(worst < tolerance * WINDOW);
+  }
+
+  void test_float() {
+    const uint32 k[3] = { 0, 5, 8 };
+    SlidingDFT<float, 3, WINDOW> dft;
+    for (uint32 i = 0; i < 3; ++i)
+      dft.set_bin(i, k[i]);
+    check_bins(dft, k, 1e-3);
+  }
+
+  void test_fixed_point() {
+    const uint32 k[3] = { 1, 5, 8 };
+    SlidingDFT<Q<16>, 3, WINDOW> dft;
+    for (uint32 i = 0; i < 3; ++i)
+      dft.set_bin(i, k[i]);
+    check_bins(dft, k, 2e-3);
+  }
+
+  /**
+   * Bins set in the middle of a window are exact once it ends
+   */
+  void test_set_bin_in_window() {
+    SlidingDFT<float, 1, WINDOW> dft;
+    dft.set_bin(0, 3);
+    for (uint32 n = 0; n < WINDOW + 10; ++n)
+      dft.add_sample(float(samples[n]));
+    dft.set_bin(0, 8);
+    double worst = 0;
+    for (uint32 n = WINDOW + 10; n < 3 * WINDOW; ++n) {
+      dft.add_sample(float(samples[n]));
+      if (n >= 2 * WINDOW - 1) {
+        double re, im;
+        exact_bin(n, 8, re, im);
+        const double e = hypot(dft.get_real(0) - re, dft.get_imaginary(0) - im);
+        if (e > worst)
+          worst = e;
+      }
+    }
+    CHECK(worst < 1e-3 * WINDOW);
+  }
+}
+
+int main() {
+  for (uint32 n = 0; n < NB_SAMPLES; ++n)
+    samples[n] = 0.5 * sin(2 * M_PI * n / 8) + 0.2 * cos(2 * M_PI * 5 * n / WINDOW) + (rand() % 1000) / 5000.0;
+
+  test_float();
+  test_fixed_point();
+  test_set_bin_in_window();
+  return test::check_result("test_sliding_dft");
+}
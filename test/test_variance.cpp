@@ -0,0 +1,153 @@
+/*
+ *  test_variance.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "check.h"
+#include "../util/Variance.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+using namespace util;
+
+namespace {
+  const uint32 NB_VALUES = 10000;
+  double data[NB_VALUES];
+
+  struct Reference {
+    double mean, variance, skewness, min, max;
+  };
+
+  /**
+   * Two pass statistics of data[begin, end)
+   */
+  Reference reference(uint32 begin, uint32 end) {
+    const uint32 n = end - begin;
+    Reference r;
+    double sum = 0;
+    r.min = r.max = data[begin];
+    for (uint32 i = begin; i < end; ++i) {
+      sum += data[i];
+      if (data[i] < r.min)
+        r.min = data[i];
+      if (data[i] > r.max)
+        r.max = data[i];
+    }
+    r.mean = sum / n;
+    double s2 = 0, s3 = 0;
+    for (uint32 i = begin; i < end; ++i) {
+      const double d = data[i] - r.mean;
+      s2 += d * d;
+      s3 += d * d * d;
+    }
+    r.variance = s2 / (n - 1);
+    r.skewness = s3 * sqrt(double(n)) / pow(s2, 1.5);
+    return r;
+  }
+
+  bool close(double a, double b, double tolerance) {
+    return fabs(a - b) <= tolerance * (fabs(b) + 1e-12);
+  }
+
+  /**
+   * Skewness goes through approx_sqrt, hence the looser tolerance
+   */
+  bool matches(const Variance<double>& v, const Reference& r, uint32 n) {
+    return v.get_sample_size() == n
+      && close(v.get_mean(), r.mean, 1e-12)
+      && close(v.get_variance(), r.variance, 1e-9)
+      && close(v.get_skewness(), r.skewness, 1e-3)
+      && v.get_min() == r.min && v.get_max() == r.max;
+  }
+
+  void test_add_data() {
+    Variance<double> v;
+    for (uint32 i = 0; i < NB_VALUES; ++i)
+      v.add_data(data[i]);
+    CHECK(matches(v, reference(0, NB_VALUES), NB_VALUES));
+
+    v.reset();
+    CHECK(v.get_sample_size() == 0 && v.get_min() == 0 && v.get_max() == 0);
+    CHECK(v.get_skewness() == 0);
+  }
+
+  void test_add_block() {
+    const uint32 sizes[] = { 1, 2, 7, 256, 1000, NB_VALUES };
+    for (uint32 s = 0; s < sizeof sizes / sizeof sizes[0]; ++s) {
+      Variance<double> v;
+      for (uint32 i = 0; i < NB_VALUES; i += sizes[s])
+        v.add_block(data + i, NB_VALUES - i < sizes[s] ? NB_VALUES - i : sizes[s]);
+      v.add_block(data, 0);
+      CHECK(matches(v, reference(0, NB_VALUES), NB_VALUES));
+    }
+  }
+
+  void test_merge() {
+    for (uint32 split = 1; split < NB_VALUES; split += 997) {
+      Variance<double> a, b, empty;
+      for (uint32 i = 0; i < split; ++i)
+        a.add_data(data[i]);
+      for (uint32 i = split; i < NB_VALUES; ++i)
+        b.add_data(data[i]);
+      if (split > 1)
+        CHECK(matches(a, reference(0, split), split));
+      CHECK(matches(b, reference(split, NB_VALUES), NB_VALUES - split));
+
+      a.merge(empty);
+      a.merge(b);
+      CHECK(matches(a, reference(0, NB_VALUES), NB_VALUES));
+
+      empty.merge(b);
+      CHECK(matches(empty, reference(split, NB_VALUES), NB_VALUES - split));
+    }
+  }
+
+  /**
+   * Symmetric data has no skewness, a long right tail a positive one
+   */
+  void test_skewness() {
+    Variance<float> symmetric;
+    const float x[] = { 1, 2, 3, 4, 5 };
+    symmetric.add_block(x, 5);
+    CHECK(fabs(symmetric.get_skewness()) < 1e-4);
+
+    Variance<float> tail;
+    const float y[] = { 1, 2, 3, 4, 10 };
+    for (uint32 i = 0; i < 5; ++i)
+      tail.add_data(y[i]);
+    Variance<float> tail_block;
+    tail_block.add_block(y, 5);
+    CHECK(tail.get_skewness() > 0.5f);
+    CHECK(fabs(tail.get_skewness() - tail_block.get_skewness()) < 1e-4);
+  }
+
+  void test_fixed_point() {
+    typedef Q<16, int32> q_type;
+    Variance<q_type> v;
+    const int32 x[] = { 1, 3, 2, 6 };
+    for (uint32 i = 0; i < 4; ++i)
+      v.add_data(q_type(x[i]));
+    CHECK(fabs(v.get_mean().to_float() - 3.0f) < 1e-3);
+    CHECK(fabs(v.get_variance().to_float() - 14.0f / 3) < 1e-3);
+    CHECK(v.get_min().to_float() == 1 && v.get_max().to_float() == 6);
+  }
+}
+
+int main() {
+  srand(1);
+  for (uint32 i = 0; i < NB_VALUES; ++i) {
+    const double u = rand() / double(RAND_MAX);
+    data[i] = 100 + u * u * u * 10;
+  }
+
+  test_add_data();
+  test_add_block();
+  test_merge();
+  test_skewness();
+  test_fixed_point();
+  return test::check_result("test_variance");
+}
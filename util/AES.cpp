@@ -8,9 +8,19 @@
  */
 
 #include "AES.h"
+#include "AES_ni.h"
 #include "BitOps.h"
 #include "mem.h"
 
+#if __EMBEDDED__
+#  define assert(x)
+#else
+#  include <assert.h>
+#  include <stdio.h>
+#  include <fstream>
+#  include <iostream>
+#endif
+
 namespace util {
   
   
@@ -48,15 +58,6 @@ namespace util {
   // code to implement Advanced Encryption Standard - Rijndael
   // speed optimized version
   
-#if __EMBEDDED__
-#  define assert(x)
-#else
-#  include <assert.h>
-#  include <stdio.h>
-#  include <fstream>
-#  include <iostream>
-#endif
-  
   // todo - make faster 128 blocksize version with 128 blocksize hardcoded as necessary
   
   // internally data is stored in the state in order
@@ -90,29 +91,29 @@ namespace util {
     
     // this table needs Nb*(Nr+1)/Nk entries - up to 8*(15)/4 = 60
     // todo - remove table, note cycles every 17(?) elements
-    unsigned long Rcon[60];
+    uint32 Rcon[60];
     
     // long tables for encryption stuff
-    unsigned long T0[256];
-    unsigned long T1[256];
-    unsigned long T2[256];
-    unsigned long T3[256];
+    uint32 T0[256];
+    uint32 T1[256];
+    uint32 T2[256];
+    uint32 T3[256];
     
     // long tables for decryption stuff
-    unsigned long I0[256];
-    unsigned long I1[256];
-    unsigned long I2[256];
-    unsigned long I3[256];
+    uint32 I0[256];
+    uint32 I1[256];
+    uint32 I2[256];
+    uint32 I3[256];
     
     // huge tables - todo - ifdef out
-    unsigned long T4[256];
-    unsigned long T5[256];
-    unsigned long T6[256];
-    unsigned long T7[256];
-    unsigned long I4[256];
-    unsigned long I5[256];
-    unsigned long I6[256];
-    unsigned long I7[256];
+    uint32 T4[256];
+    uint32 T5[256];
+    uint32 T6[256];
+    uint32 T7[256];
+    uint32 I4[256];
+    uint32 I5[256];
+    uint32 I6[256];
+    uint32 I7[256];
     
     // have the tables been initialized?
     bool tablesInitialized = false;
@@ -122,7 +123,7 @@ namespace util {
 #define xmult(a) ((a)<<1) ^ (((a)&128) ? 0x01B : 0)
     
     // make 4 bytes (LSB first) into a 4 byte vector
-#define VEC4(a,b,c,d) (((unsigned long)(a)) | (((unsigned long)(b))<<8) | (((unsigned long)(c))<<16) | (((unsigned long)(d))<<24))
+#define VEC4(a,b,c,d) (((uint32)(a)) | (((uint32)(b))<<8) | (((uint32)(c))<<16) | (((uint32)(d))<<24))
     
     // get byte 0 to 3 from word a
 #define GetByte(a,n) ((unsigned char)((a) >> (n<<3)))
@@ -488,7 +489,7 @@ compute_one_final_inv(d,s,5,1,3,4,8); \
 compute_one_final_inv(d,s,6,1,3,4,8); \
 compute_one_final_inv(d,s,7,1,3,4,8); 
     
-    inline unsigned long SubByte(unsigned long data)
+    inline uint32 SubByte(uint32 data)
     { // does the SBox on this 4 byte data
       unsigned result = 0;
       result = byte_sub[data>>24];
@@ -519,7 +520,7 @@ compute_one_final_inv(d,s,7,1,3,4,8);
       out << dec;
     } // DumpCharTable
     
-    void DumpLongTable(ostream & out, const char * name, const unsigned long * table, int length)
+    void DumpLongTable(ostream & out, const char * name, const uint32 * table, int length)
     { // dump te contents of a table to a file
       int pos;
       out << name << endl << hex;
@@ -626,7 +627,7 @@ compute_one_final_inv(d,s,7,1,3,4,8);
   void AES::KeyExpansion(const unsigned char * key) {
     assert(Nk > 0);
     int i;
-    unsigned long temp, * Wb = reinterpret_cast<unsigned long*>(W); // todo not portable - Endian problems
+    uint32 temp, * Wb = reinterpret_cast<uint32*>(W); // todo not portable - Endian problems
     if (Nk <= 6)
     {
       // todo - memcpy
@@ -677,8 +678,20 @@ compute_one_final_inv(d,s,7,1,3,4,8);
     Nk = keylength  /32;
     Nb = blocklength/32;
     Nr = parameters[((Nk-4)/2 + 3*(Nb-4)/2)];
+    
+#if defined(AES_HAS_NI)
+    // The instructions only handle the standard 128 bit block
+    useNI = (Nb == 4) && aes_ni::is_supported();
+#endif
   } // SetParameters
   
+  void AES::SetAcceleration(bool enable)
+  {
+#if defined(AES_HAS_NI)
+    useNI = enable && (Nb == 4) && aes_ni::is_supported();
+#endif
+  } // SetAcceleration
+  
   void AES::StartEncryption(const unsigned char * key)
   {
     KeyExpansion(key);
@@ -689,12 +702,20 @@ compute_one_final_inv(d,s,7,1,3,4,8);
     // todo - clean up - lots of repeated macros
     // we only encrypt one block from now on
     
-    unsigned long state[8*2]; // 2 buffers
-    unsigned long * r_ptr = reinterpret_cast<unsigned long*>(W);
-    unsigned long * dest  = state;
-    unsigned long * src   = state; 
-    const unsigned long * datain = reinterpret_cast<const unsigned long*>(datain1);
-    unsigned long * dataout = reinterpret_cast<unsigned long*>(dataout1);
+#if defined(AES_HAS_NI)
+    if (useNI)
+    {
+      aes_ni::encrypt_ecb(W, Nr, datain1, dataout1, 1);
+      return;
+    }
+#endif
+    
+    uint32 state[8*2]; // 2 buffers
+    uint32 * r_ptr = reinterpret_cast<uint32*>(W);
+    uint32 * dest  = state;
+    uint32 * src   = state; 
+    const uint32 * datain = reinterpret_cast<const uint32*>(datain1);
+    uint32 * dataout = reinterpret_cast<uint32*>(dataout1);
     
     if (Nb == 4)
     {
@@ -777,6 +798,20 @@ compute_one_final_inv(d,s,7,1,3,4,8);
   {
     if (0 == numBlocks)
       return;
+    
+#if defined(AES_HAS_NI)
+    if (useNI)
+    {
+      unsigned char iv[16];
+      memset(iv,0,sizeof(iv)); // same zero Initialization Vector as below
+      if (mode == ECB)
+        aes_ni::encrypt_ecb(W, Nr, datain, dataout, numBlocks);
+      else
+        aes_ni::encrypt_cbc(W, Nr, iv, datain, dataout, numBlocks);
+      return;
+    }
+#endif
+    
     unsigned int blocksize = Nb*4;
     switch (mode)
     {
@@ -839,7 +874,7 @@ compute_one_final_inv(d,s,7,1,3,4,8);
     }
     
     // we reverse the rounds to make decryption faster
-    unsigned long * WL = reinterpret_cast<unsigned long*>(W);
+    uint32 * WL = reinterpret_cast<uint32*>(W);
     for (int pos = 0; pos < Nr/2; pos++)
       for (int col = 0; col < Nb; col++)
         swap(WL[col+pos*Nb],WL[col+(Nr-pos)*Nb]);
@@ -847,13 +882,21 @@ compute_one_final_inv(d,s,7,1,3,4,8);
   
   void AES::DecryptBlock(const unsigned char * datain1, unsigned char * dataout1)
   {
-    unsigned long state[8*2]; // 2 buffers
-    unsigned long * r_ptr = reinterpret_cast<unsigned long*>(W);
-    unsigned long * dest  = state;
-    unsigned long * src   = state; 
+#if defined(AES_HAS_NI)
+    if (useNI)
+    {
+      aes_ni::decrypt_ecb(W, Nr, datain1, dataout1, 1);
+      return;
+    }
+#endif
+    
+    uint32 state[8*2]; // 2 buffers
+    uint32 * r_ptr = reinterpret_cast<uint32*>(W);
+    uint32 * dest  = state;
+    uint32 * src   = state; 
     
-    const unsigned long * datain = reinterpret_cast<const unsigned long*>(datain1);
-    unsigned long * dataout = reinterpret_cast<unsigned long*>(dataout1);
+    const uint32 * datain = reinterpret_cast<const uint32*>(datain1);
+    uint32 * dataout = reinterpret_cast<uint32*>(dataout1);
     
     if (Nb == 4)
     {
@@ -935,6 +978,20 @@ compute_one_final_inv(d,s,7,1,3,4,8);
   {
     if (0 == numBlocks)
       return;
+    
+#if defined(AES_HAS_NI)
+    if (useNI)
+    {
+      unsigned char iv[16];
+      memset(iv,0,sizeof(iv)); // same zero Initialization Vector as below
+      if (mode == ECB)
+        aes_ni::decrypt_ecb(W, Nr, datain, dataout, numBlocks);
+      else
+        aes_ni::decrypt_cbc(W, Nr, iv, datain, dataout, numBlocks);
+      return;
+    }
+#endif
+    
     unsigned int blocksize = Nb*4;
     switch (mode)
     {
@@ -972,8 +1029,34 @@ compute_one_final_inv(d,s,7,1,3,4,8);
     }
   } // Decrypt
   
+  void AES::EncryptCTR(unsigned char * counter, const unsigned char * datain, unsigned char * dataout, unsigned long numBlocks)
+  {
+#if defined(AES_HAS_NI)
+    if (useNI)
+    {
+      aes_ni::crypt_ctr(W, Nr, counter, datain, dataout, numBlocks);
+      return;
+    }
+#endif
+    
+    unsigned char keystream[16];
+    while (numBlocks)
+    {
+      EncryptBlock(counter,keystream);
+      for (unsigned int pos = 0; pos < 16; ++pos)
+        *dataout++ = *datain++ ^ keystream[pos];
+      
+      // 32 bit big endian increment
+      for (unsigned int pos = 16; pos > 12; --pos)
+        if (++counter[pos-1])
+          break;
+      --numBlocks;
+    }
+  } // EncryptCTR
+  
   // the constructor - makes sure local things are initialized
   AES::AES(void)
+  : useNI(false)
   {
     if (!tablesInitialized)
       tablesInitialized = CreateAESTables(true,false);
@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include "base.h"
+
 namespace util {
   /*
    AES - Advanced Encryption Standard
@@ -97,6 +99,13 @@ namespace util {
        */
       void SetParameters(int keylength = 128, int blocklength = 128);
       
+      /**
+       * Allows the AES-NI instructions, on the hosts that have them, for 128 bit blocks.
+       * They are allowed by default; without them, the tables are used, e.g. as a
+       * reference. Call after SetParameters, before the key is set.
+       */
+      void SetAcceleration(bool enable);
+      
       /**
        * call this before any encryption with the key to use
        */
@@ -134,6 +143,28 @@ namespace util {
        */
       void Decrypt(const unsigned char * datain, unsigned char * dataout, unsigned long numBlocks, BlockMode mode = CBC);
       
+      /**
+       * Counter mode encryption or decryption of 128 bit blocks, after StartEncryption.
+       * The counter block is a 96 bit nonce followed by a 32 bit big endian counter,
+       * as in util::CTR, and is advanced by numBlocks.
+       */
+      void EncryptCTR(unsigned char * counter, const unsigned char * datain, unsigned char * dataout, unsigned long numBlocks);
+      
+      /**
+       * Block size for the cipher modes, which only use the standard 128 bit block
+       */
+      enum {
+        BYTE_BLOCK_SIZE = 16
+      };
+      
+      /**
+       * In-place single block encryption, as used by the cipher modes (see CTR.h, GCM.h).
+       * StartEncryption must have been called.
+       */
+      void encrypt_ecb(unsigned char * block) {
+        EncryptBlock(block, block);
+      }
+      
     private:
       
       int Nb,Nk;    // block and key length / 32, should be 4,6,or 8
@@ -141,6 +172,8 @@ namespace util {
       
       unsigned char W[4*8*15];   // the expanded key
       
+      bool useNI;   // AES-NI instructions in use, on x86-64 hosts with 128 bit blocks
+      
       /**
        * Key expansion code - makes local copy
        */
@@ -10,13 +10,14 @@
 #pragma once
 
 #include "base.h"
-#include "aes256.h"
 
 namespace util {
   /**
    * Implements the AES-256 cipher.
    * Each block is encrypted in-place.
-   * It always operates in CBC mode
+   * It always operates in CBC mode.
+   * The key schedules are expanded once, in set_key(), and the rounds
+   * work on 32 bit columns through a single 1KB table per direction.
    */
   class AES256: NoCopy {
   public:
@@ -43,11 +44,7 @@ namespace util {
     /**
      * Sets the key used to encrypt the data. The key size must be 256 bits, that is, 32 bytes long.
      */
-    this_type& set_key(const key_type& key) {
-      reset();
-      aes256_init(&m_ctx, key);
-      return *this;
-    }
+    this_type& set_key(const key_type& key);
     
     /**
      * Encrypts one block of data.
@@ -57,7 +54,7 @@ namespace util {
       for (size_type i = 0 ; i < BYTE_BLOCK_SIZE; ++i)
         block[i] ^= m_init_vector[i];
 
-      aes256_encrypt_ecb(&m_ctx, block);
+      encrypt_ecb(block);
 
       for (size_type i = 0 ; i < BYTE_BLOCK_SIZE; ++i)
         m_init_vector[i] = block[i];
@@ -75,7 +72,7 @@ namespace util {
         current_ciphertext[i] = block[i];
       }
 
-      aes256_decrypt_ecb(&m_ctx, block);
+      decrypt_ecb(block);
             
       for (size_type i = 0 ; i < BYTE_BLOCK_SIZE; ++i) {
         // Undo block chaining
@@ -110,8 +107,21 @@ namespace util {
       return *this;
     }
 
+    /**
+     * Single block, in-place ECB operations. The chaining state is not used.
+     * These are the building blocks for the other cipher modes.
+     */
+    void encrypt_ecb(value_type* block) const;
+    void decrypt_ecb(value_type* block) const;
+
   private:
-    aes256_context m_ctx;
+    enum {
+      NB_ROUNDS = 14,
+      SCHEDULE_SIZE_32 = 4 * (NB_ROUNDS + 1)
+    };
+    
+    uint32 m_encrypt_key[SCHEDULE_SIZE_32];
+    uint32 m_decrypt_key[SCHEDULE_SIZE_32];
     block_type m_init_vector;
   };
 }
@@ -0,0 +1,209 @@
+/*
+ *  AES_ni.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "AES_ni.h"
+
+#if defined(AES_HAS_NI)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define AES_NI_TARGET __attribute__((target("aes,sse4.1")))
+
+namespace util {
+  namespace aes_ni {
+    namespace {
+      const uint32 MAX_ROUNDS = 14;
+
+      AES_NI_TARGET inline
+      void load_keys(__m128i* k, const uint8* round_keys, uint32 nr) {
+        for (uint32 i = 0; i <= nr; ++i)
+          k[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_keys + 16 * i));
+      }
+
+      AES_NI_TARGET inline
+      __m128i encrypt1(const __m128i* k, uint32 nr, __m128i b) {
+        b = _mm_xor_si128(b, k[0]);
+        for (uint32 r = 1; r < nr; ++r)
+          b = _mm_aesenc_si128(b, k[r]);
+        return _mm_aesenclast_si128(b, k[nr]);
+      }
+
+      AES_NI_TARGET inline
+      __m128i decrypt1(const __m128i* k, uint32 nr, __m128i b) {
+        b = _mm_xor_si128(b, k[0]);
+        for (uint32 r = 1; r < nr; ++r)
+          b = _mm_aesdec_si128(b, k[r]);
+        return _mm_aesdeclast_si128(b, k[nr]);
+      }
+
+      AES_NI_TARGET inline
+      void encrypt4(const __m128i* k, uint32 nr, __m128i* b) {
+        b[0] = _mm_xor_si128(b[0], k[0]);
+        b[1] = _mm_xor_si128(b[1], k[0]);
+        b[2] = _mm_xor_si128(b[2], k[0]);
+        b[3] = _mm_xor_si128(b[3], k[0]);
+        for (uint32 r = 1; r < nr; ++r) {
+          b[0] = _mm_aesenc_si128(b[0], k[r]);
+          b[1] = _mm_aesenc_si128(b[1], k[r]);
+          b[2] = _mm_aesenc_si128(b[2], k[r]);
+          b[3] = _mm_aesenc_si128(b[3], k[r]);
+        }
+        b[0] = _mm_aesenclast_si128(b[0], k[nr]);
+        b[1] = _mm_aesenclast_si128(b[1], k[nr]);
+        b[2] = _mm_aesenclast_si128(b[2], k[nr]);
+        b[3] = _mm_aesenclast_si128(b[3], k[nr]);
+      }
+
+      AES_NI_TARGET inline
+      void decrypt4(const __m128i* k, uint32 nr, __m128i* b) {
+        b[0] = _mm_xor_si128(b[0], k[0]);
+        b[1] = _mm_xor_si128(b[1], k[0]);
+        b[2] = _mm_xor_si128(b[2], k[0]);
+        b[3] = _mm_xor_si128(b[3], k[0]);
+        for (uint32 r = 1; r < nr; ++r) {
+          b[0] = _mm_aesdec_si128(b[0], k[r]);
+          b[1] = _mm_aesdec_si128(b[1], k[r]);
+          b[2] = _mm_aesdec_si128(b[2], k[r]);
+          b[3] = _mm_aesdec_si128(b[3], k[r]);
+        }
+        b[0] = _mm_aesdeclast_si128(b[0], k[nr]);
+        b[1] = _mm_aesdeclast_si128(b[1], k[nr]);
+        b[2] = _mm_aesdeclast_si128(b[2], k[nr]);
+        b[3] = _mm_aesdeclast_si128(b[3], k[nr]);
+      }
+
+      inline
+      __m128i load(const uint8* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      }
+
+      inline
+      void store(uint8* p, __m128i v) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+      }
+    }
+
+    bool is_supported() {
+      static bool checked = false;
+      static bool supported = false;
+      if (!checked) {
+        unsigned int eax, ebx, ecx, edx;
+        supported = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES) && (ecx & bit_SSE4_1);
+        checked = true;
+      }
+      return supported;
+    }
+
+    AES_NI_TARGET
+    void encrypt_ecb(const uint8* round_keys, uint32 nr, const uint8* in, uint8* out, uint32 nblocks) {
+      __m128i k[MAX_ROUNDS + 1];
+      load_keys(k, round_keys, nr);
+
+      for (; nblocks >= 4; nblocks -= 4, in += 64, out += 64) {
+        __m128i b[4] = { load(in), load(in + 16), load(in + 32), load(in + 48) };
+        encrypt4(k, nr, b);
+        store(out, b[0]);
+        store(out + 16, b[1]);
+        store(out + 32, b[2]);
+        store(out + 48, b[3]);
+      }
+      for (; nblocks; --nblocks, in += 16, out += 16)
+        store(out, encrypt1(k, nr, load(in)));
+    }
+
+    AES_NI_TARGET
+    void decrypt_ecb(const uint8* round_keys, uint32 nr, const uint8* in, uint8* out, uint32 nblocks) {
+      __m128i k[MAX_ROUNDS + 1];
+      load_keys(k, round_keys, nr);
+
+      for (; nblocks >= 4; nblocks -= 4, in += 64, out += 64) {
+        __m128i b[4] = { load(in), load(in + 16), load(in + 32), load(in + 48) };
+        decrypt4(k, nr, b);
+        store(out, b[0]);
+        store(out + 16, b[1]);
+        store(out + 32, b[2]);
+        store(out + 48, b[3]);
+      }
+      for (; nblocks; --nblocks, in += 16, out += 16)
+        store(out, decrypt1(k, nr, load(in)));
+    }
+
+    AES_NI_TARGET
+    void encrypt_cbc(const uint8* round_keys, uint32 nr, uint8* iv, const uint8* in, uint8* out, uint32 nblocks) {
+      __m128i k[MAX_ROUNDS + 1];
+      load_keys(k, round_keys, nr);
+
+      __m128i chain = load(iv);
+      for (; nblocks; --nblocks, in += 16, out += 16) {
+        chain = encrypt1(k, nr, _mm_xor_si128(chain, load(in)));
+        store(out, chain);
+      }
+      store(iv, chain);
+    }
+
+    AES_NI_TARGET
+    void decrypt_cbc(const uint8* round_keys, uint32 nr, uint8* iv, const uint8* in, uint8* out, uint32 nblocks) {
+      __m128i k[MAX_ROUNDS + 1];
+      load_keys(k, round_keys, nr);
+
+      // Ciphertext is loaded before the plaintext is stored, so in may equal out
+      __m128i chain = load(iv);
+      for (; nblocks >= 4; nblocks -= 4, in += 64, out += 64) {
+        const __m128i c[4] = { load(in), load(in + 16), load(in + 32), load(in + 48) };
+        __m128i b[4] = { c[0], c[1], c[2], c[3] };
+        decrypt4(k, nr, b);
+        store(out, _mm_xor_si128(b[0], chain));
+        store(out + 16, _mm_xor_si128(b[1], c[0]));
+        store(out + 32, _mm_xor_si128(b[2], c[1]));
+        store(out + 48, _mm_xor_si128(b[3], c[2]));
+        chain = c[3];
+      }
+      for (; nblocks; --nblocks, in += 16, out += 16) {
+        const __m128i c = load(in);
+        store(out, _mm_xor_si128(decrypt1(k, nr, c), chain));
+        chain = c;
+      }
+      store(iv, chain);
+    }
+
+    AES_NI_TARGET
+    void crypt_ctr(const uint8* round_keys, uint32 nr, uint8* counter, const uint8* in, uint8* out, uint32 nblocks) {
+      __m128i k[MAX_ROUNDS + 1];
+      load_keys(k, round_keys, nr);
+
+      // The big endian counter is kept in host order, and inserted into each block
+      const __m128i nonce = load(counter);
+      uint32 count = (uint32(counter[12]) << 24) | (uint32(counter[13]) << 16) | (uint32(counter[14]) << 8) | counter[15];
+
+      for (; nblocks >= 4; nblocks -= 4, in += 64, out += 64) {
+        __m128i b[4];
+        for (uint32 i = 0; i < 4; ++i)
+          b[i] = _mm_insert_epi32(nonce, static_cast<int>(__builtin_bswap32(count + i)), 3);
+        count += 4;
+        encrypt4(k, nr, b);
+        store(out, _mm_xor_si128(b[0], load(in)));
+        store(out + 16, _mm_xor_si128(b[1], load(in + 16)));
+        store(out + 32, _mm_xor_si128(b[2], load(in + 32)));
+        store(out + 48, _mm_xor_si128(b[3], load(in + 48)));
+      }
+      for (; nblocks; --nblocks, in += 16, out += 16) {
+        const __m128i b = _mm_insert_epi32(nonce, static_cast<int>(__builtin_bswap32(count)), 3);
+        ++count;
+        store(out, _mm_xor_si128(encrypt1(k, nr, b), load(in)));
+      }
+
+      counter[12] = count >> 24;
+      counter[13] = count >> 16;
+      counter[14] = count >> 8;
+      counter[15] = count;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ *  AES_ni.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "base.h"
+
+/*
+ * Only on x86-64 Linux host builds with the wx types, as CRC32_HAS_CLMUL:
+ * the embedded types do not fit these hosts.
+ */
+#if defined(__x86_64__) && defined(__linux__) && !defined(USE_EMBEDDED)
+#  define AES_HAS_NI 1
+#endif
+
+#if defined(AES_HAS_NI)
+namespace util {
+  /**
+   * AES-NI primitives for x86-64 host builds, used by util::AES for 128 bit blocks.
+   * The round keys are the nr + 1 blocks of a FIPS-197 byte ordered schedule;
+   * for decryption, the equivalent inverse cipher schedule in reverse order.
+   * Independent blocks are processed 4 at a time to fill the AES unit pipeline.
+   */
+  namespace aes_ni {
+    /**
+     * @return true if the processor has the AES instructions. Checked once.
+     */
+    bool is_supported();
+
+    void encrypt_ecb(const uint8* round_keys, uint32 nr, const uint8* in, uint8* out, uint32 nblocks);
+    void decrypt_ecb(const uint8* round_keys, uint32 nr, const uint8* in, uint8* out, uint32 nblocks);
+
+    /**
+     * CBC, the chaining vector is updated. Only decryption runs blocks in parallel.
+     */
+    void encrypt_cbc(const uint8* round_keys, uint32 nr, uint8* iv, const uint8* in, uint8* out, uint32 nblocks);
+    void decrypt_cbc(const uint8* round_keys, uint32 nr, uint8* iv, const uint8* in, uint8* out, uint32 nblocks);
+
+    /**
+     * CTR with a 96 bit nonce and 32 bit big endian counter, as util::CTR.
+     * The counter block is advanced by nblocks.
+     */
+    void crypt_ctr(const uint8* round_keys, uint32 nr, uint8* counter, const uint8* in, uint8* out, uint32 nblocks);
+  }
+}
+#endif
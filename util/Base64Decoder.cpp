@@ -8,6 +8,7 @@
  */
 
 #include "Base64Decoder.h"
+#include "Base64_simd.h"
 
 namespace util {
 
@@ -66,7 +67,70 @@ namespace util {
     }
   }
 #endif
-  
+
+  /**
+   * Six bit values for the bulk kernels, 0xff for anything which needs
+   * the state machine: padding, line breaks and invalid characters
+   */
+  static const uint8 char_to_six_bulk[256] =
+  {
+  /*          0     1     2     3     4     5     6     7     8     9     A     B     C     D     E     F */
+  /* 0 */ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* 1 */ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* 2 */ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,   62, 0xff, 0xff, 0xff,   63,
+  /* 3 */   52,   53,   54,   55,   56,   57,   58,   59,   60,   61, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* 4 */ 0xff,    0,    1,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,   12,   13,   14,
+  /* 5 */   15,   16,   17,   18,   19,   20,   21,   22,   23,   24,   25, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* 6 */ 0xff,   26,   27,   28,   29,   30,   31,   32,   33,   34,   35,   36,   37,   38,   39,   40,
+  /* 7 */   41,   42,   43,   44,   45,   46,   47,   48,   49,   50,   51, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* 8 */ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* 9 */ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* A */ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* B */ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* C */ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* D */ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* E */ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  /* F */ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+  };
+
+  /**
+   * Decodes whole groups of 4 characters into 3 bytes, up to the first group
+   * holding a character outside the alphabet
+   * @return the number of characters consumed, a multiple of 4
+   */
+  static Base64Decoder::size_type decode_groups(const char* b64, Base64Decoder::size_type size,
+                                                Base64Decoder::value_type* dest) {
+    const char* const start = b64;
+
+#if defined(BASE64_HAS_SSSE3)
+    if (base64_ssse3::is_supported()) {
+      const uint32 n = base64_ssse3::decode(b64, size, dest);
+      b64 += n;
+      size -= n;
+      dest += n / 4 * 3;
+    }
+#endif
+
+    while (size >= 4) {
+      const uint8* c = reinterpret_cast<const uint8*>(b64);
+      const uint32 a = char_to_six_bulk[c[0]];
+      const uint32 b = char_to_six_bulk[c[1]];
+      const uint32 d = char_to_six_bulk[c[2]];
+      const uint32 e = char_to_six_bulk[c[3]];
+      if ((a | b | d | e) & 0x80)
+        break;
+
+      const uint32 w = a << 18 | b << 12 | d << 6 | e;
+      dest[0] = w >> 16;
+      dest[1] = w >> 8;
+      dest[2] = w;
+      b64 += 4;
+      size -= 4;
+      dest += 3;
+    }
+    return b64 - start;
+  }
+
   /**
    *
    */
@@ -81,6 +145,8 @@ namespace util {
     } else if (six_bits == 64) {
       // We have reached the end of the base 64
       return DONE;
+    } else if (six_bits == ERR) {
+      return ERROR_NOT_BASE64;
     }
     
     switch (m_b64_index & 0x03) {
@@ -120,6 +186,34 @@ namespace util {
   }
 
 
+  Base64Decoder::Status Base64Decoder::process(const char* b64, size_type size,
+                                               value_type* dest, size_type& dest_size) {
+    dest_size = 0;
+    while (size) {
+      // Bulk decoding when at the start of a group
+      if ((m_b64_index & 0x03) == 0) {
+        const size_type n = decode_groups(b64, size, dest + dest_size);
+        b64 += n;
+        size -= n;
+        dest_size += n / 4 * 3;
+        m_b64_index += n;
+        if (!size)
+          break;
+      }
+
+      // What the bulk kernels left: line breaks, padding, errors and tails
+      value_type b;
+      const Status status = process(static_cast<value_type>(*b64++), b);
+      --size;
+      if (status == OK_BYTE) {
+        dest[dest_size++] = b;
+      } else if (status != OK_NO_BYTE) {
+        return status;
+      }
+    }
+    return dest_size ? OK_BYTE : OK_NO_BYTE;
+  }
+
 #if 0
   Base64Decoder::Status Base64Decoder::process(buffer_type& src,
                                                buffer_type& dest) {    
@@ -35,8 +35,24 @@ namespace util {
     Status process(value_type b64, value_type &b);
 
     /**
+     * Processes a span of characters. Whole groups of 4 go through the bulk kernels,
+     * the single character state machine only handles line breaks, padding and tails.
+     * @param dest must hold get_max_out_size(size) bytes
+     * @param dest_size set to the number of bytes written
+     * @return DONE on padding, ERROR_NOT_BASE64 on an invalid character, the bytes decoded
+     *         before either being in dest; else OK_BYTE if any byte was written, or OK_NO_BYTE
      */
-    // Status process(buffer_type& b64, buffer_type& dest);
+    Status process(const char* b64, size_type size, value_type* dest, size_type& dest_size);
+
+    /**
+     * Decodes a whole area in one go, as process() does from a reset decoder
+     */
+    static Status decode(const char* b64, size_type size, value_type* dest, size_type& dest_size);
+
+    /**
+     * Evaluates the largest out size for a given in_size
+     */
+    static size_type get_max_out_size(size_type in_size);
     
   private:
     size_type m_b64_index;
@@ -49,4 +65,17 @@ namespace util {
   inline void Base64Decoder::reset() {
     m_b64_index = 0;
   }
+
+  inline
+  Base64Decoder::Status Base64Decoder::decode(const char* b64, size_type size,
+                                              value_type* dest, size_type& dest_size) {
+    Base64Decoder d64;
+    return d64.process(b64, size, dest, dest_size);
+  }
+
+  inline
+  Base64Decoder::size_type Base64Decoder::get_max_out_size(size_type in_size) {
+    // We unpack 4 bytes into 3 bytes, a partial group yields at most 2
+    return (in_size + 3) / 4 * 3;
+  }
 }
@@ -8,6 +8,7 @@
  */
 
 #include "Base64Encoder.h"
+#include "Base64_simd.h"
 
 using util::Base64Encoder;
 
@@ -106,22 +107,41 @@ Base64Encoder::out_value_type Base64Encoder::read_end() {
 }
 
 void Base64Encoder::process(const in_value_type* area, size_type in_size, out_value_type* dest) {
-  Base64Encoder e64;
-  const uint32 NR = 4;
-  uint32 ti = 0;
-  uint32 to = 0;
-  
-  while (in_size) {
-    const uint32 i = e64.write(area + ti, in_size);
-    ti += i;
-    in_size -= i;
-    
-    const uint32 o = e64.read(dest + to, NR);
-    to += o;
+  dest[encode(area, in_size, dest)] = '\x00';
+}
+
+Base64Encoder::size_type Base64Encoder::encode(const in_value_type* area, size_type in_size, out_value_type* dest) {
+  out_value_type* const start = dest;
+
+#if defined(BASE64_HAS_SSSE3)
+  if (util::base64_ssse3::is_supported()) {
+    const size_type n = util::base64_ssse3::encode(area, in_size, dest);
+    area += n;
+    in_size -= n;
+    dest += n / 3 * 4;
   }
-  // TODO: GET REMAINING BYTES AND PADDING
-  out_value_type c;
-  while ((c = e64.read_end()) != '\x00') {
-    dest[to++] = c;
+#endif
+
+  // Whole groups, 3 bytes to 4 characters
+  while (in_size >= 3) {
+    const uint32 w = area[0] << 16 | area[1] << 8 | area[2];
+    dest[0] = t64[w >> 18];
+    dest[1] = t64[(w >> 12) & 0x3f];
+    dest[2] = t64[(w >> 6) & 0x3f];
+    dest[3] = t64[w & 0x3f];
+    area += 3;
+    in_size -= 3;
+    dest += 4;
+  }
+
+  // Padded tail
+  if (in_size) {
+    const uint32 w = area[0] << 16 | (in_size == 2 ? area[1] << 8 : 0);
+    dest[0] = t64[w >> 18];
+    dest[1] = t64[(w >> 12) & 0x3f];
+    dest[2] = in_size == 2 ? t64[(w >> 6) & 0x3f] : '=';
+    dest[3] = '=';
+    dest += 4;
   }
+  return dest - start;
 }
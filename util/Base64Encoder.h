@@ -49,6 +49,13 @@ namespace util {
      * The destination area *must* be big enough to accomodate the result plus a final '\0'.
      */
     static void process(const in_value_type* area, size_type in_size, out_value_type* dest);
+
+    /**
+     * Encodes a whole area in one go, 3 bytes to a word at a time, or through SIMD on host
+     * builds. The destination area must hold get_out_size(in_size) characters; no '\0' is added.
+     * @return the number of characters written, padding included
+     */
+    static size_type encode(const in_value_type* area, size_type in_size, out_value_type* dest);
         
   private:    
     static const out_value_type t64[];
@@ -0,0 +1,208 @@
+/*
+ *  Base64Stream.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "base.h"
+#include "Reader.h"
+#include "Writer.h"
+#include "Base64Encoder.h"
+#include "Base64Decoder.h"
+
+namespace util {
+  /**
+   * A writer which Base64 encodes the data on its way to another writer.
+   * Whole groups of 3 bytes are encoded a chunk at a time, up to 2 bytes are
+   * held until the next write. finish() writes them out, with the padding.
+   */
+  class Base64Writer: public Writer {
+  public:
+    explicit Base64Writer(Writer& writer)
+    : m_writer(writer), m_pending_size(0) {
+    }
+
+    ~Base64Writer() {
+    }
+
+    /**
+     * Encodes and writes bytes
+     * @return the number of bytes taken, all of them unless the underlying writer stalls
+     */
+    size_type write(const uint8 *bytes, size_type count) {
+      size_type taken = 0;
+
+      // Complete the pending group
+      if (m_pending_size) {
+        while (m_pending_size < 3 && taken < count)
+          m_pending[m_pending_size++] = bytes[taken++];
+        if (m_pending_size < 3)
+          return taken;
+        if (!send(m_pending, 3))
+          return taken;
+        m_pending_size = 0;
+      }
+
+      // Whole groups
+      while (count - taken >= 3) {
+        size_type chunk = (count - taken) / 3 * 3;
+        if (chunk > CHUNK_BYTE_SIZE)
+          chunk = CHUNK_BYTE_SIZE;
+        if (!send(bytes + taken, chunk))
+          return taken;
+        taken += chunk;
+      }
+
+      // Keep the rest for later
+      while (taken < count)
+        m_pending[m_pending_size++] = bytes[taken++];
+      return taken;
+    }
+
+    /**
+     * Writes the held bytes and the padding. The writer may then start a new encoding.
+     * @return false if the underlying writer stalled
+     */
+    bool finish() {
+      const bool ok = send(m_pending, m_pending_size);
+      m_pending_size = 0;
+      return ok;
+    }
+
+  private:
+    enum {
+      CHUNK_BYTE_SIZE = 48
+    };
+
+    bool send(const uint8* bytes, size_type count) {
+      const size_type size = Base64Encoder::encode(bytes, count, m_chunk);
+      const uint8* chars = reinterpret_cast<const uint8*>(m_chunk);
+      size_type sent = 0;
+      while (sent < size) {
+        const size_type w = m_writer.write(chars + sent, size - sent);
+        if (w == 0)
+          return false;
+        sent += w;
+      }
+      return true;
+    }
+
+    Writer& m_writer;
+    uint8 m_pending[3];
+    size_type m_pending_size;
+    char m_chunk[CHUNK_BYTE_SIZE / 3 * 4];
+  };
+
+  /**
+   * A reader which decodes the Base64 read from another reader.
+   * Line breaks are skipped; reading stops at the padding or at the first
+   * character outside the alphabet, which get_status() then tells apart.
+   * Reads shorter than a group of 3 bytes decode the next group aside, and
+   * are served from it.
+   */
+  class Base64Reader: public Reader {
+  public:
+    explicit Base64Reader(Reader& reader)
+    : m_reader(reader), m_status(Base64Decoder::OK_NO_BYTE), m_carry_offset(0), m_carry_size(0) {
+    }
+
+    ~Base64Reader() {
+    }
+
+    /**
+     * Receives and decodes bytes
+     * @return the number of bytes decoded, 0 at the end of the data
+     */
+    size_type read(uint8 *bytes, size_type count) {
+      size_type done = take_carry(bytes, count);
+      while (done < count && !is_ended()) {
+        // Never read more characters than can be decoded into what is left
+        size_type chars = (count - done) / 3 * 4;
+        if (chars == 0) {
+          if (!fill_carry())
+            break;
+          done += take_carry(bytes + done, count - done);
+          continue;
+        }
+        if (chars > CHUNK_CHAR_SIZE)
+          chars = CHUNK_CHAR_SIZE;
+
+        const size_type r = m_reader.read(m_chunk, chars);
+        if (r == 0)
+          break;
+
+        Base64Decoder::size_type decoded;
+        m_status = m_decoder.process(reinterpret_cast<const char*>(m_chunk), r, bytes + done, decoded);
+        done += decoded;
+      }
+      return done;
+    }
+
+    /**
+     * @return DONE after the padding, ERROR_NOT_BASE64 after an invalid character
+     */
+    Base64Decoder::Status get_status() const {
+      return m_status;
+    }
+
+    /**
+     * Starts a new decoding
+     */
+    void reset() {
+      m_decoder.reset();
+      m_status = Base64Decoder::OK_NO_BYTE;
+      m_carry_offset = 0;
+      m_carry_size = 0;
+    }
+
+  private:
+    enum {
+      CHUNK_CHAR_SIZE = 64
+    };
+
+    /**
+     * Decodes up to the next group into the carry, which must be empty.
+     * Fewer than 4 characters never decode to more than 3 bytes, whatever
+     * the decoder kept from the previous characters.
+     * @return false if the underlying reader had nothing
+     */
+    bool fill_carry() {
+      const size_type r = m_reader.read(m_chunk, 4);
+      if (r == 0)
+        return false;
+
+      Base64Decoder::size_type decoded;
+      m_status = m_decoder.process(reinterpret_cast<const char*>(m_chunk), r, m_carry, decoded);
+      m_carry_offset = 0;
+      m_carry_size = decoded;
+      return true;
+    }
+
+    /**
+     * Copies out what is left of the carry
+     * @return the number of bytes copied
+     */
+    size_type take_carry(uint8* bytes, size_type count) {
+      size_type taken = 0;
+      while (taken < count && m_carry_offset < m_carry_size)
+        bytes[taken++] = m_carry[m_carry_offset++];
+      return taken;
+    }
+
+    bool is_ended() const {
+      return m_status == Base64Decoder::DONE || m_status == Base64Decoder::ERROR_NOT_BASE64;
+    }
+
+    Reader& m_reader;
+    Base64Decoder m_decoder;
+    Base64Decoder::Status m_status;
+    uint8 m_chunk[CHUNK_CHAR_SIZE];
+    uint8 m_carry[3];
+    size_type m_carry_offset;
+    size_type m_carry_size;
+  };
+}
@@ -0,0 +1,105 @@
+/*
+ *  Base64_simd.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "Base64_simd.h"
+
+#if defined(BASE64_HAS_SSSE3)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+/*
+ * The kernels follow Wojciech Mula's and Alfred Klomp's published SSSE3 Base64 methods.
+ */
+
+#define BASE64_SSSE3_TARGET __attribute__((target("ssse3")))
+
+namespace util {
+  namespace base64_ssse3 {
+    bool is_supported() {
+      static bool checked = false;
+      static bool supported = false;
+      if (!checked) {
+        unsigned int eax, ebx, ecx, edx;
+        supported = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSSE3);
+        checked = true;
+      }
+      return supported;
+    }
+
+    BASE64_SSSE3_TARGET
+    uint32 encode(const uint8* in, uint32 in_size, char* out) {
+      // Spread each 3 byte group over 4 bytes, then isolate the four 6 bit values
+      const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+      // Offsets from the 6 bit values to their characters, by range
+      const __m128i offsets = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+
+      uint32 consumed = 0;
+      while (in_size - consumed >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + consumed));
+        v = _mm_shuffle_epi8(v, shuffle);
+
+        const __m128i t0 = _mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00));
+        const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        const __m128i t2 = _mm_and_si128(v, _mm_set1_epi32(0x003f03f0));
+        const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        v = _mm_or_si128(t1, t3);
+
+        __m128i range = _mm_subs_epu8(v, _mm_set1_epi8(51));
+        range = _mm_sub_epi8(range, _mm_cmpgt_epi8(v, _mm_set1_epi8(25)));
+        v = _mm_add_epi8(v, _mm_shuffle_epi8(offsets, range));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+        out += 16;
+        consumed += 12;
+      }
+      return consumed;
+    }
+
+    BASE64_SSSE3_TARGET
+    uint32 decode(const char* in, uint32 in_size, uint8* out) {
+      // Character class by low and high nibble; a non zero AND flags a character outside the alphabet
+      const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                           0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+      const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+      // Offsets from the characters to their 6 bit values, by high nibble ('/' apart)
+      const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+      const __m128i mask_2f = _mm_set1_epi8(0x2f);
+      const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+      const __m128i zero = _mm_setzero_si128();
+
+      uint32 consumed = 0;
+      while (in_size - consumed >= 24) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + consumed));
+
+        const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(v, 4), mask_2f);
+        const __m128i lo_nibbles = _mm_and_si128(v, mask_2f);
+        const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+        const __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), zero)) != 0xffff)
+          break;
+
+        const __m128i eq_2f = _mm_cmpeq_epi8(v, mask_2f);
+        v = _mm_add_epi8(v, _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles)));
+
+        // Pack the four 6 bit values of each group into 3 bytes
+        v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+        v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+        v = _mm_shuffle_epi8(v, pack);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+        out += 12;
+        consumed += 16;
+      }
+      return consumed;
+    }
+  }
+}
+
+#endif
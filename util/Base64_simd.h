@@ -0,0 +1,45 @@
+/*
+ *  Base64_simd.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "base.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#  define BASE64_HAS_SSSE3 1
+#endif
+
+#if defined(BASE64_HAS_SSSE3)
+namespace util {
+  /**
+   * SSSE3 Base64 kernels for x86-64 host builds, used by the bulk paths of
+   * Base64Encoder and Base64Decoder. They only handle whole groups and
+   * leave the rest to the portable code.
+   */
+  namespace base64_ssse3 {
+    /**
+     * @return true if the processor has SSSE3. Checked once.
+     */
+    bool is_supported();
+
+    /**
+     * Encodes 12 bytes into 16 characters at a time, while at least 16 bytes are readable
+     * @return the number of bytes consumed, a multiple of 12. 4/3 as many characters are written.
+     */
+    uint32 encode(const uint8* in, uint32 in_size, char* out);
+
+    /**
+     * Decodes 16 characters into 12 bytes at a time, while at least 24 characters are
+     * readable, stopping before the first block holding a character outside the alphabet
+     * @return the number of characters consumed, a multiple of 16. 3/4 as many bytes are
+     *         written, but the 4 bytes after them may be overwritten.
+     */
+    uint32 decode(const char* in, uint32 in_size, uint8* out);
+  }
+}
+#endif
@@ -0,0 +1,70 @@
+/*
+ *  Biquad.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "Biquad.h"
+
+namespace util {
+  namespace {
+    /**
+     * sin and cos of an angle in [0, PI/2], by their Taylor series
+     */
+    void sine_cosine(float x, float& sin_x, float& cos_x) {
+      const float x2 = x * x;
+      sin_x = x * (1 - x2 / 6 * (1 - x2 / 20 * (1 - x2 / 42 * (1 - x2 / 72 * (1 - x2 / 110)))));
+      cos_x = 1 - x2 / 2 * (1 - x2 / 12 * (1 - x2 / 30 * (1 - x2 / 56 * (1 - x2 / 90 * (1 - x2 / 132)))));
+    }
+
+    /**
+     * Shared terms of w0 = 2*PI*frequency/sample_rate, through the half angle so that
+     * 1 - cos(w0) and 1 + cos(w0) keep their precision at low frequencies
+     */
+    struct Prewarp {
+      Prewarp(float sample_rate, float frequency, float q) {
+        const float PI = 3.14159265f;
+        float sin_half, cos_half;
+        sine_cosine(PI * frequency / sample_rate, sin_half, cos_half);
+        one_minus_cos = 2 * sin_half * sin_half;
+        one_plus_cos = 2 * cos_half * cos_half;
+        cos_w0 = 1 - one_minus_cos;
+        alpha = sin_half * cos_half / q;  // sin(w0) / 2q
+      }
+
+      float cos_w0;
+      float one_minus_cos;
+      float one_plus_cos;
+      float alpha;
+    };
+
+    BiquadCoefficients normalize(float b0, float b1, float b2, float a0, float a1, float a2) {
+      BiquadCoefficients c;
+      c.b0 = b0 / a0;
+      c.b1 = b1 / a0;
+      c.b2 = b2 / a0;
+      c.a1 = a1 / a0;
+      c.a2 = a2 / a0;
+      return c;
+    }
+  }
+
+  BiquadCoefficients BiquadDesign::lowpass(float sample_rate, float frequency, float q) {
+    const Prewarp p(sample_rate, frequency, q);
+    const float b1 = p.one_minus_cos;
+    return normalize(b1 / 2, b1, b1 / 2, 1 + p.alpha, -2 * p.cos_w0, 1 - p.alpha);
+  }
+
+  BiquadCoefficients BiquadDesign::highpass(float sample_rate, float frequency, float q) {
+    const Prewarp p(sample_rate, frequency, q);
+    const float b1 = p.one_plus_cos;
+    return normalize(b1 / 2, -b1, b1 / 2, 1 + p.alpha, -2 * p.cos_w0, 1 - p.alpha);
+  }
+
+  BiquadCoefficients BiquadDesign::notch(float sample_rate, float frequency, float q) {
+    const Prewarp p(sample_rate, frequency, q);
+    return normalize(1, -2 * p.cos_w0, 1, 1 + p.alpha, -2 * p.cos_w0, 1 - p.alpha);
+  }
+}
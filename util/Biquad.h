@@ -0,0 +1,174 @@
+/*
+ *  Biquad.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "base.h"
+#include "Q.h"
+
+namespace util {
+  /**
+   * Normalized second order section coefficients, for
+   * H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+   */
+  struct BiquadCoefficients {
+    float b0, b1, b2;
+    float a1, a2;
+  };
+
+  /**
+   * Second order section designs, after R. Bristow-Johnson's audio EQ cookbook.
+   * They only depend on their arguments, so filters with constant parameters are
+   * best designed once, when the filter is constructed.
+   */
+  class BiquadDesign: NoInstance {
+  public:
+    /**
+     * @param sample_rate in Hz
+     * @param frequency the cutoff or notch frequency in Hz, below sample_rate / 2
+     * @param q the quality factor, 0.7071 for a Butterworth response. For higher order
+     *          Butterworth cascades, the sections take 1 / (2 cos(PI (2k + 1) / 2n)).
+     */
+    static BiquadCoefficients lowpass(float sample_rate, float frequency, float q);
+    static BiquadCoefficients highpass(float sample_rate, float frequency, float q);
+
+    /**
+     * The zeros are on the unit circle, but float rounding may put them a few mHz
+     * off the frequency: at 50Hz for 8kHz, q = 10, the depth there is about -65dB.
+     * @param q the centre frequency over the rejected bandwidth
+     */
+    static BiquadCoefficients notch(float sample_rate, float frequency, float q);
+  };
+
+  namespace biquad_detail {
+    /**
+     * Direct form II transposed section
+     */
+    template <typename T>
+    struct Section {
+      T b0, b1, b2, a1, a2;
+      T s1, s2;
+
+      void set(const BiquadCoefficients& c) {
+        b0 = T(c.b0);
+        b1 = T(c.b1);
+        b2 = T(c.b2);
+        a1 = T(c.a1);
+        a2 = T(c.a2);
+      }
+
+      void reset() {
+        s1 = T(0);
+        s2 = T(0);
+      }
+
+      T process(const T& x) {
+        const T y = b0 * x + s1;
+        s1 = b1 * x - a1 * y + s2;
+        s2 = b2 * x - a2 * y;
+        return y;
+      }
+    };
+
+    /**
+     * Fixed point section. The state keeps the full products, 2F fractional bits
+     * in 64 bits, so that only the output is rounded. The output saturates.
+     */
+    template <uint32 F>
+    struct Section<Q<F, int32> > {
+      typedef Q<F, int32> Qn;
+
+      int32 b0, b1, b2, a1, a2;
+      int64 s1, s2;
+
+      void set(const BiquadCoefficients& c) {
+        b0 = Qn(c.b0).get_raw();
+        b1 = Qn(c.b1).get_raw();
+        b2 = Qn(c.b2).get_raw();
+        a1 = Qn(c.a1).get_raw();
+        a2 = Qn(c.a2).get_raw();
+      }
+
+      void reset() {
+        s1 = 0;
+        s2 = 0;
+      }
+
+      Qn process(const Qn& x_q) {
+        const int64 x = x_q.get_raw();
+        int64 acc = (b0 * x + s1 + (1 << (F - 1))) >> F;
+        if (acc > 0x7fffffffLL)
+          acc = 0x7fffffffLL;
+        else if (acc < -0x80000000LL)
+          acc = -0x80000000LL;
+        const int64 y = acc;
+        s1 = b1 * x - a1 * y + s2;
+        s2 = b2 * x - a2 * y;
+        return Qn::from_raw(static_cast<int32>(y));
+      }
+    };
+  }
+
+  /**
+   * A cascade of NB_SECTIONS biquad sections, in float or util::Q<N>.
+   * Each section costs 5 multiplications per sample, whatever its selectivity.
+   * With util::Q<N>, N must leave 2 integral bits for the coefficients (N <= 29).
+   */
+  template <typename T, uint32 NB_SECTIONS>
+  class BiquadCascade: NoCopy {
+  public:
+    typedef BiquadCascade<T, NB_SECTIONS> this_type;
+    typedef T value_type;
+
+    BiquadCascade() {
+      // Pass through until set up
+      BiquadCoefficients identity = {1, 0, 0, 0, 0};
+      for (uint32 i = 0; i < NB_SECTIONS; ++i)
+        m_sections[i].set(identity);
+      reset();
+    }
+
+    /**
+     * Sets up a section. Its state is left unchanged.
+     */
+    this_type& set_section(uint32 section, const BiquadCoefficients& coefficients) {
+      m_sections[section].set(coefficients);
+      return *this;
+    }
+
+    void reset() {
+      for (uint32 i = 0; i < NB_SECTIONS; ++i)
+        m_sections[i].reset();
+    }
+
+    /**
+     * Filters a value
+     */
+    T process(const T& v) {
+      T y = v;
+      for (uint32 i = 0; i < NB_SECTIONS; ++i)
+        y = m_sections[i].process(y);
+      return y;
+    }
+
+    /**
+     * Filters a block of n values, one section at a time. in and out may be the same.
+     */
+    void process(const T* in, T* out, uint32 n) {
+      for (uint32 i = 0; i < NB_SECTIONS; ++i) {
+        biquad_detail::Section<T>& section = m_sections[i];
+        for (uint32 j = 0; j < n; ++j)
+          out[j] = section.process(in[j]);
+        in = out;
+      }
+    }
+
+  private:
+    biquad_detail::Section<T> m_sections[NB_SECTIONS];
+  };
+}
@@ -8,50 +8,205 @@
  */
 #pragma once
 #include "base.h"
+#include "Endian.h"
 
-#define CRC32_NO_TABLE
+/*
+ * The default engine behind util::CRC32 may be chosen at build time:
+ * - CRC32_NO_TABLE: bit by bit, no table at all
+ * - CRC32_SMALL_TABLE: byte by byte, 1KB table of its own. crc32_shift(), behind
+ *   append_zeros() and crc32_combine(), still links the slicing tables.
+ * - otherwise slicing-by-8, 8KB table (shared with the other slicing engines)
+ * On x86-64 Linux host builds, the default also uses carry-less multiplication
+ * when the processor has it. This needs the wx types, where uint32 is 32 bits
+ * wide: the embedded uint32 is unsigned long, 64 bits on these hosts.
+ */
+
+#if defined(__x86_64__) && defined(__linux__) && !defined(USE_EMBEDDED)
+#  define CRC32_HAS_CLMUL 1
+#endif
 
 namespace util {
-  class CRC32 {
+
+  namespace crc32_detail {
+    /**
+     * Reflected IEEE 802.3 polynomial
+     */
+    static const uint32 POLYNOMIAL = 0xedb88320;
+
+    /**
+     * One bit step of the crc register, applied BITS times
+     */
+    template <uint32 V, uint32 BITS = 8>
+    struct bit_step {
+      static const uint32 value = bit_step<(V & 1) ? ((V >> 1) ^ POLYNOMIAL) : (V >> 1), BITS - 1>::value;
+    };
+
+    template <uint32 V>
+    struct bit_step<V, 0> {
+      static const uint32 value = V;
+    };
+
+    /**
+     * Entry I of the slicing table K, that is the crc register for byte I followed by K zero bytes.
+     * Table 0 is the classic byte-wise table.
+     */
+    template <uint32 I, uint32 K>
+    struct slice_entry {
+      static const uint32 previous = slice_entry<I, K - 1>::value;
+      static const uint32 value = (previous >> 8) ^ slice_entry<previous & 0xff, 0>::value;
+    };
+
+    template <uint32 I>
+    struct slice_entry<I, 0> {
+      static const uint32 value = bit_step<I>::value;
+    };
+
+    /**
+     * The slicing tables, computed at compile time.
+     * The slicing engines all share them, so only one copy ever lands in flash.
+     */
+    extern const uint32 slice_table[8][256];
+
+    /**
+     * The byte-wise table, a copy of slice table 0 in its own source file,
+     * so that the byte engine alone links 1KB instead of 8KB
+     */
+    extern const uint32 byte_table[256];
+
+    /**
+     * @return true if the pointer is aligned for 32 bit accesses
+     */
+    inline
+    bool is_word_aligned(const uint8* p) {
+      return (reinterpret_cast<unsigned long>(p) & 3) == 0;
+    }
+
+    /**
+     * Byte-wise update with a byte-wise table, also used by the slicing engines
+     * for unaligned heads and tails
+     */
+    inline
+    uint32 update_bytes(const uint32* table, uint32 crc, const uint8* data, uint32 data_size) {
+      while (data_size--) {
+        crc = (crc >> 8) ^ table[(crc ^ *data++) & 0xff];
+      }
+      return crc;
+    }
+  }
+
+  /**
+   * Bit by bit engine, smallest and slowest
+   */
+  class CRC32_Bitwise: NoInstance {
+  public:
+    static uint32 update(uint32 crc, const uint8* data, uint32 data_size) {
+      while (data_size--) {
+        crc ^= *data++;
+        for (uint32 j = 0; j < 8; j++) {
+          if (crc & 0x1)
+            crc = (crc >> 1) ^ crc32_detail::POLYNOMIAL;
+          else
+            crc >>= 1;
+        }
+      }
+      return crc;
+    }
+  };
+
+  /**
+   * Byte by byte engine, with a single 256 entries table
+   */
+  class CRC32_Table256: NoInstance {
+  public:
+    static uint32 update(uint32 crc, const uint8* data, uint32 data_size) {
+      return crc32_detail::update_bytes(crc32_detail::byte_table, crc, data, data_size);
+    }
+  };
+
+  /**
+   * Slicing-by-4 engine: aligned spans are processed one word at a time
+   */
+  class CRC32_Slice4: NoInstance {
+  public:
+    static uint32 update(uint32 crc, const uint8* data, uint32 data_size);
+  };
+
+  /**
+   * Slicing-by-8 engine: aligned spans are processed two words at a time
+   */
+  class CRC32_Slice8: NoInstance {
+  public:
+    static uint32 update(uint32 crc, const uint8* data, uint32 data_size);
+  };
+
+#if defined(CRC32_HAS_CLMUL)
+  /**
+   * Host engine folding 64 bytes at a time with PCLMULQDQ.
+   * The processor support is checked once, at run time; short spans and
+   * processors without the instruction go through slicing-by-8.
+   */
+  class CRC32_Clmul: NoInstance {
+  public:
+    static uint32 update(uint32 crc, const uint8* data, uint32 data_size);
+
+    /**
+     * @return true if the processor has PCLMULQDQ and SSE4.1
+     */
+    static bool is_supported();
+  };
+#endif
+
+  /**
+   * Advances a raw crc register over a run of zero bytes, in O(log(zero_count)).
+   * @return the register as if zero_count zero bytes had been processed
+   */
+  uint32 crc32_shift(uint32 crc, uint32 zero_count);
+
+  /**
+   * Merges the checksums of two consecutive fragments A and B, which
+   * may then be calculated independently.
+   * @param crc_a the crc of fragment A
+   * @param crc_b the crc of fragment B
+   * @param size_b the size of fragment B in bytes
+   * @return the crc of A followed by B
+   */
+  inline
+  uint32 crc32_combine(uint32 crc_a, uint32 crc_b, uint32 size_b) {
+    return crc32_shift(crc_a, size_b) ^ crc_b;
+  }
+
+  /**
+   * A CRC32 (IEEE 802.3) calculator, templated on its engine.
+   * The engine only ever sees the raw crc register.
+   */
+  template <class E>
+  class BasicCRC32 {
   public:
+    typedef E engine_type;
     typedef uint32 size_type;
     typedef uint8 value_type;
-    
+
     typedef uint32 result_type;
-    
-    CRC32() {
+
+    BasicCRC32() {
       reset();
     }
-    
-#if defined(CRC32_NO_TABLE)
-    CRC32& process(const value_type * data, size_type data_size)
-    {
-      while (data_size--) 
-      {
-        m_temp = (uint32)((m_crc & 0xff) ^ *data++);
-        for (uint32 j = 0; j < 8; j++) 
-        {
-          if (m_temp & 0x1)
-            m_temp = (m_temp >> 1) ^ 0xedb88320;
-          else
-            m_temp >>= 1;
-        }
-        m_crc = (m_crc >> 8) ^ m_temp;
-      }
+
+    /**
+     * Process an additional block of data
+     */
+    BasicCRC32& process(const value_type * data, size_type data_size) {
+      m_crc = engine_type::update(m_crc, data, data_size);
       return *this;
     }
-    
-#else
+
     /**
-     * Process an additional block of data
+     * Process zero_count zero bytes, without touching any memory
      */
-    CRC32& process(const value_type * data, size_type data_size) {
-      for (uint32 i = 0; i < data_size; ++i) {
-        m_crc = (m_crc >> 8) ^ m_lut[(m_crc & 0xff) ^ data[i]];
-      }
+    BasicCRC32& append_zeros(size_type zero_count) {
+      m_crc = crc32_shift(m_crc, zero_count);
       return *this;
     }
-#endif
 
     /**
      * @return the result for the hash
@@ -59,25 +214,26 @@ namespace util {
     result_type get_result() {
       return ~m_crc;
     }
-    
+
     /**
      * Resets the state of the crc calculator
      */
     void reset()
     {
-#if defined(CRC32_NO_TABLE)
-      m_temp = 0;
-#endif
       m_crc = 0xffffffff;
     }
-    
+
   private:
     result_type m_crc;
-    
+  };
+
 #if defined(CRC32_NO_TABLE)
-    uint32 m_temp;
+  typedef BasicCRC32<CRC32_Bitwise> CRC32;
+#elif defined(CRC32_SMALL_TABLE)
+  typedef BasicCRC32<CRC32_Table256> CRC32;
+#elif defined(CRC32_HAS_CLMUL)
+  typedef BasicCRC32<CRC32_Clmul> CRC32;
 #else
-    static const uint32 m_lut[256];
+  typedef BasicCRC32<CRC32_Slice8> CRC32;
 #endif
-  };
 }
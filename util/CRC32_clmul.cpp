@@ -0,0 +1,153 @@
+/*
+ *  CRC32_clmul.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "CRC32.h"
+
+#if defined(CRC32_HAS_CLMUL)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+/*
+ * Folding as described in Intel's "Fast CRC Computation for Generic Polynomials
+ * Using PCLMULQDQ Instruction", with the constants for the reflected IEEE polynomial.
+ * Only the folding function is built for PCLMULQDQ, the rest of this file
+ * stays runnable on any x86-64.
+ */
+
+namespace util {
+  namespace {
+    // x^(4*128+32) mod P, x^(4*128-32) mod P
+    const uint64 K1K2[2] ZOROBO_ALIGNED(16) = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+    // x^(128+32) mod P, x^(128-32) mod P
+    const uint64 K3K4[2] ZOROBO_ALIGNED(16) = { 0x01751997d0ULL, 0x00ccaa009eULL };
+    // x^64 mod P
+    const uint64 K5K0[2] ZOROBO_ALIGNED(16) = { 0x0163cd6124ULL, 0x0000000000ULL };
+    // P and the Barrett constant mu
+    const uint64 POLY_MU[2] ZOROBO_ALIGNED(16) = { 0x01db710641ULL, 0x01f7011641ULL };
+
+    /**
+     * Folds data_size bytes into the crc register.
+     * data_size must be at least 64 and a multiple of 16.
+     */
+    __attribute__((target("pclmul,sse4.1")))
+    uint32 fold(uint32 crc, const uint8* data, uint32 data_size) {
+      __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+      x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+      x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+      x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+      x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+
+      x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+
+      x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(K1K2));
+
+      data += 64;
+      data_size -= 64;
+
+      // Fold 4 lanes of 128 bits in parallel
+      while (data_size >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+        y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+        y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+        y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+        data += 64;
+        data_size -= 64;
+      }
+
+      // Fold the 4 lanes into one
+      x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(K3K4));
+
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+      // Single lane for the remaining 16 byte blocks
+      while (data_size >= 16) {
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        data += 16;
+        data_size -= 16;
+      }
+
+      // 128 bits down to 64
+      x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+      x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+      x1 = _mm_srli_si128(x1, 8);
+      x1 = _mm_xor_si128(x1, x2);
+
+      x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(K5K0));
+
+      x2 = _mm_srli_si128(x1, 4);
+      x1 = _mm_and_si128(x1, x3);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x1 = _mm_xor_si128(x1, x2);
+
+      // Barrett reduction down to 32 bits
+      x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(POLY_MU));
+
+      x2 = _mm_and_si128(x1, x3);
+      x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+      x2 = _mm_and_si128(x2, x3);
+      x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+      x1 = _mm_xor_si128(x1, x2);
+
+      return _mm_extract_epi32(x1, 1);
+    }
+  }
+
+  bool CRC32_Clmul::is_supported() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+      return false;
+    return (ecx & bit_PCLMUL) && (ecx & bit_SSE4_1);
+  }
+
+  uint32 CRC32_Clmul::update(uint32 crc, const uint8* data, uint32 data_size) {
+    static const bool supported = is_supported();
+
+    if (supported && data_size >= 64) {
+      const uint32 folded_size = data_size & ~15;
+      crc = fold(crc, data, folded_size);
+      data += folded_size;
+      data_size -= folded_size;
+    }
+    return CRC32_Slice8::update(crc, data, data_size);
+  }
+}
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ *  CRC32_table256.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "CRC32.h"
+
+namespace util {
+  namespace crc32_detail {
+    //
+    // Slicing table 0 again, for CRC32_Table256 to link without the others
+    //
+#define CRC32_E1(I) bit_step<(I)>::value
+#define CRC32_E4(I) CRC32_E1(I), CRC32_E1(I + 1), CRC32_E1(I + 2), CRC32_E1(I + 3)
+#define CRC32_E16(I) CRC32_E4(I), CRC32_E4(I + 4), CRC32_E4(I + 8), CRC32_E4(I + 12)
+#define CRC32_E64(I) CRC32_E16(I), CRC32_E16(I + 16), CRC32_E16(I + 32), CRC32_E16(I + 48)
+
+    const uint32 byte_table[256] = {
+      CRC32_E64(0), CRC32_E64(64), CRC32_E64(128), CRC32_E64(192)
+    };
+
+#undef CRC32_E64
+#undef CRC32_E16
+#undef CRC32_E4
+#undef CRC32_E1
+  }
+}
@@ -0,0 +1,156 @@
+/*
+ *  CTR.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "base.h"
+
+namespace util {
+  /**
+   * Counter mode keystream, templated on a 128 bit block cipher
+   * such as AES256 or AES. The cipher must provide encrypt_ecb(block) and
+   * must already be keyed. As no copy of the cipher is made, its lifetime
+   * must exceed that of this object.
+   *
+   * The counter block is a 96 bit nonce followed by a 32 bit big endian
+   * block counter, as in GCM. Since any block of the keystream can be
+   * reached directly through set_nonce(), separate ranges of a stream may
+   * be processed by separate CTR objects, on separate threads on host builds.
+   * Encryption and decryption are the same operation.
+   */
+  template <class C>
+  class CTR: NoCopy {
+  public:
+    typedef CTR<C> this_type;
+    typedef C cipher_type;
+    typedef uint8 value_type;
+    typedef uint32 size_type;
+
+    enum {
+      BYTE_BLOCK_SIZE = 16,
+      BYTE_NONCE_SIZE = 12
+    };
+
+    /**
+     * Constructor, on an already keyed cipher
+     */
+    explicit CTR(cipher_type& cipher)
+    : m_cipher(cipher), m_keystream_offset(BYTE_BLOCK_SIZE) {
+      for (size_type i = 0; i < BYTE_BLOCK_SIZE; ++i)
+        m_counter[i] = 0;
+    }
+
+    /**
+     * Starts a new stream at the given block of the keystream
+     * @param nonce BYTE_NONCE_SIZE bytes, never to be reused with the same key
+     * @param block_index index of the first keystream block
+     */
+    this_type& set_nonce(const value_type* nonce, uint32 block_index = 0) {
+      for (size_type i = 0; i < BYTE_NONCE_SIZE; ++i)
+        m_counter[i] = nonce[i];
+      set_block_counter(block_index);
+      return *this;
+    }
+
+    /**
+     * Starts a new stream from a complete counter block
+     */
+    this_type& set_counter_block(const value_type* counter_block) {
+      for (size_type i = 0; i < BYTE_BLOCK_SIZE; ++i)
+        m_counter[i] = counter_block[i];
+      m_keystream_offset = BYTE_BLOCK_SIZE;
+      return *this;
+    }
+
+    /**
+     * Writes the next nblocks keystream blocks, and advances the counter.
+     * Any partially used keystream block is dropped.
+     */
+    void keystream(value_type* blocks, size_type nblocks) {
+      while (nblocks--) {
+        next_block(blocks);
+        blocks += BYTE_BLOCK_SIZE;
+      }
+      m_keystream_offset = BYTE_BLOCK_SIZE;
+    }
+
+    /**
+     * Encrypts or decrypts data of any size in place.
+     * Successive calls continue the same stream.
+     */
+    this_type& process(value_type* data, size_type size) {
+      // Finish the current keystream block
+      while (size && m_keystream_offset < BYTE_BLOCK_SIZE) {
+        *data++ ^= m_keystream[m_keystream_offset++];
+        --size;
+      }
+
+      // Whole blocks
+      while (size >= BYTE_BLOCK_SIZE) {
+        next_block(m_keystream);
+        for (size_type i = 0; i < BYTE_BLOCK_SIZE; ++i)
+          data[i] ^= m_keystream[i];
+        data += BYTE_BLOCK_SIZE;
+        size -= BYTE_BLOCK_SIZE;
+      }
+
+      // Start a new block for the tail
+      if (size) {
+        next_block(m_keystream);
+        m_keystream_offset = 0;
+        while (size--)
+          *data++ ^= m_keystream[m_keystream_offset++];
+      }
+      return *this;
+    }
+
+    this_type& encrypt(value_type* data, size_type size) {
+      return process(data, size);
+    }
+
+    this_type& decrypt(value_type* data, size_type size) {
+      return process(data, size);
+    }
+
+    /**
+     * @return the counter block which will be encrypted next
+     */
+    const value_type* get_counter_block() const {
+      return m_counter;
+    }
+
+  private:
+    void set_block_counter(uint32 block_index) {
+      m_counter[12] = block_index >> 24;
+      m_counter[13] = block_index >> 16;
+      m_counter[14] = block_index >> 8;
+      m_counter[15] = block_index;
+      m_keystream_offset = BYTE_BLOCK_SIZE;
+    }
+
+    /**
+     * Encrypts the counter block into block, then increments the counter
+     */
+    void next_block(value_type* block) {
+      for (size_type i = 0; i < BYTE_BLOCK_SIZE; ++i)
+        block[i] = m_counter[i];
+      m_cipher.encrypt_ecb(block);
+
+      // 32 bit big endian increment
+      for (size_type i = BYTE_BLOCK_SIZE; i > BYTE_NONCE_SIZE; --i) {
+        if (++m_counter[i - 1])
+          break;
+      }
+    }
+
+    cipher_type& m_cipher;
+    value_type m_counter[BYTE_BLOCK_SIZE];
+    value_type m_keystream[BYTE_BLOCK_SIZE];
+    size_type m_keystream_offset;
+  };
+}
@@ -0,0 +1,100 @@
+/*
+ *  CipherStream.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "base.h"
+#include "Reader.h"
+#include "Writer.h"
+
+namespace util {
+  /**
+   * A writer which encrypts the data on its way to another writer.
+   * It is templated on a stream cipher mode with encrypt(data, size), like
+   * CTR or GCM, which must be started beforehand. With GCM, the tag is
+   * obtained from the mode once all the data has been written.
+   * A short write from the underlying writer leaves the stream unusable, as
+   * the keystream has already moved on.
+   */
+  template <class M>
+  class CipherWriter: public Writer {
+  public:
+    CipherWriter(M& mode, Writer& writer)
+    : m_mode(mode), m_writer(writer) {
+    }
+
+    ~CipherWriter() {
+    }
+
+    /**
+     * Encrypts and writes bytes, a chunk at a time
+     * @return the number of bytes effectively sent
+     */
+    size_type write(const uint8 *bytes, size_type count) {
+      size_type written = 0;
+      while (written < count) {
+        size_type chunk = count - written;
+        if (chunk > CHUNK_SIZE)
+          chunk = CHUNK_SIZE;
+
+        for (size_type i = 0; i < chunk; ++i)
+          m_chunk[i] = bytes[written + i];
+        m_mode.encrypt(m_chunk, chunk);
+
+        size_type sent = 0;
+        while (sent < chunk) {
+          const size_type w = m_writer.write(m_chunk + sent, chunk - sent);
+          if (w == 0)
+            return written + sent;
+          sent += w;
+        }
+        written += chunk;
+      }
+      return written;
+    }
+
+  private:
+    static const size_type CHUNK_SIZE = 32;
+
+    M& m_mode;
+    Writer& m_writer;
+    uint8 m_chunk[CHUNK_SIZE];
+  };
+
+  /**
+   * A reader which decrypts, in place, the data read from another reader.
+   * It is templated on a stream cipher mode with decrypt(data, size), like
+   * CTR or GCM, which must be started beforehand. With GCM, the tag must be
+   * checked through the mode once all the data has been read, and the data
+   * not trusted before.
+   */
+  template <class M>
+  class CipherReader: public Reader {
+  public:
+    CipherReader(M& mode, Reader& reader)
+    : m_mode(mode), m_reader(reader) {
+    }
+
+    ~CipherReader() {
+    }
+
+    /**
+     * Receives and decrypts bytes
+     * @return the number of bytes effectively received
+     */
+    size_type read(uint8 *bytes, size_type count) {
+      const size_type r = m_reader.read(bytes, count);
+      m_mode.decrypt(bytes, r);
+      return r;
+    }
+
+  private:
+    M& m_mode;
+    Reader& m_reader;
+  };
+}
@@ -10,11 +10,41 @@
 #pragma once
 
 #include "base.h"
+#include "Q.h"
 
 namespace util {
-  
+  namespace fir_detail {
+    /**
+     * Multiply-accumulate of n coefficients and taps
+     */
+    template <typename T>
+    inline T dot(const T* coef, const T* taps, uint32 n) {
+      T temp(0);
+      for (uint32 i = 0 ; i < n; ++i) {
+        temp += coef[i] * taps[i];
+      }
+      return temp;
+    }
+
+    /**
+     * Fixed point version: the products are accumulated at full 64 bit precision and
+     * rounded once, instead of once per product. This is a multiply-accumulate long
+     * (SMLAL) per tap on ARM, and vectorizable on host builds.
+     */
+    template <uint32 F>
+    inline Q<F, int32> dot(const Q<F, int32>* coef, const Q<F, int32>* taps, uint32 n) {
+      int64 temp = 0;
+      for (uint32 i = 0 ; i < n; ++i) {
+        temp += static_cast<int64>(coef[i].get_raw()) * taps[i].get_raw();
+      }
+      return Q<F, int32>::from_raw(static_cast<int32>((temp + (1 << (F - 1))) >> F));
+    }
+  }
+
   /**
-   * Implements a FIR filter with N taps
+   * Implements a FIR filter with N taps.
+   * The delay line is circular and stored twice over, so that the last N values
+   * are always contiguous and nothing is shifted when a value is added.
    */
   template <typename T, uint32 N>
   class FIR {
@@ -27,35 +57,52 @@ namespace util {
     
     void reset() {
       m_primed = false;
-      for (uint32 i = 0 ; i < N; ++i)
+      m_newest = 0;
+      for (uint32 i = 0 ; i < 2 * N; ++i)
         m_taps[i] = T(0);
     }
     
     void add_value(const T& v) {
       if (!m_primed) {
-        for (uint32 i = 0; i < N; ++i) {
+        for (uint32 i = 0; i < 2 * N; ++i) {
           m_taps[i] = v;
         }
         m_primed = true;
       } else {
-        for (uint32 i = N - 1 ; i > 0; --i)
-          m_taps[i] = m_taps[i - 1];
-        m_taps[0] = v;        
+        // The newest value comes first, matching coefficient 0
+        m_newest = (m_newest == 0 ? N : m_newest) - 1;
+        m_taps[m_newest] = v;
+        m_taps[m_newest + N] = v;
       }
     }
     
     T get_filtered_value() const {
-      T temp(0);
-      
-      for (uint32 i = 0 ; i < N; ++i) {
-        temp += m_coef[i] * m_taps[i];
+      return fir_detail::dot(m_coef, m_taps + m_newest, N);
+    }
+
+    /**
+     * Adds a value
+     * @return the filtered value
+     */
+    T process(const T& v) {
+      add_value(v);
+      return get_filtered_value();
+    }
+
+    /**
+     * Filters a block of n values. in and out may be the same.
+     */
+    void process(const T* in, T* out, uint32 n) {
+      for (uint32 i = 0; i < n; ++i) {
+        add_value(in[i]);
+        out[i] = fir_detail::dot(m_coef, m_taps + m_newest, N);
       }
-      return temp;
     }
     
   private:
-    T m_taps[N];
+    T m_taps[2 * N];
     T m_coef[N];
+    uint32 m_newest;
     bool m_primed;
     
     // Ensure N is greater than 1
@@ -9,9 +9,95 @@
 #pragma once
 
 #include "base.h"
+#include "Q.h"
 #include "SineLUT.h"
 
 namespace util {
+  namespace fourier_detail {
+    /**
+     * Sine from the quarter period table, scaled by SineLUT::SCALING
+     * @param a the angle, mapped from [0, SineLUT::SIZE[ to [0, 2*PI[
+     */
+    inline int32 sine(uint32 a) {
+      const uint32 HALF = SineLUT::SIZE / 2;
+      const uint32 QUARTER = SineLUT::SIZE / 4;
+      // Quarters 1 and 3 read the table backwards. Every index is masked into
+      // the table, so the compiler can see none goes past it.
+      const uint32 i = a & (QUARTER - 1);
+      int32 s;
+      if (a & QUARTER) {
+        // The table stops just short of PI/2
+        s = i == 0 ? SineLUT::SCALING - 1 : SineLUT::sine_table_1024[(QUARTER - i) & (QUARTER - 1)];
+      } else {
+        s = SineLUT::sine_table_1024[i];
+      }
+      return (a & HALF) ? -s : s;
+    }
+
+    inline int32 cosine(uint32 a) {
+      return sine(a + SineLUT::SIZE / 4);
+    }
+
+    /**
+     * Compile time log2 of a power of 2
+     */
+    template <uint32 N> struct log2 {
+      static const uint32 value = 1 + log2<N / 2>::value;
+    };
+    template <> struct log2<1> {
+      static const uint32 value = 0;
+    };
+  }
+
+  /**
+   * Arithmetic of the transforms for a sample type.
+   * Floating point transforms are not scaled.
+   */
+  template <typename T>
+  struct fourier_traits {
+    /**
+     * @return a twiddle factor from its table value
+     */
+    static T twiddle(int32 lut_value) {
+      return static_cast<T>(lut_value) / SineLUT::SCALING;
+    }
+
+    /**
+     * Applied to both butterfly inputs at each stage
+     */
+    static T stage(const T& v) {
+      return v;
+    }
+
+    static T half(const T& v) {
+      return v / 2;
+    }
+  };
+
+  /**
+   * Fixed point transforms halve the data at each stage so that they cannot overflow:
+   * an N point transform yields the spectrum divided by N.
+   */
+  template <uint32 N, typename U>
+  struct fourier_traits<Q<N, U> > {
+    typedef Q<N, U> Qn;
+
+    static Qn twiddle(int32 lut_value) {
+      // Integer only, without overflowing the intermediate value
+      if (N >= 15)
+        return (Qn::one >> 15) * lut_value;
+      return Qn(lut_value) >> 15;
+    }
+
+    static Qn stage(const Qn& v) {
+      return v >> 1;
+    }
+
+    static Qn half(const Qn& v) {
+      return v >> 1;
+    }
+  };
+
   /**
    * Fourier transforms
    */
@@ -21,6 +107,7 @@ namespace util {
     /**
      * Performs a DFT on a real input vector to a real and imaginary output vector.
      * The vectors must be preallocated.
+     * This is the O(N^2) reference; FFT and RealFFT are the ones to use.
      * @param x input vector
      * @param y output vector
      * @param N vector size
@@ -31,28 +118,216 @@ namespace util {
       for (uint32 k = 0; k < N; ++ k) {
         T t_re = T(0);
         T t_im = T(0);
+        uint32 phase = 0;  // k * n mod N
         for (uint32 n = 0; n < N; ++n) {
-          twiddle(k, N, t_cos, t_sin);
+          twiddle(phase, N, t_cos, t_sin);
           t_re += x[n] * t_cos;
           t_im += x[n] * t_sin;
-        } 
+          phase += k;
+          if (phase >= N)
+            phase -= N;
+        }
         re[k] = t_re;
         im[k] = t_im;
       }
     }
-    
+
   private:
     /**
-     * Calculates e^(-kj/n)
-     * @return the sin and cos twiddle factors
+     * Calculates e^(-2*PI*j*k/n)
+     * @return the cos and sin twiddle factors
      */
-// TODO: FIXME: #warning Check the 2*PI factor in the twiddle
     static void twiddle(uint32 k, uint32 n, T& re, T& im) {
       // Compute the index to look for in the sine lookup table.
       const uint32 sine_index = k * SineLUT::SIZE / n;
-      re = static_cast<T>(SineLUT::get(sine_index)) / SineLUT::SCALING;
-      const uint32 cos_index = SineLUT::SIZE + SineLUT::SIZE / 8 - sine_index;
-      im = static_cast<T>(SineLUT::get(cos_index)) / SineLUT::SCALING;
+      re = fourier_traits<T>::twiddle(fourier_detail::cosine(sine_index));
+      im = fourier_traits<T>::twiddle(-fourier_detail::sine(sine_index));
     }
   };
+
+  /**
+   * In place iterative radix-2 FFT of N complex points, N a power of 2 up to SineLUT::SIZE.
+   * The twiddle factors, derived from SineLUT, and the bit reversal permutation
+   * are tabulated once per sample type and size, on the first construction, and
+   * shared by all instances: an instance only holds a reference to them.
+   * With util::Q samples, the result is divided by N (see fourier_traits).
+   */
+  template <typename T, uint32 N>
+  class FFT: NoCopy {
+  public:
+    typedef T value_type;
+    typedef uint32 size_type;
+
+    static const uint32 SIZE = N;
+    static const uint32 NB_STAGES = fourier_detail::log2<N>::value;
+
+    FFT()
+    : m_tables(tables()) {
+      // N must be a power of 2 that the sine table can resolve
+      typedef char size_must_be_a_power_of_2[(N >= 2 && (N & (N - 1)) == 0 && N <= SineLUT::SIZE) ? 1 : -1] __attribute__((unused));
+    }
+
+    /**
+     * Forward transform, in place
+     * @param re real parts, N values
+     * @param im imaginary parts, N values
+     */
+    void transform(T* re, T* im) const {
+      typedef fourier_traits<T> traits;
+
+      const uint16* reverse = m_tables.reverse;
+      for (uint32 i = 0; i < N; ++i) {
+        const uint32 r = reverse[i];
+        if (r > i) {
+          T t = re[i]; re[i] = re[r]; re[r] = t;
+          t = im[i]; im[i] = im[r]; im[r] = t;
+        }
+      }
+
+      const T* cos = m_tables.cos;
+      const T* sin = m_tables.sin;
+      for (uint32 half = 1, step = N / 2; half < N; half <<= 1, step >>= 1) {
+        for (uint32 k = 0; k < half; ++k) {
+          const T wr = cos[k * step];
+          const T wi = sin[k * step];
+          for (uint32 i = k; i < N; i += 2 * half) {
+            const uint32 j = i + half;
+            const T tr = traits::stage(re[j] * wr - im[j] * wi);
+            const T ti = traits::stage(re[j] * wi + im[j] * wr);
+            const T ur = traits::stage(re[i]);
+            const T ui = traits::stage(im[i]);
+            re[j] = ur - tr;
+            im[j] = ui - ti;
+            re[i] = ur + tr;
+            im[i] = ui + ti;
+          }
+        }
+      }
+    }
+
+  private:
+    struct Tables: NoCopy {
+      T cos[N / 2];
+      T sin[N / 2];  // -sin, the twiddles are e^(-2*PI*j*k/N)
+      uint16 reverse[N];
+
+      Tables() {
+        for (uint32 k = 0; k < N / 2; ++k) {
+          const uint32 a = k * (SineLUT::SIZE / N);
+          cos[k] = fourier_traits<T>::twiddle(fourier_detail::cosine(a));
+          sin[k] = fourier_traits<T>::twiddle(-fourier_detail::sine(a));
+        }
+
+        for (uint32 i = 0; i < N; ++i) {
+          uint32 r = 0;
+          for (uint32 b = 0; b < NB_STAGES; ++b)
+            r |= ((i >> b) & 1) << (NB_STAGES - 1 - b);
+          reverse[i] = r;
+        }
+      }
+    };
+
+    /**
+     * @return the tables of this size, built on the first call
+     */
+    static const Tables& tables() {
+      static const Tables s_tables;
+      return s_tables;
+    }
+
+    const Tables& m_tables;
+  };
+
+  /**
+   * FFT of N real samples, packed as N/2 complex points through an N/2 point FFT.
+   * The spectrum of real samples being symmetric, only bins 0 to N/2 are output.
+   * Like those of FFT, its twiddle factors are shared by the instances of a size.
+   */
+  template <typename T, uint32 N>
+  class RealFFT: NoCopy {
+  public:
+    typedef T value_type;
+    typedef uint32 size_type;
+
+    static const uint32 SIZE = N;
+    static const uint32 NB_BINS = N / 2 + 1;
+
+    RealFFT()
+    : m_tables(tables()) {
+    }
+
+    /**
+     * Forward transform
+     * @param x N real samples
+     * @param re real parts, NB_BINS values
+     * @param im imaginary parts, NB_BINS values
+     */
+    void transform(const T* x, T* re, T* im) const {
+      typedef fourier_traits<T> traits;
+      const uint32 M = N / 2;
+
+      // Even samples as real parts, odd samples as imaginary parts
+      for (uint32 n = 0; n < M; ++n) {
+        re[n] = x[2 * n];
+        im[n] = x[2 * n + 1];
+      }
+      m_fft.transform(re, im);
+      const T* cos = m_tables.cos;
+      const T* sin = m_tables.sin;
+
+      // Separate the even and odd spectra, E[k] = (Z[k] + Z*[M-k]) / 2 and
+      // O[k] = (Z[k] - Z*[M-k]) / 2j, then X[k] = E[k] + e^(-2*PI*j*k/N) O[k].
+      // Fixed point values take one more stage scaling, for a spectrum divided by N.
+      const T z0r = traits::stage(re[0]);
+      const T z0i = traits::stage(im[0]);
+      re[0] = z0r + z0i;
+      im[0] = T(0);
+      re[M] = z0r - z0i;
+      im[M] = T(0);
+
+      for (uint32 k = 1; k <= M / 2; ++k) {
+        const uint32 m = M - k;
+        const T zkr = traits::stage(re[k]);
+        const T zki = traits::stage(im[k]);
+        const T zmr = traits::stage(re[m]);
+        const T zmi = traits::stage(im[m]);
+        const T e_re = traits::half(zkr + zmr);
+        const T e_im = traits::half(zki - zmi);
+        const T o_re = traits::half(zki + zmi);
+        const T o_im = traits::half(zmr - zkr);
+
+        const T t_re = o_re * cos[k] - o_im * sin[k];
+        const T t_im = o_re * sin[k] + o_im * cos[k];
+
+        // E[M-k] and O[M-k] are the conjugates, the twiddle is -conj(e^(-2*PI*j*k/N)).
+        // Both give the same value for k = M/2.
+        re[k] = e_re + t_re;
+        im[k] = e_im + t_im;
+        re[m] = e_re - t_re;
+        im[m] = t_im - e_im;
+      }
+    }
+
+  private:
+    struct Tables: NoCopy {
+      T cos[N / 4 + 1];
+      T sin[N / 4 + 1];
+
+      Tables() {
+        for (uint32 k = 0; k <= N / 4; ++k) {
+          const uint32 a = k * (SineLUT::SIZE / N);
+          cos[k] = fourier_traits<T>::twiddle(fourier_detail::cosine(a));
+          sin[k] = fourier_traits<T>::twiddle(-fourier_detail::sine(a));
+        }
+      }
+    };
+
+    static const Tables& tables() {
+      static const Tables s_tables;
+      return s_tables;
+    }
+
+    FFT<T, N / 2> m_fft;
+    const Tables& m_tables;
+  };
 }
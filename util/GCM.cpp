@@ -0,0 +1,117 @@
+/*
+ *  GCM.cpp
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#include "GCM.h"
+
+namespace util {
+  namespace {
+    /**
+     * Reduction of the 4 bits shifted out of the 128 bit value
+     */
+    const uint16 LAST4[16] = {
+      0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+      0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+    };
+
+    inline
+    uint64 load_be64(const uint8* p) {
+      uint64 v = 0;
+      for (uint32 i = 0; i < 8; ++i)
+        v = (v << 8) | p[i];
+      return v;
+    }
+
+    inline
+    void store_be64(uint8* p, uint64 v) {
+      for (uint32 i = 8; i > 0; --i) {
+        p[i - 1] = static_cast<uint8>(v);
+        v >>= 8;
+      }
+    }
+  }
+
+  void GHash::set_key(const value_type* h) {
+    uint64 vh = load_be64(h);
+    uint64 vl = load_be64(h + 8);
+
+    // Entry 8 is H itself, 4, 2 and 1 are H times x, x^2 and x^3
+    m_hl[8] = vl;
+    m_hh[8] = vh;
+    m_hl[0] = 0;
+    m_hh[0] = 0;
+
+    for (uint32 i = 4; i > 0; i >>= 1) {
+      const uint32 t = (vl & 1) * 0xe1000000;
+      vl = (vh << 63) | (vl >> 1);
+      vh = (vh >> 1) ^ (static_cast<uint64>(t) << 32);
+      m_hl[i] = vl;
+      m_hh[i] = vh;
+    }
+
+    // The other entries are sums of these
+    for (uint32 i = 2; i <= 8; i *= 2) {
+      for (uint32 j = 1; j < i; ++j) {
+        m_hh[i + j] = m_hh[i] ^ m_hh[j];
+        m_hl[i + j] = m_hl[i] ^ m_hl[j];
+      }
+    }
+
+    reset();
+  }
+
+  void GHash::reset() {
+    for (size_type i = 0; i < BYTE_BLOCK_SIZE; ++i)
+      m_y[i] = 0;
+    m_offset = 0;
+  }
+
+  void GHash::process(const value_type* data, size_type size) {
+    while (size--) {
+      m_y[m_offset++] ^= *data++;
+      if (m_offset == BYTE_BLOCK_SIZE) {
+        multiply();
+        m_offset = 0;
+      }
+    }
+  }
+
+  void GHash::pad() {
+    if (m_offset) {
+      multiply();
+      m_offset = 0;
+    }
+  }
+
+  void GHash::multiply() {
+    uint32 lo = m_y[15] & 0xf;
+    uint64 zh = m_hh[lo];
+    uint64 zl = m_hl[lo];
+
+    for (int32 i = 15; i >= 0; --i) {
+      lo = m_y[i] & 0xf;
+      const uint32 hi = m_y[i] >> 4;
+
+      if (i != 15) {
+        const uint32 rem = static_cast<uint32>(zl) & 0xf;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (static_cast<uint64>(LAST4[rem]) << 48);
+        zh ^= m_hh[lo];
+        zl ^= m_hl[lo];
+      }
+
+      const uint32 rem = static_cast<uint32>(zl) & 0xf;
+      zl = (zh << 60) | (zl >> 4);
+      zh = (zh >> 4) ^ (static_cast<uint64>(LAST4[rem]) << 48);
+      zh ^= m_hh[hi];
+      zl ^= m_hl[hi];
+    }
+
+    store_be64(m_y, zh);
+    store_be64(m_y + 8, zl);
+  }
+}
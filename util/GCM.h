@@ -0,0 +1,239 @@
+/*
+ *  GCM.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "base.h"
+#include "CTR.h"
+
+namespace util {
+  /**
+   * GHASH, the universal hash of GCM (NIST SP 800-38D).
+   * Multiplications by H use Shoup's 4 bit tables, 256 bytes per key.
+   */
+  class GHash: NoCopy {
+  public:
+    typedef uint8 value_type;
+    typedef uint32 size_type;
+
+    enum {
+      BYTE_BLOCK_SIZE = 16
+    };
+
+    GHash() {
+    }
+
+    /**
+     * Sets the hash subkey H, 16 bytes
+     */
+    void set_key(const value_type* h);
+
+    /**
+     * Starts a new hash
+     */
+    void reset();
+
+    /**
+     * Hashes more data. When the data is not a multiple of the block size,
+     * the last block is completed by a later call, or zero padded by pad().
+     */
+    void process(const value_type* data, size_type size);
+
+    /**
+     * Zero pads the current partial block, if any
+     */
+    void pad();
+
+    /**
+     * @return the current hash value, 16 bytes. pad() should be called first.
+     */
+    const value_type* get() const {
+      return m_y;
+    }
+
+  private:
+    /**
+     * m_y = m_y * H
+     */
+    void multiply();
+
+    uint64 m_hl[16];
+    uint64 m_hh[16];
+    value_type m_y[BYTE_BLOCK_SIZE];
+    size_type m_offset;
+  };
+
+  /**
+   * Galois/Counter Mode authenticated encryption (NIST SP 800-38D), templated on a
+   * 128 bit block cipher such as AES256 or AES. Data is encrypted and authenticated
+   * in a single traversal.
+   * The cipher must be keyed before construction, or init() called again once it is.
+   *
+   * For each message:
+   * 1. start() with a 96 bit IV, never to be reused with the same key
+   * 2. add_aad() any additional authenticated data
+   * 3. encrypt() or decrypt() the data in place, in as many pieces as needed
+   * 4. get_tag() when encrypting, check_tag() when decrypting
+   *
+   * Received tags may be truncated to no less than BYTE_MIN_TAG_SIZE bytes.
+   * The 4 and 8 byte tags of SP 800-38D appendix C are refused unless
+   * allow_short_tags() was called, as forgeries get much easier with them.
+   */
+  template <class C>
+  class GCM: NoCopy {
+  public:
+    typedef GCM<C> this_type;
+    typedef C cipher_type;
+    typedef uint8 value_type;
+    typedef uint32 size_type;
+
+    enum {
+      BYTE_BLOCK_SIZE = 16,
+      BYTE_IV_SIZE = 12,
+      BYTE_TAG_SIZE = 16,
+      BYTE_MIN_TAG_SIZE = 12
+    };
+
+    explicit GCM(cipher_type& cipher)
+    : m_cipher(cipher), m_ctr(cipher), m_short_tags(false) {
+      init();
+    }
+
+    /**
+     * Lets check_tag() accept 4 and 8 byte tags, for protocols that cannot
+     * afford more and bound the number of forgery attempts
+     */
+    this_type& allow_short_tags(bool allow = true) {
+      m_short_tags = allow;
+      return *this;
+    }
+
+    /**
+     * Derives the hash subkey from the cipher key
+     */
+    this_type& init() {
+      value_type h[BYTE_BLOCK_SIZE];
+      for (size_type i = 0; i < BYTE_BLOCK_SIZE; ++i)
+        h[i] = 0;
+      m_cipher.encrypt_ecb(h);
+      m_ghash.set_key(h);
+      return *this;
+    }
+
+    /**
+     * Starts a new message
+     */
+    this_type& start(const value_type* iv) {
+      // The pre-counter block J0 is the IV followed by a counter of 1.
+      // Its encryption masks the tag, the data starts at counter 2.
+      m_ctr.set_nonce(iv, 1);
+      m_ctr.keystream(m_tag_mask, 1);
+
+      m_ghash.reset();
+      m_aad_size = 0;
+      m_data_size = 0;
+      return *this;
+    }
+
+    /**
+     * Adds additional authenticated data. It must all come before the data.
+     */
+    this_type& add_aad(const value_type* aad, size_type size) {
+      m_ghash.process(aad, size);
+      m_aad_size += size;
+      return *this;
+    }
+
+    /**
+     * Encrypts data in place
+     */
+    this_type& encrypt(value_type* data, size_type size) {
+      start_data();
+      m_ctr.process(data, size);
+      m_ghash.process(data, size);
+      m_data_size += size;
+      return *this;
+    }
+
+    /**
+     * Decrypts data in place. The result must not be trusted before check_tag() succeeds.
+     */
+    this_type& decrypt(value_type* data, size_type size) {
+      start_data();
+      m_ghash.process(data, size);
+      m_ctr.process(data, size);
+      m_data_size += size;
+      return *this;
+    }
+
+    /**
+     * Ends the message and writes its authentication tag, BYTE_TAG_SIZE bytes
+     */
+    void get_tag(value_type* tag) {
+      m_ghash.pad();
+
+      value_type lengths[BYTE_BLOCK_SIZE];
+      put_bit_length(lengths, m_aad_size);
+      put_bit_length(lengths + 8, m_data_size);
+      m_ghash.process(lengths, BYTE_BLOCK_SIZE);
+
+      const value_type* s = m_ghash.get();
+      for (size_type i = 0; i < BYTE_TAG_SIZE; ++i)
+        tag[i] = s[i] ^ m_tag_mask[i];
+    }
+
+    /**
+     * Ends the message and checks it against the received tag, in constant time
+     * @param tag_size may be less than BYTE_TAG_SIZE for a truncated tag, see is_valid_tag_size()
+     * @return true if the message is authentic, false as well if tag_size is not valid
+     */
+    bool check_tag(const value_type* tag, size_type tag_size = BYTE_TAG_SIZE) {
+      value_type expected[BYTE_TAG_SIZE];
+      get_tag(expected);
+      if (!is_valid_tag_size(tag_size))
+        return false;
+
+      value_type diff = 0;
+      for (size_type i = 0; i < tag_size; ++i)
+        diff |= expected[i] ^ tag[i];
+      return diff == 0;
+    }
+
+    /**
+     * @return true if check_tag() accepts tags of this size
+     */
+    bool is_valid_tag_size(size_type tag_size) const {
+      if (tag_size >= BYTE_MIN_TAG_SIZE && tag_size <= BYTE_TAG_SIZE)
+        return true;
+      return m_short_tags && (tag_size == 4 || tag_size == 8);
+    }
+
+  private:
+    /**
+     * The first data byte ends the additional data, which is zero padded
+     */
+    void start_data() {
+      if (m_data_size == 0)
+        m_ghash.pad();
+    }
+
+    static void put_bit_length(value_type* p, size_type byte_size) {
+      const uint64 bits = static_cast<uint64>(byte_size) << 3;
+      for (size_type i = 0; i < 8; ++i)
+        p[i] = static_cast<value_type>(bits >> (56 - 8 * i));
+    }
+
+    cipher_type& m_cipher;
+    CTR<C> m_ctr;
+    GHash m_ghash;
+    value_type m_tag_mask[BYTE_BLOCK_SIZE];
+    size_type m_aad_size;
+    size_type m_data_size;
+    bool m_short_tags;
+  };
+}
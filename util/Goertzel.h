@@ -0,0 +1,117 @@
+/*
+ *  Goertzel.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "base.h"
+#include "Fourier.h"
+
+namespace util {
+  /**
+   * A bank of Goertzel filters, measuring the power at a few frequencies over
+   * successive blocks of samples, at a cost of one multiplication per bin and sample.
+   * Results are latched at the end of each block, so that they can be read while
+   * the next block is being processed, for instance from an ADC interrupt.
+   *
+   * With util::Q samples, the filter states reach block_size times the sample amplitude,
+   * which the integral bits must accommodate.
+   */
+  template <typename T, uint32 NB_BINS>
+  class Goertzel: NoCopy {
+  public:
+    typedef Goertzel<T, NB_BINS> this_type;
+    typedef T value_type;
+
+    /**
+     * @param block_size the number of samples per measurement
+     */
+    explicit Goertzel(uint32 block_size)
+    : m_block_size(block_size) {
+      for (uint32 i = 0; i < NB_BINS; ++i) {
+        m_coeff[i] = T(0);
+        m_power[i] = T(0);
+      }
+      reset();
+    }
+
+    /**
+     * Sets the frequency of a bin. The measurement is exact when the frequency
+     * is a multiple of sample_rate / block_size.
+     */
+    this_type& set_frequency(uint32 bin, uint32 frequency, uint32 sample_rate) {
+      const uint32 a = static_cast<uint32>(static_cast<uint64>(frequency) * SineLUT::SIZE / sample_rate);
+      const T c = fourier_traits<T>::twiddle(fourier_detail::cosine(a));
+      m_coeff[bin] = c + c;
+      return *this;
+    }
+
+    /**
+     * Restarts the current block
+     */
+    void reset() {
+      for (uint32 i = 0; i < NB_BINS; ++i) {
+        m_s1[i] = T(0);
+        m_s2[i] = T(0);
+      }
+      m_count = 0;
+      m_block_count = 0;
+    }
+
+    /**
+     * Processes the next sample
+     */
+    void add_sample(const T& x) {
+      for (uint32 i = 0; i < NB_BINS; ++i) {
+        const T s0 = x + m_coeff[i] * m_s1[i] - m_s2[i];
+        m_s2[i] = m_s1[i];
+        m_s1[i] = s0;
+      }
+
+      if (++m_count == m_block_size) {
+        for (uint32 i = 0; i < NB_BINS; ++i) {
+          // Normalized by the block size first, to keep the squares in range
+          const T s1 = m_s1[i] / static_cast<int32>(m_block_size);
+          const T s2 = m_s2[i] / static_cast<int32>(m_block_size);
+          m_power[i] = s1 * s1 + s2 * s2 - m_coeff[i] * s1 * s2;
+          m_s1[i] = T(0);
+          m_s2[i] = T(0);
+        }
+        m_count = 0;
+        ++m_block_count;
+      }
+    }
+
+    /**
+     * @return the power measured over the last complete block, |X(f)|^2 / block_size^2,
+     *         that is a quarter of the squared amplitude for a sine at f
+     */
+    T get_power(uint32 bin) const {
+      return m_power[bin];
+    }
+
+    /**
+     * @return the number of complete blocks, to tell when new results are available
+     */
+    uint32 get_block_count() const {
+      return m_block_count;
+    }
+
+    uint32 get_block_size() const {
+      return m_block_size;
+    }
+
+  private:
+    const uint32 m_block_size;
+    uint32 m_count;
+    volatile uint32 m_block_count;
+    T m_coeff[NB_BINS];
+    T m_s1[NB_BINS];
+    T m_s2[NB_BINS];
+    T m_power[NB_BINS];
+  };
+}
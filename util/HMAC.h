@@ -14,7 +14,9 @@
 namespace util {
   
   /**
-   * HMAC calculator, templated on a hash function
+   * HMAC calculator, templated on a hash function.
+   * The hash must be able to save and restore its state on a block boundary,
+   * as the padded key blocks are only ever hashed once, in set_key().
    */
   template <class H>
   class HMAC: NoCopy {
@@ -23,6 +25,7 @@ namespace util {
     typedef typename H::size_type size_type;
     typedef typename H::value_type value_type;
     typedef typename H::result_type result_type;
+    typedef typename H::midstate_type midstate_type;
     
     enum {
       BIT_BLOCK_SIZE = H::BIT_BLOCK_SIZE,
@@ -32,14 +35,16 @@ namespace util {
     };
     
     /**
-     * Constructor
+     * Constructor. The key is empty until set_key(), which keeps reset()
+     * and the calculations defined before it is called.
      */
     HMAC() {
+      set_key(0, 0);
     }
     
     /**
      * Sets the key for calculating the hmac.
-     * This must be done for every new hmac calculation
+     * The key then stays in effect for every calculation until the next set_key()
      */
     this_type& set_key(const value_type* key, size_type key_size);
     
@@ -49,15 +54,15 @@ namespace util {
     this_type& process(const value_type * data, size_type data_size);
     
     /**
-     * @return the result for the hmac
+     * @return the result for the hmac. reset() must be called before the next calculation
      */
     result_type get_result();
 
     /**
-     * Forgets any ongoing operation
+     * Forgets any ongoing operation, and starts a new one with the same key
      */
     this_type& reset() {
-      m_h.reset();
+      m_h.set_midstate(m_inner);
       return *this;
     }
     
@@ -65,46 +70,58 @@ namespace util {
     static const uint8 PAD_IN = 0x36;
     static const uint8 PAD_OUT = 0x5c;
     H m_h;
-    value_type m_key[BYTE_BLOCK_SIZE];
+    
+    /**
+     * Hash states after the inner and outer padded key blocks
+     */
+    midstate_type m_inner;
+    midstate_type m_outer;
   };
 
   template <class H>
   typename HMAC<H>::this_type& HMAC<H>::set_key(const value_type* key, size_type key_size) {
+    value_type padded_key[BYTE_BLOCK_SIZE];
+    
     if (key_size > BYTE_BLOCK_SIZE) {
       m_h.reset();
       m_h.process(key, key_size);
-      const result_type result = m_h.get_result();
+      // The key is the digest as bytes, in big-endian
+      result_type result = m_h.get_result();
+      result.to_network_order();
       for (size_type i = 0; i < BYTE_DIGEST_SIZE; ++i) {
-        m_key[i] = result[i];
+        padded_key[i] = result[i];
       }
       key_size = BYTE_DIGEST_SIZE;
-      // Done with hashing the key
-      m_h.reset();
     } else {
       for (size_type i = 0; i < key_size; ++i) {
-        m_key[i] = key[i];
+        padded_key[i] = key[i];
       }
     }
     
     // When the key does not fill a whole block, fill with zeroes
     for (size_type i = key_size; i < BYTE_BLOCK_SIZE; ++i) {
-      m_key[i] = 0;
+      padded_key[i] = 0;
     }
     
-    // Perform inner padding
-    // We convert the key to inner padding
+    // Perform inner padding, and remember the state after it
     for (size_type i = 0; i < BYTE_BLOCK_SIZE; ++i) {
-      m_key[i] ^= PAD_IN;
+      padded_key[i] ^= PAD_IN;
     }
-    m_h.process(m_key, BYTE_BLOCK_SIZE);
+    m_h.reset();
+    m_h.process(padded_key, BYTE_BLOCK_SIZE);
+    m_h.get_midstate(m_inner);
     
-    // Prepare for outer padding, as it will be needed at the end of the message to hash
+    // Same for the outer padding, which will be needed at the end of the message to hash
     for (size_type i = 0; i < BYTE_BLOCK_SIZE; ++i) {
       // Reverse inner padding xor, and do outer padding at the same time
-      m_key[i] ^= PAD_IN ^ PAD_OUT;
+      padded_key[i] ^= PAD_IN ^ PAD_OUT;
     }
+    m_h.reset();
+    m_h.process(padded_key, BYTE_BLOCK_SIZE);
+    m_h.get_midstate(m_outer);
     
-    return *this;
+    // Ready for the message
+    return reset();
   }
   
   template <class H>
@@ -120,11 +137,8 @@ namespace util {
     // Get inner result
     result_type inner_result = m_h.get_result();
     
-    // Reuse the hasher to perform the outer hash
-    m_h.reset();
-    
-    // Do the outer padding
-    m_h.process(m_key, BYTE_BLOCK_SIZE);
+    // Reuse the hasher to perform the outer hash, starting after the outer padding
+    m_h.set_midstate(m_outer);
     
     // Add the inner hash in big-endian
     inner_result.to_network_order();
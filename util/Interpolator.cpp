@@ -9,3 +9,38 @@
 
 #include "Interpolator.h"
 
+#include "Fourier.h"
+
+namespace util {
+  namespace polyphase_detail {
+    /**
+     * sin(PI * t) from the sine table
+     */
+    static float sin_pi(float t) {
+      const int32 a = static_cast<int32>(t * (SineLUT::SIZE / 2) + (t < 0 ? -0.5f : 0.5f));
+      return static_cast<float>(fourier_detail::sine(static_cast<uint32>(a))) / SineLUT::SCALING;
+    }
+
+    void design_lowpass(float* h, uint32 size, uint32 L, uint32 M) {
+      const float PI = 3.14159265f;
+      // Cutoff relative to the oversampled Nyquist frequency
+      const float cutoff = 1.0f / (L > M ? L : M);
+      const float center = (size - 1) * 0.5f;
+
+      float sum = 0;
+      for (uint32 n = 0; n < size; ++n) {
+        const float t = (n - center) * cutoff;
+        const float sinc = (t == 0) ? 1.0f : sin_pi(t) / (PI * t);
+        const float s = sin_pi(n / (float)(size + 1) + 1.0f / (size + 1));
+        const float window = s * s;  // Hann, zero just outside the filter
+        h[n] = sinc * window;
+        sum += h[n];
+      }
+
+      // Unity gain at DC once the zeros are inserted
+      const float gain = L / sum;
+      for (uint32 n = 0; n < size; ++n)
+        h[n] *= gain;
+    }
+  }
+}
@@ -10,15 +10,79 @@
 #pragma once
 
 #include "base.h"
+#include "FIR.h"
 
 namespace util {
-  
+  namespace polyphase_detail {
+    /**
+     * Designs a Hann windowed sinc lowpass filter for resampling by L/M, at the L times
+     * oversampled rate. The cutoff is the lower of the input and output Nyquist
+     * frequencies, and the gain is L to make up for the inserted zeros.
+     * @param h size coefficients, where size should be a multiple of L
+     */
+    void design_lowpass(float* h, uint32 size, uint32 L, uint32 M);
+
+    /**
+     * Coefficient type and multiply-accumulate for a sample type.
+     * Floating point and util::Q samples take coefficients of their own type.
+     */
+    template <typename T>
+    struct traits {
+      typedef T coef_type;
+
+      static coef_type coef(float h) {
+        return coef_type(h);
+      }
+
+      static T dot(const coef_type* coef, const T* taps, uint32 n) {
+        return fir_detail::dot(coef, taps, n);
+      }
+    };
+
+    /**
+     * Integer samples, with Q15 coefficients and 64 bit accumulation,
+     * saturated to the range of the sample type
+     */
+    template <typename T>
+    struct integer_traits {
+      typedef int16 coef_type;
+
+      static coef_type coef(float h) {
+        const int32 c = static_cast<int32>(h * (1 << 15) + (h < 0 ? -0.5f : 0.5f));
+        return static_cast<int16>(c > 0x7fff ? 0x7fff : (c < -0x8000 ? -0x8000 : c));
+      }
+
+      static T dot(const coef_type* coef, const T* taps, uint32 n) {
+        typedef char samples_must_fit_in_32_bits[sizeof(T) <= 4 ? 1 : -1] __attribute__((unused));
+        const bool is_signed = T(-1) < T(0);
+        const int64 max = is_signed ? (int64(1) << (8 * sizeof(T) - 1)) - 1 : (int64(1) << (8 * sizeof(T))) - 1;
+        const int64 min = is_signed ? -max - 1 : 0;
+
+        int64 temp = 0;
+        for (uint32 i = 0; i < n; ++i)
+          temp += static_cast<int64>(coef[i]) * taps[i];
+        temp = (temp + (1 << 14)) >> 15;
+        return static_cast<T>(temp > max ? max : (temp < min ? min : temp));
+      }
+    };
+
+    template <> struct traits<int8>: integer_traits<int8> {};
+    template <> struct traits<uint8>: integer_traits<uint8> {};
+    template <> struct traits<int16>: integer_traits<int16> {};
+    template <> struct traits<uint16>: integer_traits<uint16> {};
+    template <> struct traits<int32>: integer_traits<int32> {};
+    template <> struct traits<uint32>: integer_traits<uint32> {};
+  }
+
+
   /**
    * Interpolator that does nothing at all
    */
   template <typename TYPE_IN>
   class NullInterpolator: NoCopy {
   public:
+    static const uint32 INTERPOLATION_FACTOR = 1;
+    static const uint32 DECIMATION_FACTOR = 1;
     static const uint32 OVERSAMPLING_FACTOR = 1;
     
     /**
@@ -49,6 +113,8 @@ namespace util {
   template <typename TYPE_IN>
   class LinearInterpolator: NoCopy {
   public:
+    static const uint32 INTERPOLATION_FACTOR = 2;
+    static const uint32 DECIMATION_FACTOR = 1;
     static const uint32 OVERSAMPLING_FACTOR = 2;
     
     /**
@@ -92,5 +158,123 @@ namespace util {
   private:
     bool m_interpolate_sample;
     TYPE_IN m_previous;
-  };  
+  };
+
+  /**
+   * Polyphase FIR resampler by the rational ratio L/M, with TAPS_PER_PHASE taps for
+   * each of the L phases. Only the phases actually output are computed, that is
+   * TAPS_PER_PHASE multiplications per output sample.
+   * By default the filter is a windowed sinc lowpass designed on construction.
+   *
+   * interpolate() outputs one sample per call, as the other interpolators do, which
+   * takes L >= M. process() works on blocks for any ratio.
+   */
+  template <typename TYPE_IN, uint32 L, uint32 M, uint32 TAPS_PER_PHASE>
+  class PolyphaseInterpolator: NoCopy {
+  public:
+    static const uint32 INTERPOLATION_FACTOR = L;
+    static const uint32 DECIMATION_FACTOR = M;
+    static const uint32 OVERSAMPLING_FACTOR = L / M;
+    static const uint32 NB_COEFFICIENTS = L * TAPS_PER_PHASE;
+
+    typedef TYPE_IN TYPE_OUT;
+    typedef typename polyphase_detail::traits<TYPE_IN>::coef_type coef_type;
+
+    PolyphaseInterpolator() {
+      float h[NB_COEFFICIENTS];
+      polyphase_detail::design_lowpass(h, NB_COEFFICIENTS, L, M);
+      set_coefficients(h);
+      reset();
+    }
+
+    /**
+     * @param h NB_COEFFICIENTS coefficients of a filter at the L times oversampled rate
+     */
+    explicit PolyphaseInterpolator(const float* h) {
+      set_coefficients(h);
+      reset();
+    }
+
+    void set_coefficients(const float* h) {
+      // Phase p takes coefficients p, p + L, p + 2L...
+      for (uint32 p = 0; p < L; ++p) {
+        for (uint32 k = 0; k < TAPS_PER_PHASE; ++k)
+          m_coef[p][k] = polyphase_detail::traits<TYPE_IN>::coef(h[k * L + p]);
+      }
+    }
+
+    /**
+     * Revert to an inital state
+     */
+    void reset() {
+      for (uint32 i = 0; i < 2 * TAPS_PER_PHASE; ++i)
+        m_taps[i] = TYPE_IN(0);
+      m_newest = 0;
+      m_phase = 0;
+      m_needed = 1;
+    }
+
+    /**
+     * Perform the interpolation
+     * @return true if the sample in was consumed
+     */
+    bool interpolate(const TYPE_IN& sample_in, TYPE_OUT& sample_out) {
+      // A call per output only consumes up to one input
+      typedef char interpolate_needs_l_not_less_than_m[L >= M ? 1 : -1] __attribute__((unused));
+
+      const bool consumed = m_needed != 0;
+      if (consumed) {
+        push(sample_in);
+        m_needed = 0;
+      }
+      sample_out = next_output();
+      return consumed;
+    }
+
+    /**
+     * Resamples a block
+     * @param in input samples
+     * @param size the number of input samples, all consumed
+     * @param out output samples, room for size * L / M + 1 of them
+     * @return the number of output samples
+     */
+    uint32 process(const TYPE_IN* in, uint32 size, TYPE_OUT* out) {
+      uint32 nb_out = 0;
+      for (;;) {
+        while (m_needed) {
+          if (size == 0)
+            return nb_out;
+          push(*in++);
+          --size;
+          --m_needed;
+        }
+        out[nb_out++] = next_output();
+      }
+    }
+
+  private:
+    void push(const TYPE_IN& sample) {
+      // Doubled circular delay line, newest first as in FIR
+      m_newest = (m_newest == 0 ? TAPS_PER_PHASE : m_newest) - 1;
+      m_taps[m_newest] = sample;
+      m_taps[m_newest + TAPS_PER_PHASE] = sample;
+    }
+
+    TYPE_OUT next_output() {
+      const TYPE_OUT out = polyphase_detail::traits<TYPE_IN>::dot(m_coef[m_phase], m_taps + m_newest, TAPS_PER_PHASE);
+      // Advance by M at the oversampled rate, the inputs passed are needed next
+      m_phase += M;
+      while (m_phase >= L) {
+        m_phase -= L;
+        ++m_needed;
+      }
+      return out;
+    }
+
+    coef_type m_coef[L][TAPS_PER_PHASE];
+    TYPE_IN m_taps[2 * TAPS_PER_PHASE];
+    uint32 m_newest;
+    uint32 m_phase;
+    uint32 m_needed;
+  };
 }
@@ -14,6 +14,8 @@
 namespace la {
   /**
    * A generic (read not hand-optimized) kalman filter.
+   * The steps are written with matrix expressions, evaluated in place
+   * into the members, so that the task stack only holds measurement sized matrices.
    * It is parameterized by a struct with the following definitions:
    * - state_size n
    * - meas_size m
@@ -25,6 +27,8 @@ namespace la {
    * - Q: process noise covariance, n x n
    * - R: measurement noise covariance, m x m
    * - P: state covariance, n x n
+   * K starts at zero. Should H * P^ * H_T + R not be invertible, K keeps its
+   * previous value rather than being computed from it.
    */
   template <class Traits>
   class Kalman {
@@ -59,9 +63,11 @@ namespace la {
 
     state_type X_predicted;
     prob_type P_predicted;
+    kalman_gain_type PHt;
     kalman_gain_type K; 
     
     Kalman() {
+      la::set_zero(K);
       reset();
     }
   
@@ -70,45 +76,94 @@ namespace la {
       
       // Identity
       set_identity(I);
+      m_steady_state = false;
+    }
+
+    /**
+     * For a time invariant filter (constant A, H, Q and R): iterates the covariance
+     * and gain updates from the current P until K converges, then keeps K.
+     * The steps then only update the state, until set_dynamic() or reset().
+     * @param tolerance the largest change of any gain term between two iterations;
+     * with slow modes, the gain is still some tens of times that away from its limit
+     * @return true if converged within max_iterations, the filter staying dynamic otherwise
+     */
+    bool set_steady_state(uint32 max_iterations = 10000, k_real_type tolerance = numeric_traits<k_real_type>::epsilon()) {
+      kalman_gain_type previous_K;
+      for (uint32 n = 0; n < max_iterations; ++n) {
+        previous_K = K;
+        predict_covariance();
+        update_covariance();
+        if (n > 0 && is_within(K, previous_K, tolerance)) {
+          m_steady_state = true;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * Back to updating the covariance and gain at each step
+     */
+    void set_dynamic() {
+      m_steady_state = false;
+    }
+
+    bool is_steady_state() const {
+      return m_steady_state;
     }
     
     void update_time() {
       using namespace la;
       
       // - Predict by linear approx X^ = AX + BU
-      state_type X_from_time; mult(X_from_time, A, X);
-      state_type X_from_input; mult(X_from_input, B, U);
-      plus(X_predicted, X_from_time, X_from_input);
+      X_predicted = A * X + B * U;
       
-      // - Predict the uncertainty: P^ = A * P * A_T + Q
-      state_transition_type AP; mult(AP, A, P);
-      typename state_transition_type::transpose_type At; transpose(At, A);
-      prob_type APAt; mult(APAt, AP, At);
-      plus(P_predicted, APAt, Q);
-      
-      // - Compute Kalman gain
-      typename meas_gain_type::transpose_type Ht; transpose(Ht, H);
-      Matrix<STATE_SIZE, MEAS_SIZE, k_real_type> PHt; mult(PHt, P_predicted, Ht);
-      Matrix<MEAS_SIZE, MEAS_SIZE, k_real_type>  HPHt; mult(HPHt, H, PHt);
-      Matrix<MEAS_SIZE, MEAS_SIZE, k_real_type> HPHt_R; plus(HPHt_R, HPHt, R);
-      Matrix<MEAS_SIZE, MEAS_SIZE, k_real_type> inv_HPHt_R; invert(inv_HPHt_R, HPHt_R);
-      mult(K, PHt, inv_HPHt_R);
+      if (!m_steady_state)
+        predict_covariance();
     }
     
     void update_measurement(const meas_type& Z) {
       using namespace la;
       // - from the measurement, calculate the innovation J = Z - H *X-
-      meas_type Z_predicted; mult(Z_predicted, H, X_predicted);
-      meas_type J; minus(J, Z, Z_predicted);
+      const meas_type J = Z - H * X_predicted;
       
       // - Given the kalman gain, estimate the state
-      state_type KInnov; mult(KInnov, K, J);
-      plus(X, X_predicted, KInnov);
+      X = X_predicted + K * J;
       
-      // - And the uncertainty as well
-      Matrix<STATE_SIZE, STATE_SIZE, k_real_type> KH; mult(KH, K, H);
-      Matrix<STATE_SIZE, STATE_SIZE, k_real_type> I_KH; minus(I_KH, I, KH);
-      mult(P, I_KH, P_predicted);
+      if (!m_steady_state)
+        update_covariance();
     }  
+
+  private:
+    void predict_covariance() {
+      using namespace la;
+
+      // - Predict the uncertainty: P^ = A * P * A_T + Q
+      P_predicted = congruence(A, P) + Q;
+      
+      // - Compute Kalman gain K = P^ * H_T * (H * P^ * H_T + R)^-1
+      PHt = P_predicted * transpose(H);
+      const Matrix<MEAS_SIZE, MEAS_SIZE, k_real_type> HPHt_R = H * PHt + R;
+      Matrix<MEAS_SIZE, MEAS_SIZE, k_real_type> inv_HPHt_R; set_zero(inv_HPHt_R);
+      if (invert(inv_HPHt_R, HPHt_R))
+        K = PHt * inv_HPHt_R;
+    }
+
+    void update_covariance() {
+      using namespace la;
+
+      // - And the uncertainty as well: (I - K * H) * P^ = P^ - K * (P^ * H_T)_T, P^ being symmetric
+      P = P_predicted - K * transpose(PHt);
+    }
+
+    static bool is_within(const kalman_gain_type& a, const kalman_gain_type& b, k_real_type tolerance) {
+      for (uint32 i = 0; i < STATE_SIZE; ++i)
+        for (uint32 j = 0; j < MEAS_SIZE; ++j)
+          if (tolerance < util::abs(a(i, j) - b(i, j)))
+            return false;
+      return true;
+    }
+
+    bool m_steady_state;
   };
 }
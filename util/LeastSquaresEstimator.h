@@ -55,8 +55,10 @@ namespace la {
     typedef Matrix<T::NB_MEAS, 1, real_type> a_type;
     typedef Matrix<T::NB_STATES, T::NB_STATES, real_type> P_type;
 
-    LeastSquaresEstimator(real_type x_variance, real_type lambda = 1)
+    LeastSquaresEstimator(real_type x_variance, real_type lambda = real_type(1))
     : m_lambda(lambda) {
+      // Starts from x = 0 unless set_state() says otherwise
+      set_zero(m_x);
       set_identity(m_P);
       mult(m_P, m_P, x_variance * 100);
     }
@@ -106,7 +108,7 @@ namespace la {
     }
     
     this_type& update(const y_type& y, const a_type& a) {
-      const real_type inv_lambda = 1 / m_lambda;
+      const real_type inv_lambda = numeric_traits<real_type>::reciprocal(m_lambda);
       
       // pp = aT*P
       typename a_type::transpose_type pp;
@@ -115,7 +117,7 @@ namespace la {
       // inv_yy = 1 / (l + (aT*P*a))
       Matrix<1, 1, real_type> yy;
       mult(yy, pp, a);
-      const real_type inv_yy = 1 / (m_lambda + yy(0, 0));
+      const real_type inv_yy = numeric_traits<real_type>::reciprocal(m_lambda + yy(0, 0));
       
       // ppt = (aT*P)T
       a_type ppt;
@@ -168,8 +170,8 @@ namespace la {
     typedef real_type y_type;
     
   public:
-    LeastSquaresScalarEstimator(real_type x_variance, real_type lambda = 1)
-    : m_lambda(lambda) {
+    LeastSquaresScalarEstimator(real_type x_variance, real_type lambda = real_type(1))
+    : m_lambda(lambda), m_x(0) {
       m_variance = x_variance * 100;
     }
     
@@ -197,7 +199,7 @@ namespace la {
      * No measurement. For a scalar constant, the factor is set to 1
      */
     void update(const y_type& y) {
-      const real_type inv_lambda = 1 / m_lambda;
+      const real_type inv_lambda = numeric_traits<real_type>::reciprocal(m_lambda);
 
       const real_type innovation = y - m_x;
       
@@ -9,13 +9,170 @@
 
 #pragma once
 #include "base.h"
+#include "Math.h"
+#include "Q.h"
 
 namespace la {
+
+  /**
+   * Arithmetic of the matrix elements.
+   * Products are accumulated in an accumulator_type before being rounded back
+   * to the element type, once per dot product.
+   */
+  template <typename T>
+  struct numeric_traits {
+    typedef T accumulator_type;
+
+    static accumulator_type zero() {
+      return T(0);
+    }
+
+    static void multiply_add(accumulator_type& acc, const T& a, const T& b) {
+      acc += a * b;
+    }
+
+    static T result(const accumulator_type& acc) {
+      return acc;
+    }
+
+    static T multiply(const T& a, const T& b) {
+      return a * b;
+    }
+
+    static T add(const T& a, const T& b) {
+      return a + b;
+    }
+
+    static T subtract(const T& a, const T& b) {
+      return a - b;
+    }
+
+    static T reciprocal(const T& a) {
+      return T(1) / a;
+    }
+
+    /**
+     * @return the smallest significant difference around 1
+     */
+    static T epsilon() {
+      return T(1e-7f);
+    }
+  };
+
+  /**
+   * 32 bit fixed point: the products are accumulated with their full 2N fractional bits
+   * on 64 bits, and the results saturate instead of wrapping around.
+   */
+  template <uint32 N>
+  struct numeric_traits<util::Q<N, int32> > {
+    typedef util::Q<N, int32> value_type;
+    typedef int64 accumulator_type;
+
+    static accumulator_type zero() {
+      return 0;
+    }
+
+    static void multiply_add(accumulator_type& acc, const value_type& a, const value_type& b) {
+      acc += static_cast<int64>(a.get_raw()) * b.get_raw();
+    }
+
+    static value_type result(const accumulator_type& acc) {
+      // Round from 0.5 up, as Q does
+      return value_type::from_raw(saturate((acc + (int64(1) << (N - 1))) >> N));
+    }
+
+    static value_type multiply(const value_type& a, const value_type& b) {
+      accumulator_type acc = zero();
+      multiply_add(acc, a, b);
+      return result(acc);
+    }
+
+    static value_type add(const value_type& a, const value_type& b) {
+      return value_type::from_raw(saturate(static_cast<int64>(a.get_raw()) + b.get_raw()));
+    }
+
+    static value_type subtract(const value_type& a, const value_type& b) {
+      return value_type::from_raw(saturate(static_cast<int64>(a.get_raw()) - b.get_raw()));
+    }
+
+    /**
+     * @return 1/a by a single division, saturated, 0 giving the largest value
+     */
+    static value_type reciprocal(const value_type& a) {
+      const int32 raw = a.get_raw();
+      if (raw == 0)
+        return value_type::max();
+      const int64 one = int64(1) << (2 * N);
+      // The division truncates towards 0 for either sign, so adding half the
+      // magnitude of the divisor rounds to nearest
+      const int64 half = raw > 0 ? raw / 2 : -(raw / 2);
+      return value_type::from_raw(saturate((one + half) / raw));
+    }
+
+    static value_type epsilon() {
+      return value_type::from_raw(1);
+    }
+
+    static int32 saturate(int64 v) {
+      if (v > util::limits<int32>::max_value)
+        return util::limits<int32>::max_value;
+      if (v < util::limits<int32>::min_value)
+        return util::limits<int32>::min_value;
+      return static_cast<int32>(v);
+    }
+  };
   
+  /**
+   * Base of the matrix expressions, statically polymorphic.
+   * Sums, differences, scalings, products and transposes of matrices are not
+   * evaluated on the spot: they build expressions, evaluated element by element
+   * straight into the matrix they are assigned to, without temporaries.
+   * Each element of a product being a dot product, the destination of a product
+   * must not appear in it, and products of products are better left to
+   * congruence() or to an intermediate matrix.
+   */
+  template <class E>
+  struct Expression {
+    const E& derived() const {
+      return static_cast<const E&>(*this);
+    }
+  };
+
+  template <uint32 R, uint32 C, typename T> class Matrix;
+
+  namespace detail {
+    /**
+     * Matrices are held by reference in expressions, expressions by value
+     */
+    template <class E>
+    struct nested {
+      typedef const E type;
+    };
+
+    template <uint32 R, uint32 C, typename T>
+    struct nested<Matrix<R, C, T> > {
+      typedef const Matrix<R, C, T>& type;
+    };
+
+    /**
+     * Evaluates an expression into a matrix, element by element unless specialized
+     */
+    template <class E>
+    struct Assign {
+      template <class M>
+      static void run(M& to, const E& e) {
+        for (uint32 i = 0; i < M::ROWS; ++i)
+          for (uint32 j = 0; j < M::COLS; ++j)
+            to(i, j) = e(i, j);
+      }
+    };
+  }
+
   template <uint32 R, uint32 C, typename T = float>
-  class Matrix {
+  class Matrix: public Expression<Matrix<R, C, T> > {
     typedef Matrix this_type;
   public:
+    typedef T value_type;
     typedef Matrix<C, R, T> transpose_type;
     
     enum {
@@ -26,10 +183,39 @@ namespace la {
     Matrix() {
     }
     
-    Matrix(const T (&a)[R][C]): m(a) {
+    Matrix(const T (&a)[R][C]) {
+      for (uint32 i = 0; i < R; ++i)
+        for (uint32 j = 0; j < C; ++j)
+          m[i][j] = a[i][j];
     }
     
-    Matrix(const this_type& other) : m(other.m) {
+    Matrix(const this_type& other) {
+      *this = other;
+    }
+
+    /**
+     * Evaluates an expression
+     */
+    template <class E>
+    Matrix(const Expression<E>& e) {
+      *this = e;
+    }
+
+    this_type& operator=(const this_type& other) {
+      for (uint32 i = 0; i < R; ++i)
+        for (uint32 j = 0; j < C; ++j)
+          m[i][j] = other.m[i][j];
+      return *this;
+    }
+
+    /**
+     * Evaluates an expression in place
+     */
+    template <class E>
+    this_type& operator=(const Expression<E>& e) {
+      typedef char size_mismatch[(int(E::ROWS) == R && int(E::COLS) == C) ? 1 : -1] __attribute__((unused));
+      detail::Assign<E>::run(*this, e.derived());
+      return *this;
     }
     
     const T& operator()(uint32 i, uint32 j) const {
@@ -43,6 +229,230 @@ namespace la {
   private:
     T m[R][C];
   };
+
+  /**
+   * Transposed view of an expression
+   */
+  template <class E>
+  class TransposeExpr: public Expression<TransposeExpr<E> > {
+  public:
+    typedef typename E::value_type value_type;
+    enum {
+      ROWS = E::COLS,
+      COLS = E::ROWS
+    };
+
+    explicit TransposeExpr(const E& e) : m_e(e) {
+    }
+
+    value_type operator()(uint32 i, uint32 j) const {
+      return m_e(j, i);
+    }
+
+  private:
+    typename detail::nested<E>::type m_e;
+  };
+
+  /**
+   * Element-wise sum (SIGN 1) or difference (SIGN -1) of two expressions
+   */
+  template <class A, class B, int SIGN>
+  class SumExpr: public Expression<SumExpr<A, B, SIGN> > {
+  public:
+    typedef typename A::value_type value_type;
+    enum {
+      ROWS = A::ROWS,
+      COLS = A::COLS
+    };
+
+    SumExpr(const A& a, const B& b) : m_a(a), m_b(b) {
+      typedef char size_mismatch[(int(A::ROWS) == int(B::ROWS) && int(A::COLS) == int(B::COLS)) ? 1 : -1] __attribute__((unused));
+    }
+
+    value_type operator()(uint32 i, uint32 j) const {
+      typedef numeric_traits<value_type> traits;
+      return SIGN > 0 ? traits::add(m_a(i, j), m_b(i, j)) : traits::subtract(m_a(i, j), m_b(i, j));
+    }
+
+    const A& lhs() const {
+      return m_a;
+    }
+
+    const B& rhs() const {
+      return m_b;
+    }
+
+  private:
+    typename detail::nested<A>::type m_a;
+    typename detail::nested<B>::type m_b;
+  };
+
+  /**
+   * Expression scaled by a scalar
+   */
+  template <class E>
+  class ScaleExpr: public Expression<ScaleExpr<E> > {
+  public:
+    typedef typename E::value_type value_type;
+    enum {
+      ROWS = E::ROWS,
+      COLS = E::COLS
+    };
+
+    ScaleExpr(const E& e, value_type scalar) : m_e(e), m_scalar(scalar) {
+    }
+
+    value_type operator()(uint32 i, uint32 j) const {
+      return numeric_traits<value_type>::multiply(m_scalar, m_e(i, j));
+    }
+
+  private:
+    typename detail::nested<E>::type m_e;
+    value_type m_scalar;
+  };
+
+  /**
+   * Matrix product of two expressions, each element computed on access
+   */
+  template <class A, class B>
+  class ProductExpr: public Expression<ProductExpr<A, B> > {
+  public:
+    typedef typename A::value_type value_type;
+    enum {
+      ROWS = A::ROWS,
+      COLS = B::COLS
+    };
+
+    ProductExpr(const A& a, const B& b) : m_a(a), m_b(b) {
+      typedef char size_mismatch[int(A::COLS) == int(B::ROWS) ? 1 : -1] __attribute__((unused));
+    }
+
+    value_type operator()(uint32 i, uint32 j) const {
+      typedef numeric_traits<value_type> traits;
+      typename traits::accumulator_type sum = traits::zero();
+      for (uint32 k = 0; k < A::COLS; ++k)
+        traits::multiply_add(sum, m_a(i, k), m_b(k, j));
+      return traits::result(sum);
+    }
+
+  private:
+    typename detail::nested<A>::type m_a;
+    typename detail::nested<B>::type m_b;
+  };
+
+  /**
+   * A.P.A^T for a symmetric P, the result being symmetric.
+   * Only evaluated on assignment, one row of A.P at a time,
+   * computing the upper triangle and mirroring it.
+   * The destination must be neither A nor P.
+   */
+  template <class A, class P>
+  class CongruenceExpr: public Expression<CongruenceExpr<A, P> > {
+  public:
+    typedef typename A::value_type value_type;
+    enum {
+      ROWS = A::ROWS,
+      COLS = A::ROWS
+    };
+
+    CongruenceExpr(const A& a, const P& p) : m_a(a), m_p(p) {
+      typedef char size_mismatch[(int(A::COLS) == int(P::ROWS) && int(P::ROWS) == int(P::COLS)) ? 1 : -1] __attribute__((unused));
+    }
+
+    /**
+     * to = A.P.A^T + offset, offset being 0 or an expression of the result size
+     */
+    template <class M, class O>
+    void evaluate(M& to, const O* offset) const {
+      typedef numeric_traits<value_type> traits;
+      const uint32 N = A::COLS;
+      for (uint32 i = 0; i < ROWS; ++i) {
+        value_type row[N];
+        for (uint32 l = 0; l < N; ++l) {
+          typename traits::accumulator_type sum = traits::zero();
+          for (uint32 k = 0; k < N; ++k)
+            traits::multiply_add(sum, m_a(i, k), m_p(k, l));
+          row[l] = traits::result(sum);
+        }
+        for (uint32 j = i; j < ROWS; ++j) {
+          typename traits::accumulator_type acc = traits::zero();
+          for (uint32 l = 0; l < N; ++l)
+            traits::multiply_add(acc, row[l], m_a(j, l));
+          const value_type sum = traits::result(acc);
+          if (offset) {
+            to(i, j) = traits::add(sum, (*offset)(i, j));
+            to(j, i) = traits::add(sum, (*offset)(j, i));
+          } else {
+            to(i, j) = sum;
+            to(j, i) = sum;
+          }
+        }
+      }
+    }
+
+  private:
+    typename detail::nested<A>::type m_a;
+    typename detail::nested<P>::type m_p;
+  };
+
+  namespace detail {
+    template <class A, class P>
+    struct Assign<CongruenceExpr<A, P> > {
+      template <class M>
+      static void run(M& to, const CongruenceExpr<A, P>& e) {
+        e.evaluate(to, static_cast<const M*>(0));
+      }
+    };
+
+    template <class A, class P, class O>
+    struct Assign<SumExpr<CongruenceExpr<A, P>, O, 1> > {
+      template <class M>
+      static void run(M& to, const SumExpr<CongruenceExpr<A, P>, O, 1>& e) {
+        e.lhs().evaluate(to, &e.rhs());
+      }
+    };
+  }
+
+  template <class A, class B>
+  SumExpr<A, B, 1> operator+(const Expression<A>& a, const Expression<B>& b) {
+    return SumExpr<A, B, 1>(a.derived(), b.derived());
+  }
+
+  template <class A, class B>
+  SumExpr<A, B, -1> operator-(const Expression<A>& a, const Expression<B>& b) {
+    return SumExpr<A, B, -1>(a.derived(), b.derived());
+  }
+
+  template <class A, class B>
+  ProductExpr<A, B> operator*(const Expression<A>& a, const Expression<B>& b) {
+    return ProductExpr<A, B>(a.derived(), b.derived());
+  }
+
+  template <class E>
+  ScaleExpr<E> operator*(const Expression<E>& e, typename E::value_type scalar) {
+    return ScaleExpr<E>(e.derived(), scalar);
+  }
+
+  template <class E>
+  ScaleExpr<E> operator*(typename E::value_type scalar, const Expression<E>& e) {
+    return ScaleExpr<E>(e.derived(), scalar);
+  }
+
+  /**
+   * @return the transposed view of an expression
+   */
+  template <class E>
+  TransposeExpr<E> transpose(const Expression<E>& e) {
+    return TransposeExpr<E>(e.derived());
+  }
+
+  /**
+   * @return a.p.a^T, p symmetric
+   */
+  template <class A, class P>
+  CongruenceExpr<A, P> congruence(const Expression<A>& a, const Expression<P>& p) {
+    return CongruenceExpr<A, P>(a.derived(), p.derived());
+  }
   
   /**
    * Resets a matrix to 0
@@ -81,7 +491,7 @@ namespace la {
   void plus(Matrix<ROWS, COLS, T>& to, const Matrix<ROWS, COLS, T>& a, const Matrix<ROWS, COLS, T>& b) {
     for (uint32 j = 0; j < COLS; ++j)
       for (uint32 i = 0; i < ROWS; ++i) {
-        to(i, j) = a(i,j) + b(i,j);
+        to(i, j) = numeric_traits<T>::add(a(i,j), b(i,j));
       }
   }
   
@@ -92,7 +502,7 @@ namespace la {
   void minus(Matrix<ROWS, COLS, T>& to, const Matrix<ROWS, COLS, T>& a, const Matrix<ROWS, COLS, T>& b) {
     for (uint32 j = 0; j < COLS; ++j)
       for (uint32 i = 0; i < ROWS; ++i) {
-        to(i, j) = a(i,j) - b(i,j);
+        to(i, j) = numeric_traits<T>::subtract(a(i,j), b(i,j));
       }
   }
   
@@ -103,7 +513,7 @@ namespace la {
   void mult(Matrix<ROWS, COLS, T>& to, const Matrix<ROWS, COLS, T>& a, T scalar) {
     for (uint32 j = 0; j < COLS; ++j)
       for (uint32 i = 0; i < ROWS; ++i) {
-        to(i, j) = scalar * a(i,j);
+        to(i, j) = numeric_traits<T>::multiply(scalar, a(i,j));
       }
   }
   
@@ -115,9 +525,10 @@ namespace la {
   void mult(Matrix<ROWS, COLS, T>& to, const Matrix<ROWS, K, T>& a, const Matrix<K, COLS, T>& b) {
     for (uint32 j = 0; j < COLS; ++j)
       for (uint32 i = 0; i < ROWS; ++i) {
-        to(i, j) = T(0);
+        typename numeric_traits<T>::accumulator_type sum = numeric_traits<T>::zero();
         for (uint32 k = 0; k < K; ++k)
-          to(i, j) += a(i, k) * b(k, j);
+          numeric_traits<T>::multiply_add(sum, a(i, k), b(k, j));
+        to(i, j) = numeric_traits<T>::result(sum);
       }
   }
   
@@ -129,9 +540,10 @@ namespace la {
   void mult_transpose(Matrix<ROWS, COLS, T>& to, const Matrix<ROWS, K, T>& a, const Matrix<COLS, K, T>& b) {
     for (uint32 j = 0; j < COLS; ++j)
       for (uint32 i = 0; i < ROWS; ++i) {
-        to(i, j) = T(0);
+        typename numeric_traits<T>::accumulator_type sum = numeric_traits<T>::zero();
         for (uint32 k = 0; k < K; ++k)
-          to(i, j) += a(i, k) * b(j, k);
+          numeric_traits<T>::multiply_add(sum, a(i, k), b(j, k));
+        to(i, j) = numeric_traits<T>::result(sum);
       }
   }
     
@@ -143,9 +555,10 @@ namespace la {
   void transpose_mult(Matrix<ROWS, COLS, T>& to, const Matrix<K, ROWS, T>& a, const Matrix<K, COLS, T>& b) {
     for (uint32 j = 0; j < COLS; ++j)
       for (uint32 i = 0; i < ROWS; ++i) {
-        to(i, j) = T(0);
+        typename numeric_traits<T>::accumulator_type sum = numeric_traits<T>::zero();
         for (uint32 k = 0; k < K; ++k)
-          to(i, j) += a(k, i) * b(k, j);
+          numeric_traits<T>::multiply_add(sum, a(k, i), b(k, j));
+        to(i, j) = numeric_traits<T>::result(sum);
       }
   }
   
@@ -166,12 +579,12 @@ namespace la {
    */
   template <typename T>
   bool invert(Matrix<1, 1, T>& to, const Matrix<1, 1, T>& a, T epsilon = T(0.00001f)) {
-    if (util::abs(a(0,0)) < epsilon) {
+    if (util::abs(a(0,0)) <= epsilon) {
       // Matrix is singular!
       return false;
     }
     
-    to(0,0) = T(1) / a(0,0);
+    to(0,0) = numeric_traits<T>::reciprocal(a(0,0));
     
     return true;
   }
@@ -181,16 +594,21 @@ namespace la {
    */
   template <typename T>
   bool invert(Matrix<2, 2, T>& to, const Matrix<2, 2, T>& a, T epsilon = T(0.00001f)) {
-    const T determinant  = a(0,0) * a(1,1) - a(1,0) * a(0,1);
+    typedef numeric_traits<T> traits;
+    typename traits::accumulator_type acc = traits::zero();
+    traits::multiply_add(acc, a(0,0), a(1,1));
+    traits::multiply_add(acc, -a(1,0), a(0,1));
+    const T determinant = traits::result(acc);
     
-    if (util::abs(determinant) < epsilon) {
+    if (util::abs(determinant) <= epsilon) {
       // Matrix is singular!
       return false;
     }
-    to(0,0) = a(1,1) / determinant;
-    to(1,0) = -a(0,1) / determinant;
-    to(0,1) = -a(1,0) / determinant;
-    to(1,1) = a(0,0) / determinant;
+    const T inv_determinant = traits::reciprocal(determinant);
+    to(0,0) = traits::multiply(a(1,1), inv_determinant);
+    to(1,0) = traits::multiply(-a(0,1), inv_determinant);
+    to(0,1) = traits::multiply(-a(1,0), inv_determinant);
+    to(1,1) = traits::multiply(a(0,0), inv_determinant);
     
     return true;
   }
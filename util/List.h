@@ -120,6 +120,25 @@ namespace util {
       m_tail = n;
     }
     
+    /**
+     * Inserts a node before another one, at the tail if that is 0
+     */
+    void insert_before(NODE* position, NODE* n) {
+      if (position == 0) {
+        add_tail(n);
+        return;
+      }
+      NODE* pred = position->m_pred;
+      n->m_pred = pred;
+      n->m_succ = position;
+      position->m_pred = n;
+      if (pred == 0) {
+        m_head = n;
+      } else {
+        pred->m_succ = n;
+      }
+    }
+    
     NODE* remove_head() {
       NODE* head = m_head;
       
@@ -150,6 +169,17 @@ namespace util {
       n->m_pred = 0;
     }
     
+    /**
+     * @return the first node, 0 if empty
+     */
+    NODE* get_head() const {
+      return m_head;
+    }
+    
+    bool is_empty() const {
+      return m_head == 0;
+    }
+    
     const_iterator begin() const {
       return const_iterator(m_head); 
     }
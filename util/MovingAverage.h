@@ -10,10 +10,32 @@
 #pragma once
 
 #include "base.h"
+#include "type_ops.h"
 
 namespace util {
+  namespace moving_average_detail {
+    /**
+     * Default type of the running sum: integers are widened so that a full
+     * window cannot overflow, other types keep their own
+     */
+    template <typename T> struct accumulator { typedef T type; };
+    template <> struct accumulator<int8> { typedef int32 type; };
+    template <> struct accumulator<uint8> { typedef uint32 type; };
+    template <> struct accumulator<int16> { typedef int32 type; };
+    template <> struct accumulator<uint16> { typedef uint32 type; };
+    template <> struct accumulator<int32> { typedef int64 type; };
+    template <> struct accumulator<uint32> { typedef uint64 type; };
+  }
   
-  template <typename T, uint32 MAX_CAPACITY>
+  /**
+   * Average of the last capacity values, kept as a running sum so that
+   * both adding a value and getting the average take constant time.
+   * Floating point sums are recomputed once per capacity values,
+   * so that rounding errors do not accumulate.
+   * The sum is kept as an ACC, which must hold MAX_CAPACITY values. For
+   * util::Q values, a Q with more integer bits may be needed.
+   */
+  template <typename T, uint32 MAX_CAPACITY, typename ACC = typename moving_average_detail::accumulator<T>::type>
   class MovingAverage {
   public:
     explicit MovingAverage(uint32 capacity = MAX_CAPACITY)
@@ -53,12 +75,18 @@ namespace util {
      * Adds a value
      */
     void add_value(const T value) {
+      if (m_empty_slots > 0)
+        --m_empty_slots;
+      else
+        m_sum -= m_values[m_put_index];
+      m_sum += value;
       m_values[m_put_index++] = value;
       
-      if (m_put_index == m_capacity)
+      if (m_put_index == m_capacity) {
         m_put_index = 0;
-      if (m_empty_slots > 0)
-        --m_empty_slots;
+        if (is_floating_point<T>::value)
+          resync();
+      }
     }
     
     /**
@@ -67,12 +95,16 @@ namespace util {
     template <typename V>
     V get_average() const {
       V temp = V(0);
-      
-      const uint32 size = get_size();
-      for (uint32 i = 0; i < size; ++i) {
-        temp += m_values[i];
-      }
-      return temp / size;
+      temp += m_sum;
+      // A signed division, even for negative sums
+      return temp / static_cast<int32>(get_size());
+    }
+
+    /**
+     * @return the sum of the stored samples
+     */
+    ACC get_sum() const {
+      return m_sum;
     }
     
     /**
@@ -81,12 +113,26 @@ namespace util {
     void reset() {
       m_empty_slots = m_capacity;
       m_put_index = 0;
+      m_sum = ACC(0);
     }
     
   private:
+    /**
+     * Exact sum of the stored samples
+     */
+    void resync() {
+      ACC sum = ACC(0);
+      const uint32 size = get_size();
+      for (uint32 i = 0; i < size; ++i) {
+        sum += m_values[i];
+      }
+      m_sum = sum;
+    }
+
     uint32 m_capacity;
     uint32 m_empty_slots;
     uint32 m_put_index;
+    ACC m_sum;
     T m_values[MAX_CAPACITY];
   };
 }
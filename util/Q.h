@@ -9,6 +9,8 @@
 #pragma once
 
 #include "base.h"
+#include "BitOps.h"
+#include "type_ops.h"
 
 namespace util {
   
@@ -118,6 +120,17 @@ namespace util {
       return static_cast<float>(m_value) / (1<<N);
     }
 
+    /**
+     * @return the underlying fixed point value, for kernels working on it directly
+     */
+    storage_type get_raw() const {
+      return m_value;
+    }
+
+    static Q<N, T> from_raw(storage_type raw_value) {
+      return Q<N, T>(raw_value, false);
+    }
+
     Q<N, T> frac() const {
       return Q<N, T>(m_value & Mask<N-1, 0>::ones, false);
     }
@@ -163,7 +176,7 @@ namespace util {
     template<uint32 M, typename U> friend Q<M, U>& operator +=(Q<M, U>& a, const Q<M, U>& b);
     template<uint32 M, typename U> friend Q<M, U>& operator -=(Q<M, U>& a, const Q<M, U>& b);
     template<uint32 M, typename U> friend Q<M, U>& operator *=(Q<M, U>& a, const Q<M, U>& b);
-    template<uint32 M, typename U> friend Q<M, U>* operator /=(Q<M, U>& a, const Q<M, U>& b);
+    template<uint32 M, typename U> friend Q<M, U>& operator /=(Q<M, U>& a, const Q<M, U>& b);
     
     template<uint32 M, typename U> friend Q<M, U> operator +(const Q<M, U>& a, int32 b);
     template<uint32 M, typename U> friend Q<M, U> operator -(const Q<M, U>& a, int32 b);
@@ -295,7 +308,7 @@ namespace util {
   Q<N, T>& operator /=(Q<N, T>& a, const Q<N, T>& b) {
     typedef typename extend<T>::type promo_t;
     // Scale and round up
-    const promo_t tmp = static_cast<promo_t>(a.m_value << N) + (b.m_value / 2);
+    const promo_t tmp = (static_cast<promo_t>(a.m_value) << N) + (b.m_value / 2);
     a.m_value = static_cast<T>(tmp / b.m_value);
     return a;
   }
@@ -309,7 +322,7 @@ namespace util {
   }
   template<uint32 N, typename T>
   Q<N, T> operator +(int32 a, const Q<N, T>& b) {
-    return Q<N, T>( (b << N) + b.m_value , false);
+    return Q<N, T>( (a << N) + b.m_value , false);
   }
   
   /**
@@ -16,30 +16,47 @@ namespace util {
   
   SHA1 & SHA1::process(const value_type* data, size_type dataSize)
   {
-    size_type dataOffset = 0;
+    m_input_size += dataSize;
     
-    while (dataOffset < dataSize)
+    //
+    // Complete a partial chunk left over by a previous call
+    //
+    if (m_chunk_offset)
     {
-      m_chunk_8[m_chunk_offset++] = data[dataOffset++];
-      m_input_size ++;
-      
-      if (m_chunk_offset == CHUNK_SIZE_8)
+      while (dataSize && m_chunk_offset < CHUNK_SIZE_8)
       {
-        process_chunk();
-        m_chunk_offset = 0;
+        m_chunk_8[m_chunk_offset++] = *data++;
+        --dataSize;
       }
+      
+      if (m_chunk_offset < CHUNK_SIZE_8)
+        return *this;
+      
+      process_block(m_chunk_8);
+      m_chunk_offset = 0;
+    }
+    
+    //
+    // Full blocks are hashed in place, without copying
+    //
+    while (dataSize >= CHUNK_SIZE_8)
+    {
+      process_block(data);
+      data += CHUNK_SIZE_8;
+      dataSize -= CHUNK_SIZE_8;
+    }
+    
+    //
+    // Keep the tail for later
+    //
+    while (dataSize--)
+    {
+      m_chunk_8[m_chunk_offset++] = *data++;
     }
     
     return *this;
   }
   
-  void SHA1::process_chunk()
-  {
-    convert_chunk_to_host_endian();
-    extend_chunk_from_16_to_80_values();
-    calculate_chunk_hash();
-  }
-  
   SHA1::Result SHA1::get_result()
   {
     //
@@ -73,7 +90,7 @@ namespace util {
         m_chunk_8[m_chunk_offset++] = 0;
       }	
       
-      process_chunk();
+      process_block(m_chunk_8);
       m_chunk_offset = 0;
     }
     
@@ -96,78 +113,75 @@ namespace util {
     m_chunk_8[m_chunk_offset++] = (original_input_size >> 8) & 0xff;
     m_chunk_8[m_chunk_offset++] = (original_input_size >> 0) & 0xff;
     
-    process_chunk();
+    process_block(m_chunk_8);
     
     return m_state;
   }
   
-  void SHA1::convert_chunk_to_host_endian()
+  //
+  // The message schedule is kept in a rolling window of 16 words:
+  // w[i] for i >= 16 overwrites w[i-16], which is no longer needed.
+  //
+  static inline
+  uint32 schedule(uint32* w, uint32 i)
   {
-    for (uint32 i = 0; i < CHUNK_SIZE_32; ++i)
-      m_chunk_32[i] = to_host_order(m_chunk_32[i]);
+    const uint32 tmp = w[(i - 3) & 15] ^ w[(i - 8) & 15] ^ w[(i - 14) & 15] ^ w[i & 15];
+    return w[i & 15] = rol(tmp, 1);
   }
   
-  void SHA1::extend_chunk_from_16_to_80_values()
+#define SHA1_ROUND(f, k, wi) \
+  do { \
+    const uint32 temp = rol(a, 5) + (f) + e + (k) + (wi); \
+    e = d; \
+    d = c; \
+    c = rol(b, 30); \
+    b = a; \
+    a = temp; \
+  } while (0)
+  
+  void SHA1::process_block(const value_type* block)
   {
+    uint32 w[CHUNK_SIZE_32];
+    
     //
-    // We assume a complete chunk here
+    // Load the block as big endian words
     //
-    for (uint32 i = CHUNK_SIZE_32; i < EXTENDED_CHUNK_SIZE_32; ++i)
+    if ((reinterpret_cast<unsigned long>(block) & 3) == 0)
     {
-      uint32 tmp = m_chunk_32[i-3] ^ m_chunk_32[i-8] ^ m_chunk_32[i-14] ^ m_chunk_32[i-16];
-      m_chunk_32[i] = rol(tmp, 1);
+      const uint32* block_32 = reinterpret_cast<const uint32*>(block);
+      for (uint32 i = 0; i < CHUNK_SIZE_32; ++i)
+        w[i] = to_host_order(block_32[i]);
     }
-  }
-  
-  void SHA1::calculate_chunk_hash()
-  {
+    else
+    {
+      for (uint32 i = 0; i < CHUNK_SIZE_32; ++i, block += 4)
+        w[i] = (uint32(block[0]) << 24) | (uint32(block[1]) << 16) | (uint32(block[2]) << 8) | block[3];
+    }
+    
     uint32 a = m_state.h0, 
     b = m_state.h1, 
     c = m_state.h2, 
     d = m_state.h3, 
     e = m_state.h4;
-        
-    uint32 temp;
     
-    for (uint32 i = 0; i < EXTENDED_CHUNK_SIZE_32; ++i)
-    {
-      uint32 k, f;
-      
-      if (i < 20)
-      {
-        f = (b & c) | ((~b) & d);
-        k = K0;
-      }			
-      else if (i < 40)
-      {
-        f = b ^ c ^ d;
-        k = K1;
-      }			
-      else if (i < 60)
-      {
-        f = (b & c) | (b & d) | (c & d);
-        k = K2;
-      }
-      else
-      {
-        f = b ^ c ^ d;
-        k = K3;
-      }
-      
-      temp = rol(a, 5);
-      temp += f + e + k + m_chunk_32[i];
-      e = d;
-      d = c;
-      c = rol(b, 30);
-      b = a;
-      a = temp;
-    }
+    uint32 i = 0;
+    for (; i < 16; ++i)
+      SHA1_ROUND(d ^ (b & (c ^ d)), K0, w[i]);
+    for (; i < 20; ++i)
+      SHA1_ROUND(d ^ (b & (c ^ d)), K0, schedule(w, i));
+    for (; i < 40; ++i)
+      SHA1_ROUND(b ^ c ^ d, K1, schedule(w, i));
+    for (; i < 60; ++i)
+      SHA1_ROUND((b & c) | (d & (b | c)), K2, schedule(w, i));
+    for (; i < 80; ++i)
+      SHA1_ROUND(b ^ c ^ d, K3, schedule(w, i));
     
     m_state.h0 += a;
     m_state.h1 += b;
     m_state.h2 += c;
     m_state.h3 += d;
     m_state.h4 += e;
-  }  
+  }
+  
+#undef SHA1_ROUND
 }
-
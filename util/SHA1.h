@@ -100,6 +100,17 @@ namespace util {
     
     typedef Result result_type;
     
+    /**
+     * The hash state on a block boundary, which can be saved and restored later
+     */
+    struct Midstate
+    {
+      Result state;
+      size_type input_size;
+    };
+    
+    typedef Midstate midstate_type;
+    
     SHA1() {
       reset();
     }
@@ -129,6 +140,27 @@ namespace util {
       m_state.h4 = H4;
     }
     
+    /**
+     * Saves the current state.
+     * Only meaningful on a block boundary, that is when a multiple of BYTE_BLOCK_SIZE bytes
+     * has been processed.
+     */
+    void get_midstate(midstate_type& midstate) const
+    {
+      midstate.state = m_state;
+      midstate.input_size = m_input_size;
+    }
+    
+    /**
+     * Restores a state saved by get_midstate(), forgetting any ongoing operation
+     */
+    void set_midstate(const midstate_type& midstate)
+    {
+      m_input_size = midstate.input_size;
+      m_chunk_offset = 0;
+      m_state = midstate.state;
+    }
+    
     /**
      * @returns the number of bytes processed so far
      */
@@ -150,25 +182,25 @@ namespace util {
     K3 = 0xCA62C1D6;
     
     static const uint32 CHUNK_SIZE_32 = 16;
-    static const uint32 EXTENDED_CHUNK_SIZE_32 = 80;
     static const uint32 CHUNK_SIZE_8 = CHUNK_SIZE_32 * 4;
     
     /**
-     * process_chunk assumes we have a complete chunk in m_chunk
+     * Compresses one complete 64 byte block into m_state.
+     * The block may come straight from the caller's memory, and need not be aligned.
      */
-    void process_chunk();
-    void convert_chunk_to_host_endian();
-    void extend_chunk_from_16_to_80_values();
-    void calculate_chunk_hash();
+    void process_block(const value_type* block);
     
     size_type m_input_size;
     uint32 m_chunk_offset;
     
     Result m_state;
     
+    /**
+     * Only holds a partial block between calls to process()
+     */
     union
     {
-      uint32 m_chunk_32[EXTENDED_CHUNK_SIZE_32];
+      uint32 m_chunk_32[CHUNK_SIZE_32];
       value_type m_chunk_8[CHUNK_SIZE_8];
     };
   };
@@ -0,0 +1,212 @@
+/*
+ *  SequentialKalman.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+#pragma once
+
+#include "base.h"
+#include "LinearAlgebra.h"
+
+namespace la {
+  /**
+   * A kalman filter with the same Traits and members as la::Kalman, that inverts no matrix.
+   * The measurements are taken to be independent, R diagonal (its off diagonal
+   * terms are ignored), and are processed one scalar at a time (Bierman).
+   * The covariance is kept factored as P = U.D.U^T, U unit upper triangular
+   * and D diagonal, which keeps it symmetric and positive, and is propagated
+   * by modified weighted Gram-Schmidt (Thornton).
+   *
+   * P and Q are factored on the first update_time() after construction or reset():
+   * call reset() after changing either. P is recomputed from its factors after each
+   * measurement update; K holds, column by column, the gain of each scalar measurement.
+   * Unlike la::Kalman, P_predicted is not provided.
+   *
+   * It inverts no matrix but is not division free: each step takes STATE_SIZE
+   * reciprocals for the time update and STATE_SIZE + 1 per measurement, one for
+   * each partial innovation variance of Bierman's update. They cannot be shared
+   * through one reciprocal of their product, which would overflow fixed point types.
+   * la::Kalman only inverts HPHt + R, one division for a single measurement: for a
+   * single measurement and soft float, it is the faster one (13 against 1 division
+   * for 6 states), and this filter is worth its cost where la::Kalman loses its
+   * symmetry or positivity, with fixed point types or ill conditioned covariances.
+   */
+  template <class Traits>
+  class SequentialKalman {
+  public:
+    typedef typename Traits::value_type k_real_type;
+    enum {
+      STATE_SIZE = Traits::state_size,
+      MEAS_SIZE = Traits::meas_size,
+      INPUT_SIZE = Traits::input_size
+    };
+
+    typedef la::Matrix<STATE_SIZE, 1, k_real_type> state_type;
+    typedef la::Matrix<STATE_SIZE, STATE_SIZE, k_real_type> state_transition_type;
+    typedef la::Matrix<INPUT_SIZE, 1, k_real_type> input_type;
+    typedef la::Matrix<STATE_SIZE, INPUT_SIZE, k_real_type> input_to_state_type;
+    typedef la::Matrix<MEAS_SIZE, 1, k_real_type> meas_type;
+    typedef la::Matrix<MEAS_SIZE, STATE_SIZE, k_real_type> meas_gain_type;
+    typedef la::Matrix<STATE_SIZE, STATE_SIZE, k_real_type> process_noise_covariance_type;
+    typedef la::Matrix<MEAS_SIZE, MEAS_SIZE, k_real_type> meas_noise_covariance_type;
+    typedef la::Matrix<STATE_SIZE, STATE_SIZE, k_real_type> prob_type;
+    typedef la::Matrix<STATE_SIZE, MEAS_SIZE, k_real_type> kalman_gain_type;
+
+    state_type X;
+    state_transition_type A;
+    input_type U;
+    input_to_state_type B;
+    meas_gain_type H;
+    process_noise_covariance_type Q;
+    meas_noise_covariance_type R;
+    prob_type P;
+
+    state_type X_predicted;
+    kalman_gain_type K;
+
+    SequentialKalman() {
+      reset();
+    }
+
+    /**
+     * Has P and Q factored again on the next update_time()
+     */
+    void reset() {
+      m_factored = false;
+    }
+
+    void update_time() {
+      if (!m_factored) {
+        factor(m_u, m_d, P);
+        factor(m_q_u, m_q_d, Q);
+        m_factored = true;
+      }
+
+      // - Predict by linear approx X^ = AX + BU
+      X_predicted = A * X + B * U;
+
+      // - Predict the uncertainty: U^.D^.U^_T = W.Dw.W_T, W = [A.U Uq], Dw = diag(D, Dq)
+      m_w_left = A * m_u;
+      m_w_right = m_q_u;
+      m_w_d = m_d;
+      for (uint32 j = STATE_SIZE; j-- > 0;) {
+        // Row j weighted by Dw
+        k_real_type wd_left[STATE_SIZE];
+        k_real_type wd_right[STATE_SIZE];
+        k_real_type d = k_real_type(0);
+        for (uint32 k = 0; k < STATE_SIZE; ++k) {
+          wd_left[k] = m_w_left(j, k) * m_w_d(k, 0);
+          wd_right[k] = m_w_right(j, k) * m_q_d(k, 0);
+          d += m_w_left(j, k) * wd_left[k];
+          d += m_w_right(j, k) * wd_right[k];
+        }
+        m_d(j, 0) = d;
+        const k_real_type inv_d = d == k_real_type(0) ? k_real_type(0) : numeric_traits<k_real_type>::reciprocal(d);
+        for (uint32 i = 0; i < j; ++i) {
+          k_real_type s = k_real_type(0);
+          for (uint32 k = 0; k < STATE_SIZE; ++k) {
+            s += m_w_left(i, k) * wd_left[k];
+            s += m_w_right(i, k) * wd_right[k];
+          }
+          const k_real_type u = s * inv_d;
+          m_u(i, j) = u;
+          // - W_i -= u.W_j
+          for (uint32 k = 0; k < STATE_SIZE; ++k) {
+            m_w_left(i, k) -= u * m_w_left(j, k);
+            m_w_right(i, k) -= u * m_w_right(j, k);
+          }
+        }
+      }
+    }
+
+    void update_measurement(const meas_type& Z) {
+      X = X_predicted;
+      for (uint32 m = 0; m < MEAS_SIZE; ++m) {
+        // - f = U_T.h, v = D.f
+        k_real_type f[STATE_SIZE];
+        k_real_type v[STATE_SIZE];
+        k_real_type innovation = Z(m, 0);
+        for (uint32 j = 0; j < STATE_SIZE; ++j) {
+          k_real_type s = H(m, j);
+          for (uint32 i = 0; i < j; ++i)
+            s += m_u(i, j) * H(m, i);
+          f[j] = s;
+          v[j] = m_d(j, 0) * s;
+          innovation -= H(m, j) * X(j, 0);
+        }
+
+        // - Bierman's update of U and D, the unscaled gain accumulated in K
+        k_real_type alpha = R(m, m);
+        k_real_type inv_alpha = numeric_traits<k_real_type>::reciprocal(alpha);
+        for (uint32 j = 0; j < STATE_SIZE; ++j) {
+          const k_real_type alpha_prev = alpha;
+          const k_real_type inv_alpha_prev = inv_alpha;
+          alpha += f[j] * v[j];
+          inv_alpha = numeric_traits<k_real_type>::reciprocal(alpha);
+          m_d(j, 0) = m_d(j, 0) * alpha_prev * inv_alpha;
+          const k_real_type p = -f[j] * inv_alpha_prev;
+          K(j, m) = v[j];
+          for (uint32 i = 0; i < j; ++i) {
+            const k_real_type u = m_u(i, j);
+            m_u(i, j) = u + K(i, m) * p;
+            K(i, m) += u * v[j];
+          }
+        }
+
+        // - Estimate the state from this measurement
+        for (uint32 j = 0; j < STATE_SIZE; ++j) {
+          K(j, m) = K(j, m) * inv_alpha;
+          X(j, 0) += K(j, m) * innovation;
+        }
+      }
+
+      // - P = U.D.U_T
+      for (uint32 i = 0; i < STATE_SIZE; ++i) {
+        k_real_type ud[STATE_SIZE];
+        for (uint32 k = i; k < STATE_SIZE; ++k)
+          ud[k] = m_u(i, k) * m_d(k, 0);
+        for (uint32 j = i; j < STATE_SIZE; ++j) {
+          k_real_type s = k_real_type(0);
+          for (uint32 k = j; k < STATE_SIZE; ++k)
+            s += ud[k] * m_u(j, k);
+          P(i, j) = s;
+          P(j, i) = s;
+        }
+      }
+    }
+
+  private:
+    typedef la::Matrix<STATE_SIZE, 1, k_real_type> diagonal_type;
+
+    /**
+     * Factors a symmetric matrix as u.d.u^T, u unit upper triangular
+     */
+    static void factor(prob_type& u, diagonal_type& d, const prob_type& p) {
+      for (uint32 j = STATE_SIZE; j-- > 0;) {
+        k_real_type dj = p(j, j);
+        for (uint32 k = j + 1; k < STATE_SIZE; ++k)
+          dj -= u(j, k) * u(j, k) * d(k, 0);
+        d(j, 0) = dj;
+        u(j, j) = k_real_type(1);
+        for (uint32 i = 0; i < j; ++i) {
+          u(j, i) = k_real_type(0);
+          k_real_type s = p(i, j);
+          for (uint32 k = j + 1; k < STATE_SIZE; ++k)
+            s -= u(i, k) * u(j, k) * d(k, 0);
+          u(i, j) = dj == k_real_type(0) ? k_real_type(0) : s / dj;
+        }
+      }
+    }
+
+    bool m_factored;
+    prob_type m_u;
+    diagonal_type m_d;
+    prob_type m_q_u;
+    diagonal_type m_q_d;
+    prob_type m_w_left;   // W = [A.U Uq], reduced in place
+    prob_type m_w_right;
+    diagonal_type m_w_d;  // D before the time update
+  };
+}
@@ -0,0 +1,155 @@
+/*
+ *  SlidingDFT.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "base.h"
+#include "Fourier.h"
+
+namespace util {
+  /**
+   * DFT bins over the last WINDOW samples, updated at each sample at a cost of
+   * one complex rotation per bin. Unlike Goertzel, a fresh result is available
+   * after every sample, at the expense of a WINDOW samples delay line.
+   * Bins are exact when WINDOW divides SineLUT::SIZE.
+   *
+   * The rotations are not exact, so the bins are also computed directly from
+   * the delay line, one term per sample as the samples come in, and replaced by
+   * that direct DFT at the end of each window. Rounding errors then never build
+   * up beyond one window, and every sample costs the same, which matters when
+   * fed from an interrupt (see hal::ADC::feed).
+   */
+  template <typename T, uint32 NB_BINS, uint32 WINDOW>
+  class SlidingDFT: NoCopy {
+  public:
+    typedef SlidingDFT<T, NB_BINS, WINDOW> this_type;
+    typedef T value_type;
+
+    SlidingDFT() {
+      for (uint32 i = 0; i < NB_BINS; ++i) {
+        m_k[i] = 0;
+        m_cos[i] = T(1);
+        m_sin[i] = T(0);
+      }
+      reset();
+    }
+
+    /**
+     * Sets a bin to the frequency k * sample_rate / WINDOW
+     */
+    this_type& set_bin(uint32 bin, uint32 k) {
+      const uint32 a = k * SineLUT::SIZE / WINDOW;
+      m_k[bin] = k;
+      m_cos[bin] = fourier_traits<T>::twiddle(fourier_detail::cosine(a));
+      m_sin[bin] = fourier_traits<T>::twiddle(fourier_detail::sine(a));
+
+      // Catch up with the direct DFT of the samples already in this window
+      m_direct_re[bin] = T(0);
+      m_direct_im[bin] = T(0);
+      m_phase[bin] = 0;
+      for (uint32 m = 0; m < m_index; ++m)
+        add_direct_term(bin, m_window[m]);
+      return *this;
+    }
+
+    /**
+     * Empties the window
+     */
+    void reset() {
+      for (uint32 i = 0; i < WINDOW; ++i)
+        m_window[i] = T(0);
+      for (uint32 i = 0; i < NB_BINS; ++i) {
+        m_re[i] = T(0);
+        m_im[i] = T(0);
+        m_direct_re[i] = T(0);
+        m_direct_im[i] = T(0);
+        m_phase[i] = 0;
+      }
+      m_index = 0;
+    }
+
+    /**
+     * Processes the next sample
+     */
+    void add_sample(const T& x) {
+      const T delta = x - m_window[m_index];
+      m_window[m_index] = x;
+      for (uint32 i = 0; i < NB_BINS; ++i)
+        add_direct_term(i, x);
+      if (++m_index == WINDOW) {
+        m_index = 0;
+        resync();
+        return;
+      }
+
+      // X[k] = (X[k] + x[n] - x[n - WINDOW]) * e^(2*PI*j*k/WINDOW)
+      for (uint32 i = 0; i < NB_BINS; ++i) {
+        const T re = m_re[i] + delta;
+        const T im = m_im[i];
+        m_re[i] = re * m_cos[i] - im * m_sin[i];
+        m_im[i] = re * m_sin[i] + im * m_cos[i];
+      }
+    }
+
+    /**
+     * @return the power of a bin, |X[k]|^2 / WINDOW^2, that is a quarter of
+     *         the squared amplitude for a sine at the bin frequency
+     */
+    T get_power(uint32 bin) const {
+      const T re = m_re[bin] / static_cast<int32>(WINDOW);
+      const T im = m_im[bin] / static_cast<int32>(WINDOW);
+      return re * re + im * im;
+    }
+
+    T get_real(uint32 bin) const {
+      return m_re[bin];
+    }
+
+    T get_imaginary(uint32 bin) const {
+      return m_im[bin];
+    }
+
+  private:
+    /**
+     * Adds the term of the sample at m_index to the direct DFT of a bin,
+     * x[m] * e^(-2*PI*j*k*m/WINDOW)
+     */
+    void add_direct_term(uint32 bin, const T& x) {
+      const uint32 a = m_phase[bin] * SineLUT::SIZE / WINDOW;
+      m_direct_re[bin] += x * fourier_traits<T>::twiddle(fourier_detail::cosine(a));
+      m_direct_im[bin] -= x * fourier_traits<T>::twiddle(fourier_detail::sine(a));
+      m_phase[bin] += m_k[bin];
+      while (m_phase[bin] >= WINDOW)
+        m_phase[bin] -= WINDOW;
+    }
+
+    /**
+     * Takes the direct DFT of the window just completed, and starts the next one
+     */
+    void resync() {
+      for (uint32 i = 0; i < NB_BINS; ++i) {
+        m_re[i] = m_direct_re[i];
+        m_im[i] = m_direct_im[i];
+        m_direct_re[i] = T(0);
+        m_direct_im[i] = T(0);
+        m_phase[i] = 0;
+      }
+    }
+
+    T m_window[WINDOW];
+    uint32 m_index;
+    uint32 m_k[NB_BINS];
+    T m_cos[NB_BINS];
+    T m_sin[NB_BINS];
+    T m_re[NB_BINS];
+    T m_im[NB_BINS];
+    T m_direct_re[NB_BINS];
+    T m_direct_im[NB_BINS];
+    uint32 m_phase[NB_BINS];  // k * m_index mod WINDOW
+  };
+}
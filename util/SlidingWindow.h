@@ -0,0 +1,320 @@
+/*
+ *  SlidingWindow.h
+ *  Embedded
+ *
+ *  Copyright 2012 Zorobo Pte Ltd. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "base.h"
+
+namespace util {
+  namespace sliding_detail {
+    template <typename T>
+    struct less {
+      static bool compare(const T& a, const T& b) {
+        return a < b;
+      }
+    };
+
+    template <typename T>
+    struct greater {
+      static bool compare(const T& a, const T& b) {
+        return b < a;
+      }
+    };
+  }
+
+  /**
+   * Extremum of the last capacity values, in amortized constant time.
+   * The candidates are kept in a monotonic deque over a fixed ring:
+   * a new value evicts from the back all those it supersedes,
+   * the front is dropped once it leaves the window.
+   * @param COMPARE sliding_detail::less for a minimum, sliding_detail::greater for a maximum
+   */
+  template <typename T, uint32 MAX_CAPACITY, class COMPARE>
+  class SlidingExtremum: NoCopy {
+  public:
+    typedef T value_type;
+    typedef uint32 size_type;
+
+    explicit SlidingExtremum(size_type capacity = MAX_CAPACITY)
+    : m_capacity(capacity) {
+      reset();
+    }
+
+    /**
+     * @return the set capacity
+     */
+    size_type get_capacity() const {
+      return m_capacity;
+    }
+
+    /**
+     * @return true if no values have been loaded
+     */
+    bool is_empty() const {
+      return m_count == 0;
+    }
+
+    /**
+     * Adds a value
+     */
+    void add_value(const T value) {
+      while (m_size > 0 && !COMPARE::compare(m_values[back()], value)) {
+        --m_size;
+      }
+
+      // Drop the front leaving the window first, so that at most capacity values are held
+      if (m_size > 0 && m_count - m_indices[m_front] >= m_capacity) {
+        m_front = next(m_front);
+        --m_size;
+      }
+
+      const size_type slot = m_size > 0 ? next(back()) : m_front;
+      m_values[slot] = value;
+      m_indices[slot] = m_count;
+      ++m_size;
+      ++m_count;
+    }
+
+    /**
+     * @return the extremum of the stored values, undefined if empty
+     */
+    T get_value() const {
+      return m_values[m_front];
+    }
+
+    /**
+     * reset state save the capacity
+     */
+    void reset() {
+      m_front = 0;
+      m_size = 0;
+      m_count = 0;
+    }
+
+  private:
+    size_type back() const {
+      const size_type b = m_front + m_size - 1;
+      return b >= MAX_CAPACITY ? b - MAX_CAPACITY : b;
+    }
+
+    static size_type next(size_type slot) {
+      return slot + 1 == MAX_CAPACITY ? 0 : slot + 1;
+    }
+
+    size_type m_capacity;
+    size_type m_front;
+    size_type m_size;
+    uint32 m_count;  // values added, wraps harmlessly
+    T m_values[MAX_CAPACITY];
+    uint32 m_indices[MAX_CAPACITY];
+  };
+
+  /**
+   * Minimum of the last capacity values
+   */
+  template <typename T, uint32 MAX_CAPACITY>
+  class SlidingMin: public SlidingExtremum<T, MAX_CAPACITY, sliding_detail::less<T> > {
+  public:
+    explicit SlidingMin(uint32 capacity = MAX_CAPACITY)
+    : SlidingExtremum<T, MAX_CAPACITY, sliding_detail::less<T> >(capacity) {
+    }
+  };
+
+  /**
+   * Maximum of the last capacity values
+   */
+  template <typename T, uint32 MAX_CAPACITY>
+  class SlidingMax: public SlidingExtremum<T, MAX_CAPACITY, sliding_detail::greater<T> > {
+  public:
+    explicit SlidingMax(uint32 capacity = MAX_CAPACITY)
+    : SlidingExtremum<T, MAX_CAPACITY, sliding_detail::greater<T> >(capacity) {
+    }
+  };
+
+  /**
+   * Median of the last capacity values, in logarithmic time per value.
+   * The values are split around the median between a max heap of the lower ones
+   * and a min heap of the upper ones, both laid out in a single array:
+   * heap position 0 is the median, negative positions the max heap,
+   * positive positions the min heap. Each ring slot knows its heap position,
+   * so that the value it replaces is sifted in place.
+   */
+  template <typename T, uint32 MAX_CAPACITY>
+  class SlidingMedian: NoCopy {
+  public:
+    typedef T value_type;
+    typedef uint32 size_type;
+
+    explicit SlidingMedian(size_type capacity = MAX_CAPACITY)
+    : m_capacity(capacity), m_center(capacity / 2) {
+      reset();
+    }
+
+    /**
+     * @return the set capacity
+     */
+    size_type get_capacity() const {
+      return m_capacity;
+    }
+
+    /**
+     * @return the number of stored values
+     */
+    size_type get_size() const {
+      return m_size;
+    }
+
+    /**
+     * @return true if no values have been loaded
+     */
+    bool is_empty() const {
+      return m_size == 0;
+    }
+
+    /**
+     * Adds a value
+     */
+    void add_value(const T value) {
+      const bool is_new = m_size < m_capacity;
+      const int32 p = m_position[m_put_index];
+      const T old = m_values[m_put_index];
+      m_values[m_put_index] = value;
+      if (++m_put_index == m_capacity)
+        m_put_index = 0;
+      if (is_new)
+        ++m_size;
+
+      if (p > 0) {
+        if (!is_new && old < value)
+          min_sort_down(p * 2);
+        else if (min_sort_up(p))
+          max_sort_down(-1);
+      } else if (p < 0) {
+        if (!is_new && value < old)
+          max_sort_down(p * 2);
+        else if (max_sort_up(p))
+          min_sort_down(1);
+      } else {
+        if (max_count() > 0)
+          max_sort_down(-1);
+        if (min_count() > 0)
+          min_sort_down(1);
+      }
+    }
+
+    /**
+     * @return the median of the stored values, the mean of the middle two for an even size,
+     * undefined if empty
+     */
+    T get_value() const {
+      const T median = at(0);
+      // A single value window has no lower middle value
+      if ((m_size & 1) || MAX_CAPACITY < 2)
+        return median;
+      return (median + at(-1)) / 2;
+    }
+
+    /**
+     * reset state save the capacity
+     */
+    void reset() {
+      m_put_index = 0;
+      m_size = 0;
+      // Slots are placed alternately in either heap, as they fill in
+      for (size_type i = 0; i < m_capacity; ++i) {
+        const int32 p = int32((i + 1) / 2) * ((i & 1) ? -1 : 1);
+        m_position[i] = p;
+        heap(p) = i;
+      }
+    }
+
+  private:
+    size_type& heap(int32 p) {
+      return m_heap[m_center + p];
+    }
+
+    const T& at(int32 p) const {
+      return m_values[m_heap[m_center + p]];
+    }
+
+    int32 min_count() const {
+      return int32(m_size - 1) / 2;
+    }
+
+    int32 max_count() const {
+      return int32(m_size) / 2;
+    }
+
+    /**
+     * Swaps the values at heap positions i and j if the one at i is less
+     * @return true if swapped
+     */
+    bool exchange_if_less(int32 i, int32 j) {
+      if (!(at(i) < at(j)))
+        return false;
+      const size_type t = heap(i);
+      heap(i) = heap(j);
+      heap(j) = t;
+      m_position[heap(i)] = i;
+      m_position[heap(j)] = j;
+      return true;
+    }
+
+    /**
+     * Restores the min heap from position i, a child, down
+     */
+    void min_sort_down(int32 i) {
+      for (const int32 count = min_count(); i <= count; i *= 2) {
+        if (i > 1 && i < count && at(i + 1) < at(i))
+          ++i;
+        if (!exchange_if_less(i, i / 2))
+          break;
+      }
+    }
+
+    /**
+     * Restores the max heap from position i, a child, down
+     */
+    void max_sort_down(int32 i) {
+      for (const int32 count = max_count(); i >= -count; i *= 2) {
+        if (i < -1 && i > -count && at(i) < at(i - 1))
+          --i;
+        if (!exchange_if_less(i / 2, i))
+          break;
+      }
+    }
+
+    /**
+     * Moves position i up the min heap
+     * @return true if it became the median
+     */
+    bool min_sort_up(int32 i) {
+      while (i > 0 && exchange_if_less(i, i / 2))
+        i /= 2;
+      return i == 0;
+    }
+
+    /**
+     * Moves position i up the max heap
+     * @return true if it became the median
+     */
+    bool max_sort_up(int32 i) {
+      while (i < 0 && exchange_if_less(i / 2, i))
+        i /= 2;
+      return i == 0;
+    }
+
+    size_type m_capacity;
+    size_type m_center;
+    size_type m_put_index;
+    size_type m_size;
+    T m_values[MAX_CAPACITY];
+    int32 m_position[MAX_CAPACITY];  // heap position of each ring slot
+    size_type m_heap[MAX_CAPACITY];  // ring slot at each heap position, offset by m_center
+  };
+}
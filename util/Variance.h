@@ -9,29 +9,102 @@
 
 #pragma once
 #include "base.h"
+#include "Q.h"
+#include "Sqrt.h"
 
 namespace util {
   
   /**
    * Determines the variance of data.
    * Algo taken from http://en.wikipedia.org/wiki/Algorithms_for_calculating_variance
+   * The third central moment is kept alongside for the skewness.
+   * Accumulators over separate data, e.g. filled in interrupt context or by
+   * separate threads, are combined with merge() (Chan et al. parallel algorithm).
    */
   template <typename T>
   class Variance {
   public:
-    Variance() : n(0), mean(0), m2(0) {      
+    Variance() : n(0), mean(0), m2(0), m3(0), min_value(0), max_value(0) {      
     }
     
     void reset() {
       n = 0;
-      mean = m2 = T(0);
+      mean = m2 = m3 = T(0);
+      min_value = max_value = T(0);
     }
     
     void add_data(T x) {
-      ++n;
+      update_range(x);
+      const uint32 n1 = n++;
       const T delta = x - mean;
-      mean += delta / n;
-      m2 += delta * (x - mean);
+      const T delta_n = delta / n;
+      const T term = delta * delta_n * n1;
+      mean += delta_n;
+      m3 += term * delta_n * (int32(n) - 2) - delta_n * m2 * 3;
+      m2 += term;
+    }
+
+    /**
+     * Adds a block of data: the block moments are taken about the block mean,
+     * with a single division, then merged in.
+     */
+    void add_block(const T* x, uint32 size) {
+      if (size == 0)
+        return;
+
+      Variance block;
+      T sum = T(0);
+      block.min_value = block.max_value = x[0];
+      for (uint32 i = 0; i < size; ++i) {
+        sum += x[i];
+        if (x[i] < block.min_value)
+          block.min_value = x[i];
+        if (block.max_value < x[i])
+          block.max_value = x[i];
+      }
+      block.n = size;
+      block.mean = sum / size;
+
+      T s2 = T(0);
+      T s3 = T(0);
+      for (uint32 i = 0; i < size; ++i) {
+        const T d = x[i] - block.mean;
+        const T d2 = d * d;
+        s2 += d2;
+        s3 += d2 * d;
+      }
+      block.m2 = s2;
+      block.m3 = s3;
+      merge(block);
+    }
+
+    /**
+     * Combines the statistics of other data into this one
+     */
+    void merge(const Variance& other) {
+      if (other.n == 0)
+        return;
+      if (n == 0) {
+        *this = other;
+        return;
+      }
+
+      const uint32 na = n;
+      const uint32 nb = other.n;
+      n = na + nb;
+      const T delta = other.mean - mean;
+      const T delta_n = delta / n;
+      const T term = delta * delta_n * na * nb;   // delta^2 * na * nb / n
+
+      m3 += other.m3 + term * delta_n * (T(na) - T(nb))
+        + delta_n * (other.m2 * na - m2 * nb) * 3;
+      m2 += other.m2 + term;
+      mean += delta_n * nb;
+
+      if (other.min_value < min_value)
+        min_value = other.min_value;
+      if (max_value < other.max_value)
+        max_value = other.max_value;
     }
     
     T get_mean() const {
@@ -43,14 +116,61 @@ namespace util {
       const T variance = m2 / (n - 1);
       return variance;
     }
+
+    /**
+     * @return the sample skewness, m3 / m2^(3/2) * sqrt(n), 0 without spread
+     */
+    float get_skewness() const {
+      const float f2 = to_float(m2);
+      if (!(f2 > 0))
+        return 0;
+      return to_float(m3) * approx_sqrt(float(n)) / (f2 * approx_sqrt(f2));
+    }
+
+    /**
+     * @return the smallest value added, 0 if none
+     */
+    T get_min() const {
+      return min_value;
+    }
+
+    /**
+     * @return the largest value added, 0 if none
+     */
+    T get_max() const {
+      return max_value;
+    }
     
     uint32 get_sample_size() const {
       return n;
     }
     
   private:
+    void update_range(T x) {
+      if (n == 0) {
+        min_value = max_value = x;
+      } else if (x < min_value) {
+        min_value = x;
+      } else if (max_value < x) {
+        max_value = x;
+      }
+    }
+
+    template <typename V>
+    static float to_float(const V& v) {
+      return static_cast<float>(v);
+    }
+
+    template <uint32 N, typename U>
+    static float to_float(const Q<N, U>& v) {
+      return v.to_float();
+    }
+
     uint32 n;
     T mean;
     T m2;
+    T m3;
+    T min_value;
+    T max_value;
   };
 }
@@ -175,13 +175,13 @@ namespace util {
   template <>
   struct z_min<uint64> {static const uint64 value = 0;};
   template <>
-  struct z_min<int8> {static const uint8 value = 0xff;};
+  struct z_min<int8> {static const uint8 value = 0x80;};
   template <>
-  struct z_min<int16> {static const uint16 value = 0xffff;};
+  struct z_min<int16> {static const uint16 value = 0x8000;};
   template <>
-  struct z_min<int32> {static const uint32 value = 0xffffffffl;};
+  struct z_min<int32> {static const uint32 value = 0x80000000ul;};
   template <>
-  struct z_min<int64> {static const uint64 value = 0xffffffffffffffffll;};
+  struct z_min<int64> {static const uint64 value = 0x8000000000000000ull;};
   template <typename T>
   struct type_min: public z_min<typename remove_volatile_const<T>::type> {};
   